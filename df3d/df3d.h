@@ -5,6 +5,7 @@
 #include <df3d/lib/memory/Allocator.h>
 #include <df3d/lib/assert/Assert.h>
 #include <df3d/lib/containers/ConcurrentQueue.h>
+#include <df3d/lib/containers/BoundedConcurrentQueue.h>
 #include <df3d/lib/containers/PodArray.h>
 #include <df3d/lib/os/PlatformFile.h>
 #include <df3d/lib/os/PlatformStorage.h>
@@ -54,6 +55,7 @@
 #include <df3d/engine/resources/ResourceManager.h>
 #include <df3d/engine/resources/ResourceDataSource.h>
 #include <df3d/engine/resources/ResourceFileSystem.h>
+#include <df3d/engine/resources/PackedArchiveFileSystem.h>
 #include <df3d/engine/resources/EntityResource.h>
 
 #include <df3d/engine/gui/GuiManager.h>
@@ -15,12 +15,9 @@ namespace df3d {
 
 void AnimatedMeshComponentProcessor::update()
 {
-    auto &sceneGr = m_world.sceneGraph();
-
     auto dt = svc().timer().getFrameDelta(df3d::TIME_CHANNEL_GAME);
     for (auto &compData : m_data.rawData())
     {
-        compData.holderWorldTransform = sceneGr.getWorldTransform(compData.holder);
         if (compData.animating)
         {
             compData.timer += dt;
@@ -88,6 +85,15 @@ void AnimatedMeshComponentProcessor::drawNode(AnimatedMeshNode *node, RenderQueu
 
 void AnimatedMeshComponentProcessor::draw(RenderQueue *ops)
 {
+    // This is a user processor, it's updated before the scene graph. So pick up
+    // the changed transforms here, the scene graph isn't modified while drawing.
+    auto &sceneGr = m_world.sceneGraph();
+    for (auto e : sceneGr.getChangedEntities())
+    {
+        if (m_data.contains(e))
+            m_data.getData(e).holderWorldTransform = sceneGr.getWorldTransform(e);
+    }
+
     for (auto &compData : m_data.rawData())
         drawNode(compData.root.get(), ops, compData, compData.holderWorldTransform.combined);
 }
@@ -32,6 +32,7 @@ class AnimatedMeshComponentProcessor : public EntityComponentProcessor
 
     void update() override;
     void draw(RenderQueue *ops) override;
+    bool supportsParallelDraw() const override { return true; }
 
 public:
     AnimatedMeshComponentProcessor(World &world);
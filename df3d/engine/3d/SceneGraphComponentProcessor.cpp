@@ -3,6 +3,8 @@
 #include <LinearMath/btTransform.h>
 #include <df3d/game/ComponentDataHolder.h>
 #include <df3d/game/World.h>
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/memory/FrameAllocator.h>
 #include <df3d/engine/physics/PhysicsHelpers.h>
 #include <df3d/engine/physics/PhysicsComponentProcessor.h>
 #include <df3d/lib/math/MathUtils.h>
@@ -11,47 +13,133 @@
 
 namespace df3d {
 
-void SceneGraphComponentProcessor::updateWorldTransformation(Data &component)
+namespace {
+
+void CombineTransforms(const Transform &parentWTransform, const Transform &myLTransform, Transform &myWTransform)
 {
-    updateLocalTransform(component);
+    myWTransform.combined = parentWTransform.combined * myLTransform.combined; // tr = parent * me
 
-    if (component.parent.isValid())
+    myWTransform.position = glm::vec3(myWTransform.combined[3]);
+    myWTransform.orientation = parentWTransform.orientation * myLTransform.orientation;
+    myWTransform.scaling.x = parentWTransform.scaling.x * myLTransform.scaling.x;
+    myWTransform.scaling.y = parentWTransform.scaling.y * myLTransform.scaling.y;
+    myWTransform.scaling.z = parentWTransform.scaling.z * myLTransform.scaling.z;
+}
+
+}
+
+void SceneGraphComponentProcessor::markDirty(Data &component)
+{
+    if (!component.dirty)
     {
-        auto &myWTransform = component.wTransform;
-        const auto &myLTransform = component.lTransform;
-        const auto &parentWTransform = m_data.getData(component.parent).wTransform;
+        component.dirty = true;
+        m_dirty.push_back(component.holder);
+    }
+}
 
-        myWTransform.combined = parentWTransform.combined * myLTransform.combined; // tr = parent * me
+void SceneGraphComponentProcessor::rebuildOrder()
+{
+    const auto &rawData = m_data.rawData();
+
+    PodArray<uint32_t> depths(MemoryManager::allocFrame(), rawData.size(), 0);
+    uint32_t maxDepth = 0;
+    for (size_t i = 0; i < rawData.size(); i++)
+    {
+        uint32_t depth = 0;
+        for (auto parent = rawData[i].parent; parent.isValid(); parent = m_data.getData(parent).parent)
+            depth++;
 
-        component.wTransform.position = glm::vec3(component.wTransform.combined[3]);
-        component.wTransform.orientation = parentWTransform.orientation * myLTransform.orientation;
-        component.wTransform.scaling.x = parentWTransform.scaling.x * myLTransform.scaling.x;
-        component.wTransform.scaling.y = parentWTransform.scaling.y * myLTransform.scaling.y;
-        component.wTransform.scaling.z = parentWTransform.scaling.z * myLTransform.scaling.z;
+        depths[i] = depth;
+        maxDepth = std::max(maxDepth, depth);
     }
-    else
+
+    // Counting sort by depth, keeps the order stable.
+    PodArray<uint32_t> offsets(MemoryManager::allocFrame(), maxDepth + 2, 0);
+    for (auto depth : depths)
+        offsets[depth + 1]++;
+    for (size_t i = 1; i < offsets.size(); i++)
+        offsets[i] += offsets[i - 1];
+
+    m_order.resize(rawData.size());
+    for (size_t i = 0; i < rawData.size(); i++)
     {
-        component.wTransform = component.lTransform;
+        const auto &parent = rawData[i].parent;
+
+        OrderEntry entry;
+        entry.idx = i;
+        entry.parentIdx = parent.isValid() ? m_data.getIndex(parent) : std::numeric_limits<uint32_t>::max();
+
+        m_order[offsets[depths[i]]++] = entry;
     }
 
-    updateChildren(component);
+    m_orderDirty = false;
 }
 
 void SceneGraphComponentProcessor::updateLocalTransform(Data &component)
 {
-    if (component.localTransformDirty)
-    {
-        // Scale -> Rotation -> Translation
-        auto &lTransform = component.lTransform;
-        lTransform.combined = glm::translate(lTransform.position) * glm::toMat4(lTransform.orientation) * glm::scale(lTransform.scaling);
-        component.localTransformDirty = false;
-    }
+    // Scale -> Rotation -> Translation
+    auto &lTransform = component.lTransform;
+    lTransform.combined = glm::translate(lTransform.position) * glm::toMat4(lTransform.orientation) * glm::scale(lTransform.scaling);
 }
 
-void SceneGraphComponentProcessor::updateChildren(Data &component)
+bool SceneGraphComponentProcessor::isStale(const Data &component) const
 {
-    for (auto child : component.children)
-        updateWorldTransformation(m_data.getData(child));
+    if (component.dirty)
+        return true;
+    if (component.parent.isValid())
+        return isStale(m_data.getData(component.parent));
+    return false;
+}
+
+Transform SceneGraphComponentProcessor::resolveWorldTransform(const Data &component) const
+{
+    // Fast path, everything has been updated.
+    if (m_dirty.empty() || !isStale(component))
+        return component.wTransform;
+
+    if (!component.parent.isValid())
+        return component.lTransform;
+
+    // Compute along the parents chain without touching the cached values, update() does it.
+    Transform result;
+    CombineTransforms(resolveWorldTransform(m_data.getData(component.parent)), component.lTransform, result);
+
+    return result;
+}
+
+void SceneGraphComponentProcessor::update()
+{
+    m_changed.clear();
+
+    if (m_dirty.empty())
+        return;
+
+    if (m_orderDirty)
+        rebuildOrder();
+
+    auto &rawData = m_data.rawData();
+    m_updatedFlags.assign(rawData.size(), 0);
+
+    // Single pass, a parent is always recomputed before its children.
+    for (const auto &entry : m_order)
+    {
+        auto &component = rawData[entry.idx];
+        const bool hasParent = entry.parentIdx != std::numeric_limits<uint32_t>::max();
+
+        if (!component.dirty && !(hasParent && m_updatedFlags[entry.parentIdx]))
+            continue;
+
+        if (hasParent)
+            CombineTransforms(rawData[entry.parentIdx].wTransform, component.lTransform, component.wTransform);
+        else
+            component.wTransform = component.lTransform;
+
+        component.dirty = false;
+        m_updatedFlags[entry.idx] = 1;
+        m_changed.push_back(component.holder);
+    }
+
+    m_dirty.clear();
 }
 
 SceneGraphComponentProcessor::SceneGraphComponentProcessor(World &world)
@@ -70,9 +158,8 @@ void SceneGraphComponentProcessor::setPosition(Entity e, const glm::vec3 &newPos
     auto &compData = m_data.getData(e);
 
     compData.lTransform.position = newPosition;
-    compData.localTransformDirty = true;
-
-    updateWorldTransformation(compData);
+    updateLocalTransform(compData);
+    markDirty(compData);
     if (m_world.physics().has(e))
         m_world.physics().teleportPosition(e, newPosition);
 }
@@ -82,9 +169,8 @@ void SceneGraphComponentProcessor::setScale(Entity e, const glm::vec3 &newScale)
     auto &compData = m_data.getData(e);
 
     compData.lTransform.scaling = newScale;
-    compData.localTransformDirty = true;
-
-    updateWorldTransformation(compData);
+    updateLocalTransform(compData);
+    markDirty(compData);
 }
 
 void SceneGraphComponentProcessor::setScale(Entity e, float uniform)
@@ -97,9 +183,8 @@ void SceneGraphComponentProcessor::setOrientation(Entity e, const glm::quat &new
     auto &compData = m_data.getData(e);
 
     compData.lTransform.orientation = newOrientation;
-    compData.localTransformDirty = true;
-
-    updateWorldTransformation(compData);
+    updateLocalTransform(compData);
+    markDirty(compData);
 
     if (m_world.physics().has(e))
         m_world.physics().teleportOrientation(e, newOrientation);
@@ -110,6 +195,32 @@ void SceneGraphComponentProcessor::setOrientation(Entity e, const glm::vec3 &eul
     setOrientation(e, glm::quat(glm::radians(eulerAngles)));
 }
 
+void SceneGraphComponentProcessor::setLocalTransform(Entity e, const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale)
+{
+    setLocalTransform(&e, 1, position, orientation, scale);
+}
+
+void SceneGraphComponentProcessor::setLocalTransform(const Entity *entities, size_t count, const glm::vec3 &position,
+                                                     const glm::quat &orientation, const glm::vec3 &scale)
+{
+    Transform lTransform;
+    lTransform.position = position;
+    lTransform.orientation = orientation;
+    lTransform.scaling = scale;
+    lTransform.combined = glm::translate(position) * glm::toMat4(orientation) * glm::scale(scale);
+
+    // Entities of a batch are not contiguous in m_data, so each still needs its lookup.
+    for (size_t i = 0; i < count; i++)
+    {
+        auto &compData = m_data.getData(entities[i]);
+
+        compData.lTransform = lTransform;
+        markDirty(compData);
+    }
+
+    m_world.physics().teleport(entities, count, position, orientation);
+}
+
 void SceneGraphComponentProcessor::setWorldTransform(Entity e, const btTransform &worldTrans)
 {
     auto &compData = m_data.getData(e);
@@ -124,9 +235,8 @@ void SceneGraphComponentProcessor::setWorldTransform(Entity e, const btTransform
     compData.wTransform.position = PhysicsHelpers::btToGlm(worldTrans.getOrigin());
     compData.wTransform.scaling = compData.lTransform.scaling;
     compData.lTransform = compData.wTransform;
-    compData.localTransformDirty = false;
 
-    updateWorldTransformation(compData);
+    markDirty(compData);
 }
 
 void SceneGraphComponentProcessor::translate(Entity e, const glm::vec3 &v)
@@ -134,11 +244,10 @@ void SceneGraphComponentProcessor::translate(Entity e, const glm::vec3 &v)
     auto &compData = m_data.getData(e);
 
     compData.lTransform.position += v;
-    compData.localTransformDirty = true;
-
-    updateWorldTransformation(compData);
+    updateLocalTransform(compData);
+    markDirty(compData);
     if (m_world.physics().has(e))
-        m_world.physics().teleportPosition(e, compData.wTransform.position);
+        m_world.physics().teleportPosition(e, getWorldPosition(e));
 }
 
 void SceneGraphComponentProcessor::scale(Entity e, const glm::vec3 &v)
@@ -146,9 +255,8 @@ void SceneGraphComponentProcessor::scale(Entity e, const glm::vec3 &v)
     auto &compData = m_data.getData(e);
 
     compData.lTransform.scaling *= v;
-    compData.localTransformDirty = true;
-
-    updateWorldTransformation(compData);
+    updateLocalTransform(compData);
+    markDirty(compData);
 }
 
 void SceneGraphComponentProcessor::scale(Entity e, float uniform)
@@ -178,9 +286,8 @@ void SceneGraphComponentProcessor::rotateAxis(Entity e, float angle, const glm::
 
     auto &compData = m_data.getData(e);
     compData.lTransform.orientation = q * compData.lTransform.orientation;
-    compData.localTransformDirty = true;
-
-    updateWorldTransformation(compData);
+    updateLocalTransform(compData);
+    markDirty(compData);
 
     if (m_world.physics().has(e))
         m_world.physics().teleportOrientation(e, compData.lTransform.orientation);
@@ -228,19 +335,17 @@ Entity SceneGraphComponentProcessor::getByName(Entity parent, df3d::Id name) con
 
 glm::vec3 SceneGraphComponentProcessor::getWorldPosition(Entity e) const
 {
-    return m_data.getData(e).wTransform.position;
+    return resolveWorldTransform(m_data.getData(e)).position;
 }
 
 glm::quat SceneGraphComponentProcessor::getWorldOrientation(Entity e) const
 {
-    return m_data.getData(e).wTransform.orientation;
+    return resolveWorldTransform(m_data.getData(e)).orientation;
 }
 
 glm::vec3 SceneGraphComponentProcessor::getWorldRotation(Entity e) const
 {
-    const auto &compData = m_data.getData(e);
-
-    return glm::degrees(glm::eulerAngles(compData.wTransform.orientation));
+    return glm::degrees(glm::eulerAngles(getWorldOrientation(e)));
 }
 
 glm::vec3 SceneGraphComponentProcessor::getLocalPosition(Entity e) const
@@ -267,12 +372,12 @@ glm::vec3 SceneGraphComponentProcessor::getLocalRotation(Entity e) const
 
 glm::mat4 SceneGraphComponentProcessor::getWorldTransformMatrix(Entity e) const
 {
-    return m_data.getData(e).wTransform.combined;
+    return resolveWorldTransform(m_data.getData(e)).combined;
 }
 
 Transform SceneGraphComponentProcessor::getWorldTransform(Entity e) const
 {
-    return m_data.getData(e).wTransform;
+    return resolveWorldTransform(m_data.getData(e));
 }
 
 glm::vec3 SceneGraphComponentProcessor::getWorldDirection(Entity e) const
@@ -304,7 +409,8 @@ void SceneGraphComponentProcessor::attachChild(Entity parent, Entity child)
     parentCompData.children.push_back(child);
     childCompData.parent = parent;
 
-    updateWorldTransformation(parentCompData);
+    markDirty(childCompData);
+    m_orderDirty = true;
 }
 
 void SceneGraphComponentProcessor::attachChildren(Entity parent, const std::vector<Entity> &children)
@@ -312,13 +418,16 @@ void SceneGraphComponentProcessor::attachChildren(Entity parent, const std::vect
     for (auto c : children)
     {
         DF3D_ASSERT_MESS(!getParent(c).isValid(), "already have a parent");
-        m_data.getData(c).parent = parent;
+
+        auto &childCompData = m_data.getData(c);
+        childCompData.parent = parent;
+        markDirty(childCompData);
     }
 
     auto &parentCompData = m_data.getData(parent);
     parentCompData.children.insert(parentCompData.children.end(), children.begin(), children.end());
 
-    updateWorldTransformation(parentCompData);
+    m_orderDirty = true;
 }
 
 void SceneGraphComponentProcessor::detachChild(Entity parent, Entity child)
@@ -338,7 +447,9 @@ void SceneGraphComponentProcessor::detachChild(Entity parent, Entity child)
     DF3D_ASSERT(found != parentData.children.end());
 
     parentData.children.erase(found);
-    updateWorldTransformation(childData);
+
+    markDirty(childData);
+    m_orderDirty = true;
 }
 
 void SceneGraphComponentProcessor::detachAllChildren(Entity e)
@@ -347,11 +458,13 @@ void SceneGraphComponentProcessor::detachAllChildren(Entity e)
 
     for (auto childEnt : compData.children)
     {
-        m_data.getData(childEnt).parent = {};
-        updateWorldTransformation(m_data.getData(childEnt));
+        auto &childCompData = m_data.getData(childEnt);
+        childCompData.parent = {};
+        markDirty(childCompData);
     }
 
     compData.children.clear();
+    m_orderDirty = true;
 }
 
 Entity SceneGraphComponentProcessor::getParent(Entity e)
@@ -374,26 +487,45 @@ std::vector<Entity> SceneGraphComponentProcessor::getAll() const
 
 void SceneGraphComponentProcessor::add(Entity e)
 {
-    DF3D_ASSERT_MESS(!m_data.contains(e), "An entity already has a scene graph component");
+    add(&e, 1);
+}
 
+void SceneGraphComponentProcessor::add(const Entity *entities, size_t count)
+{
     Data data;
-    data.holder = e;
+    updateLocalTransform(data);
+
+    m_data.reserve(entities, count);
+    utils::reserve_more(m_dirty, count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        DF3D_ASSERT_MESS(!m_data.contains(entities[i]), "An entity already has a scene graph component");
 
-    m_data.add(e, data);
+        data.holder = entities[i];
+        m_data.add(entities[i], data);
 
-    updateWorldTransformation(m_data.getData(e));
+        markDirty(m_data.rawData().back());
+    }
+
+    m_orderDirty = true;
 }
 
 void SceneGraphComponentProcessor::remove(Entity e)
 {
     auto &compData = m_data.getData(e);
     for (auto child : compData.children)
-        m_data.getData(child).parent = {};
+    {
+        auto &childCompData = m_data.getData(child);
+        childCompData.parent = {};
+        markDirty(childCompData);
+    }
 
     if (compData.parent.isValid())
         detachChild(compData.parent, e);
 
     m_data.remove(e);
+    m_orderDirty = true;
 }
 
 bool SceneGraphComponentProcessor::has(Entity e)
@@ -29,17 +29,34 @@ class SceneGraphComponentProcessor : public EntityComponentProcessor
         Entity parent;
         Entity holder;
         std::vector<Entity> children;
-        bool localTransformDirty = true;
+        //! World transform of this entity and its subtree is stale.
+        bool dirty = false;
+    };
+
+    struct OrderEntry
+    {
+        uint32_t idx;
+        uint32_t parentIdx;
     };
 
     ComponentDataHolder<Data> m_data;
     World &m_world;
 
-    void updateWorldTransformation(Data &component);
+    // Entities marked dirty since the last update.
+    std::vector<Entity> m_dirty;
+    // rawData indices sorted by hierarchy depth, parents go first.
+    std::vector<OrderEntry> m_order;
+    bool m_orderDirty = true;
+    std::vector<uint8_t> m_updatedFlags;
+    std::vector<Entity> m_changed;
+
+    void markDirty(Data &component);
+    void rebuildOrder();
     void updateLocalTransform(Data &component);
-    void updateChildren(Data &component);
+    bool isStale(const Data &component) const;
+    Transform resolveWorldTransform(const Data &component) const;
 
-    void update() override { }
+    void update() override;
 
 public:
     SceneGraphComponentProcessor(World &world);
@@ -55,6 +72,10 @@ public:
     void setOrientation(Entity e, const glm::quat &newOrientation);
     //! Sets orientation using Euler angles (degrees).
     void setOrientation(Entity e, const glm::vec3 &eulerAngles);
+    //! Sets local position, orientation and scale at once.
+    void setLocalTransform(Entity e, const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale);
+    //! Same local transform for several entities, the matrix is computed once.
+    void setLocalTransform(const Entity *entities, size_t count, const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale);
     // NOTE: used by physics component processor.
     void setWorldTransform(Entity e, const btTransform &worldTrans);
 
@@ -96,7 +117,13 @@ public:
 
     std::vector<Entity> getAll() const;
 
+    //! Entities which world transform has been recomputed during the last update.
+    //! Valid until the next update, processors updated after the scene graph should use
+    //! this instead of fetching the transform of every component each frame.
+    const std::vector<Entity>& getChangedEntities() const { return m_changed; }
+
     void add(Entity e);
+    void add(const Entity *entities, size_t count);
     void remove(Entity e) override;
     bool has(Entity e) override;
 };
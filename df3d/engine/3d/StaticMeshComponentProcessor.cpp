@@ -12,6 +12,7 @@
 #include <df3d/engine/render/RenderOperation.h>
 #include <df3d/engine/render/RenderQueue.h>
 #include <df3d/lib/math/MathUtils.h>
+#include <df3d/lib/JobSystem.h>
 
 namespace df3d {
 
@@ -35,30 +36,51 @@ BoundingSphere StaticMeshComponentProcessor::getBoundingSphere(const Data &compD
     return sphere;
 }
 
+void StaticMeshComponentProcessor::updateBoundingSphere(size_t idx)
+{
+    auto sphere = getBoundingSphere(m_data.rawData()[idx]);
+    const auto &center = sphere.getCenter();
+
+    m_spheres.x[idx] = center.x;
+    m_spheres.y[idx] = center.y;
+    m_spheres.z[idx] = center.z;
+    m_spheres.r[idx] = sphere.getRadius();
+}
+
 void StaticMeshComponentProcessor::update()
 {
     auto &sceneGr = m_world.sceneGraph();
 
-    // TODO: get only changed components.
     // Update the transform component.
-    for (auto &compData : m_data.rawData())
-        compData.holderWorldTransform = sceneGr.getWorldTransform(compData.holder);
+    for (auto e : sceneGr.getChangedEntities())
+    {
+        if (!m_data.contains(e))
+            continue;
+
+        auto idx = m_data.getIndex(e);
+        m_data.rawData()[idx].holderWorldTransform = sceneGr.getWorldTransform(e);
+        updateBoundingSphere(idx);
+    }
 }
 
-void StaticMeshComponentProcessor::draw(RenderQueue *ops)
+void StaticMeshComponentProcessor::drawRange(size_t begin, size_t end, RenderQueue *ops)
 {
-    if (!m_renderingEnabled)
-        return;
+    DF3D_ASSERT(begin % 32 == 0);
+
+    m_world.getCamera()->getFrustum().cullSpheres(m_spheres.x.data() + begin, m_spheres.y.data() + begin,
+                                                  m_spheres.z.data() + begin, m_spheres.r.data() + begin,
+                                                  end - begin, m_visibility.data() + begin / 32);
 
-    const auto &frustum = m_world.getCamera()->getFrustum();
-    for (auto &compData : m_data.rawData())
+    auto &rawData = m_data.rawData();
+    for (size_t compIdx = begin; compIdx < end; compIdx++)
     {
+        auto &compData = rawData[compIdx];
         if (!compData.visible)
             continue;
 
         if (!compData.frustumCullingDisabled)
         {
-            if (!frustum.sphereInFrustum(getBoundingSphere(compData)))
+            if ((m_visibility[compIdx / 32] & (1u << (compIdx % 32))) == 0)
                 continue;
         }
 
@@ -90,8 +112,57 @@ void StaticMeshComponentProcessor::draw(RenderQueue *ops)
     }
 }
 
+void StaticMeshComponentProcessor::draw(RenderQueue *ops)
+{
+    if (!m_renderingEnabled)
+        return;
+
+    // Less than that is not worth a job.
+    const size_t MIN_CHUNK_SIZE = 256;
+
+    auto &jobs = svc().jobs();
+    const size_t count = m_data.rawData().size();
+
+    m_visibility.resize((count + 31) / 32);
+
+    size_t chunksCount = std::min(jobs.getWorkersCount() + 1, (count + MIN_CHUNK_SIZE - 1) / MIN_CHUNK_SIZE);
+    if (chunksCount <= 1)
+    {
+        drawRange(0, count, ops);
+        return;
+    }
+
+    // Chunks should not share visibility mask words.
+    const size_t chunkSize = ((count + chunksCount - 1) / chunksCount + 31) & ~(size_t)31;
+    chunksCount = (count + chunkSize - 1) / chunkSize;
+
+    while (m_chunkQueues.size() < chunksCount)
+        m_chunkQueues.push_back(make_unique<RenderQueue>());
+
+    JobCounter counter(0);
+    for (size_t i = 1; i < chunksCount; i++)
+    {
+        auto chunkOps = m_chunkQueues[i].get();
+        auto begin = i * chunkSize;
+        auto end = std::min(begin + chunkSize, count);
+
+        chunkOps->clear();
+        jobs.run([this, chunkOps, begin, end]() { drawRange(begin, end, chunkOps); }, &counter);
+    }
+
+    // First chunk goes directly to the output, the rest is appended keeping the order.
+    drawRange(0, chunkSize, ops);
+
+    jobs.wait(counter);
+
+    for (size_t i = 1; i < chunksCount; i++)
+        ops->append(*m_chunkQueues[i]);
+}
+
 StaticMeshComponentProcessor::StaticMeshComponentProcessor(World &world)
-    : m_world(world)
+    : m_spheres(MemoryManager::allocDefault()),
+    m_visibility(MemoryManager::allocDefault()),
+    m_world(world)
 {
 
 }
@@ -132,8 +203,13 @@ size_t StaticMeshComponentProcessor::getMeshPartsCount(Entity e)
 
 BoundingSphere StaticMeshComponentProcessor::getBoundingSphere(Entity e)
 {
-    // FIXME: mb cache if transformation hasn't been changed?
-    return getBoundingSphere(m_data.getData(e));
+    auto idx = m_data.getIndex(e);
+
+    BoundingSphere sphere;
+    sphere.setPosition({ m_spheres.x[idx], m_spheres.y[idx], m_spheres.z[idx] });
+    sphere.setRadius(m_spheres.r[idx]);
+
+    return sphere;
 }
 
 Id StaticMeshComponentProcessor::getMeshId(Entity e)
@@ -163,46 +239,84 @@ bool StaticMeshComponentProcessor::isVisible(Entity e)
 
 void StaticMeshComponentProcessor::add(Entity e, Id meshResource)
 {
-    DF3D_ASSERT_MESS(!m_data.contains(e), "An entity already has a static mesh component");
+    add(&e, 1, meshResource);
+}
 
+void StaticMeshComponentProcessor::add(const Entity *entities, size_t count, Id meshResource)
+{
     auto &rmgr = svc().resourceManager();
-    if (auto mesh = rmgr.getResource<MeshResource>(meshResource))
+    auto mesh = rmgr.getResource<MeshResource>(meshResource);
+    if (!mesh)
     {
-        Data data;
+        DFLOG_WARN("Failed to add static mesh to an entity. Resource '%s' is not loaded", meshResource.toString().c_str());
+        return;
+    }
 
-        data.meshResourceId = meshResource;
-        data.parts = mesh->meshParts;
-        data.materials.resize(data.parts.size());
-        data.localBoundingSphere = mesh->localBoundingSphere;
+    Data data;
 
-        if (!mesh->materialLibResourceId.empty())
-        {
-            auto materialLib = rmgr.getResource<MaterialLibResource>(mesh->materialLibResourceId);
-            DF3D_ASSERT(materialLib);
-            DF3D_ASSERT(mesh->meshParts.size() == mesh->materialNames.size());
+    data.meshResourceId = meshResource;
+    data.parts = mesh->meshParts;
+    data.materials.resize(data.parts.size());
+    data.localBoundingSphere = mesh->localBoundingSphere;
 
-            size_t idx = 0;
-            for (const auto &mtlName : mesh->materialNames)
-            {
-                auto material = materialLib->getMaterial(mtlName);
-                if (material)
-                    data.materials[idx] = *material;
-                ++idx;
-            }
+    if (!mesh->materialLibResourceId.empty())
+    {
+        auto materialLib = rmgr.getResource<MaterialLibResource>(mesh->materialLibResourceId);
+        DF3D_ASSERT(materialLib);
+        DF3D_ASSERT(mesh->meshParts.size() == mesh->materialNames.size());
+
+        size_t idx = 0;
+        for (const auto &mtlName : mesh->materialNames)
+        {
+            auto material = materialLib->getMaterial(mtlName);
+            if (material)
+                data.materials[idx] = *material;
+            ++idx;
         }
+    }
+
+    m_data.reserve(entities, count);
+
+    utils::reserve_more(m_spheres.x, count);
+    utils::reserve_more(m_spheres.y, count);
+    utils::reserve_more(m_spheres.z, count);
+    utils::reserve_more(m_spheres.r, count);
+
+    auto &sceneGraph = m_world.sceneGraph();
+    for (size_t i = 0; i < count; i++)
+    {
+        auto e = entities[i];
+        DF3D_ASSERT_MESS(!m_data.contains(e), "An entity already has a static mesh component");
 
         data.holder = e;
-        data.holderWorldTransform = m_world.sceneGraph().getWorldTransform(e);
+        data.holderWorldTransform = sceneGraph.getWorldTransform(e);
 
         m_data.add(e, data);
+
+        m_spheres.x.push_back(0.0f);
+        m_spheres.y.push_back(0.0f);
+        m_spheres.z.push_back(0.0f);
+        m_spheres.r.push_back(0.0f);
+        updateBoundingSphere(m_data.rawData().size() - 1);
     }
-    else
-        DFLOG_WARN("Failed to add static mesh to an entity. Resource '%s' is not loaded", meshResource.toString().c_str());
 }
 
 void StaticMeshComponentProcessor::remove(Entity e)
 {
+    // Mirror ComponentDataHolder swap with the last element.
+    auto idx = m_data.getIndex(e);
+
     m_data.remove(e);
+
+    m_spheres.x[idx] = m_spheres.x.back();
+    m_spheres.y[idx] = m_spheres.y.back();
+    m_spheres.z[idx] = m_spheres.z.back();
+    m_spheres.r[idx] = m_spheres.r.back();
+
+    m_spheres.x.pop_back();
+    m_spheres.y.pop_back();
+    m_spheres.z.pop_back();
+    m_spheres.r.pop_back();
 }
 
 bool StaticMeshComponentProcessor::has(Entity e)
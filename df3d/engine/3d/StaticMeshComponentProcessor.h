@@ -31,13 +31,30 @@ class StaticMeshComponentProcessor : public EntityComponentProcessor
 
     ComponentDataHolder<Data> m_data;
 
+    // World space bounding spheres for the batch culling, same order as m_data.
+    struct BoundingSpheres
+    {
+        PodArray<float> x, y, z, r;
+
+        BoundingSpheres(Allocator &alloc) : x(alloc), y(alloc), z(alloc), r(alloc) { }
+    };
+
+    BoundingSpheres m_spheres;
+    PodArray<uint32_t> m_visibility;
+
     World &m_world;
     bool m_renderingEnabled = true;
 
+    // Output of the culling jobs, merged in order.
+    std::vector<unique_ptr<RenderQueue>> m_chunkQueues;
+
     BoundingSphere getBoundingSphere(const Data &compData);
+    void updateBoundingSphere(size_t idx);
+    void drawRange(size_t begin, size_t end, RenderQueue *ops);
 
     void update() override;
     void draw(RenderQueue *ops) override;
+    bool supportsParallelDraw() const override { return true; }
 
 public:
     StaticMeshComponentProcessor(World &world);
@@ -59,6 +76,8 @@ public:
     bool isVisible(Entity e);
 
     void add(Entity e, Id meshResource);
+    //! Adds the same mesh to several entities, the resource and its materials are resolved once.
+    void add(const Entity *entities, size_t count, Id meshResource);
     void remove(Entity e) override;
     bool has(Entity e) override;
 };
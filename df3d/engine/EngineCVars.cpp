@@ -5,5 +5,6 @@ namespace df3d {
 ConfigVariableBool EngineCVars::bulletDebugDraw = { false, "bullet_dbg_draw", "Draw bullet physics debug" };
 ConfigVariableInt EngineCVars::preferredFPS = { 30, "pref_fps", "Preferred FPS" };
 ConfigVariableBool EngineCVars::objIndexize = { true, "obj_indexize", "Indexize obj meshes" };
+ConfigVariableFloat EngineCVars::objWeldEpsilon = { 0.0f, "obj_weld_epsilon", "Obj vertex attributes are quantized to this grid before welding, 0 for exact match" };
 
 }
@@ -10,6 +10,7 @@ public:
     static ConfigVariableBool bulletDebugDraw;
     static ConfigVariableInt preferredFPS;
     static ConfigVariableBool objIndexize;
+    static ConfigVariableFloat objWeldEpsilon;
 };
 
 }
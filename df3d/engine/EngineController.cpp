@@ -11,7 +11,9 @@
 #include <df3d/platform/AppDelegate.h>
 #include <df3d/engine/script/ScriptManager.h>
 #include <df3d/lib/JsonUtils.h>
+#include <df3d/lib/JobSystem.h>
 #include <df3d/lib/memory/MallocAllocator.h>
+#include <df3d/lib/memory/FrameAllocator.h>
 
 #if defined(DF3D_WINDOWS)
 #include <df3d/platform/windows/CrashHandler.h>
@@ -32,6 +34,7 @@ void EngineController::initialize(EngineInitParams params)
 #endif
 
     m_timer = make_unique<Timer>();
+    m_jobSystem = make_unique<JobSystem>(JobSystem::GetDefaultWorkersCount());
     m_systemTimeManager = make_unique<TimeManager>();
     m_resourceManager = make_unique<ResourceManager>();
     m_renderManager = make_unique<RenderManager>();
@@ -68,6 +71,8 @@ void EngineController::shutdown()
 
     m_scriptManager->shutdown();
     m_guiManager->shutdown();
+    // Unreferenced resources are destroyed while the render backend is alive.
+    m_resourceManager->purgeUnused();
     m_renderManager->shutdown();
     m_resourceManager->shutdown();
 
@@ -78,6 +83,7 @@ void EngineController::shutdown()
     m_resourceManager.reset();
     m_inputManager.reset();
     m_timer.reset();
+    m_jobSystem.reset();
 
     m_initialized = false;  // Is it safe to init it again?...
 }
@@ -89,6 +95,9 @@ void EngineController::step()
 
     m_timer->update();
 
+    // Frame before the previous one is done, reclaim its scratch memory.
+    MemoryManager::allocFrame().nextFrame();
+
     // Update some engine subsystems.
     m_guiManager->update();
     m_resourceManager->poll();
@@ -112,7 +121,7 @@ void EngineController::suspend()
     DF3D_ASSERT_MESS(m_initialized, "EngineController must be initialized");
     if (!m_suspended)
     {
-        m_resourceManager->suspend();
+        m_jobSystem->suspend();
 
         m_suspended = true;
     }
@@ -123,7 +132,7 @@ void EngineController::resume()
     DF3D_ASSERT_MESS(m_initialized, "EngineController must be initialized");
     if (m_suspended)
     {
-        m_resourceManager->resume();
+        m_jobSystem->resume();
 
         m_suspended = false;
     }
@@ -188,17 +197,39 @@ EngineController& svc()
     return g_engine;
 }
 
-Allocator *MemoryManager::m_defaultAllocator = nullptr;
+Allocator *MemoryManager::m_mallocAllocator = nullptr;
+CachingAllocator *MemoryManager::m_defaultAllocator = nullptr;
+FrameAllocator *MemoryManager::m_frameAllocator = nullptr;
+
+// Initial size of each frame allocator buffer, it grows if a frame needs more.
+static const size_t FRAME_ALLOCATOR_CAPACITY = 1024 * 1024;
 
 void MemoryManager::init()
 {
-    m_defaultAllocator = new MallocAllocator();
+    m_mallocAllocator = new MallocAllocator();
+    m_defaultAllocator = new CachingAllocator(*m_mallocAllocator);
+    m_frameAllocator = new FrameAllocator(*m_defaultAllocator, FRAME_ALLOCATOR_CAPACITY);
 }
 
 void MemoryManager::shutdown()
 {
+    delete m_frameAllocator;
+    m_frameAllocator = nullptr;
     delete m_defaultAllocator;
     m_defaultAllocator = nullptr;
+    delete m_mallocAllocator;
+    m_mallocAllocator = nullptr;
+}
+
+void MemoryManager::printStats()
+{
+    auto stats = getStats();
+
+    DFLOG_DEBUG("Memory usage:");
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        DFLOG_DEBUG("%s: %d KB in %d allocations", MemoryTagName((MemoryTag)i), int(stats.bytes[i] / 1024), int(stats.allocations[i]));
+    DFLOG_DEBUG("small blocks slabs: %d KB", int(stats.slabBytes / 1024));
+    DFLOG_DEBUG("---");
 }
 
 }
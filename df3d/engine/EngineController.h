@@ -1,6 +1,7 @@
 #pragma once
 
 #include "EngineInitParams.h"
+#include <df3d/lib/memory/CachingAllocator.h>
 
 namespace df3d {
 
@@ -11,8 +12,10 @@ class InputManager;
 class ScriptManager;
 class Timer;
 class TimeManager;
+class JobSystem;
 class World;
 class Allocator;
+class FrameAllocator;
 
 class EngineController : NonCopyable
 {
@@ -27,6 +30,7 @@ class EngineController : NonCopyable
     unique_ptr<ScriptManager> m_scriptManager;
     unique_ptr<TimeManager> m_systemTimeManager;
     unique_ptr<Timer> m_timer;
+    unique_ptr<JobSystem> m_jobSystem;
 
     unique_ptr<World> m_world;  // TODO: don't hold worlds in the engine.
 
@@ -58,6 +62,7 @@ public:
     Timer& timer() { return *m_timer; }
     TimeManager& systemTimeManager() { return *m_systemTimeManager; }
     ScriptManager& scripts() { return *m_scriptManager; }
+    JobSystem& jobs() { return *m_jobSystem; }
 
     World& defaultWorld() { return world(); }
     World& world() { return *m_world; }
@@ -73,12 +78,21 @@ EngineController& svc();
 // TODO: move from here.
 class MemoryManager
 {
-    static Allocator *m_defaultAllocator;
+    static Allocator *m_mallocAllocator;
+    static CachingAllocator *m_defaultAllocator;
+    static FrameAllocator *m_frameAllocator;
 public:
     static void init();
     static void shutdown();
 
     static Allocator& allocDefault() { return *m_defaultAllocator; }
+    //! Default allocator accounting the memory to a subsystem.
+    static Allocator& allocTagged(MemoryTag tag) { return m_defaultAllocator->getTagged(tag); }
+    //! Scratch memory valid until the end of the next frame, see FrameAllocator.
+    static FrameAllocator& allocFrame() { return *m_frameAllocator; }
+
+    static MemoryStats getStats() { return m_defaultAllocator->getStats(); }
+    static void printStats();
 };
 
 }
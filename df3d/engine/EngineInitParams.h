@@ -12,6 +12,8 @@ struct EngineInitParams
     void *hardwareData = nullptr;
 
     bool createConsole = false;
+    //! Use RenderBackendID::NULL_RECORDING backend, no graphics context is required.
+    bool headlessRender = false;
     // TODO:
     // More params
     // More rendering params
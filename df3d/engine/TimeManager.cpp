@@ -91,12 +91,14 @@ void TimeManager::unsubscribeUpdate(ITimeListener *listener)
 
 void TimeManager::enqueueForNextUpdate(UpdateFn &&callback)
 {
-    m_newListeners.push(std::move(callback));
+    if (!m_newListeners.push(std::move(callback)))
+        m_newListenersOverflow.push(std::move(callback));
 }
 
 void TimeManager::clearNextUpdateQueue()
 {
     m_newListeners.clear();
+    m_newListenersOverflow.clear();
     m_pendingListeners.clear();
 }
 
@@ -118,6 +120,8 @@ void TimeManager::update(float dt)
 
     while (m_newListeners.tryPop(worker))
         m_pendingListeners.push(std::move(worker));
+    while (m_newListenersOverflow.tryPop(worker))
+        m_pendingListeners.push(std::move(worker));
 
     // Update client code.
     for (auto &listener : m_timeListeners)
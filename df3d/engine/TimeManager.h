@@ -1,6 +1,7 @@
 #pragma once
 
 #include <df3d/lib/containers/ConcurrentQueue.h>
+#include <df3d/lib/containers/BoundedConcurrentQueue.h>
 #include <df3d/lib/Utils.h>
 #include <df3d/lib/Handles.h>
 
@@ -76,7 +77,9 @@ private:
     std::list<Action> m_actions;
 
     ConcurrentQueue<UpdateFn> m_pendingListeners;
-    ConcurrentQueue<UpdateFn> m_newListeners;
+    BoundedConcurrentQueue<UpdateFn> m_newListeners;
+    //! Used only when m_newListeners is full.
+    ConcurrentQueue<UpdateFn> m_newListenersOverflow;
 
     TimeSubscriber* findSubscriber(ITimeListener *listener);
 
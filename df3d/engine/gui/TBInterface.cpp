@@ -88,7 +88,7 @@ public:
     {
         if (!m_data)
             return nullptr;
-        return (tb::uint32*)m_data->mipLevels[0].pixels.data();
+        return (tb::uint32*)m_data->mipLevels[0].getPixels();
     }
 };
 
@@ -41,13 +41,16 @@ void ParticleSystemComponentProcessor::updateCameraPosition(Data &compData)
 
 void ParticleSystemComponentProcessor::update()
 {
-    if (m_pausedGlobal)
-        return;
-
     // Update the transform component.
     auto &sceneGr = m_world.sceneGraph();
-    for (auto &compData : m_data.rawData())
-        compData.holderTransform = sceneGr.getWorldTransformMatrix(compData.holder);
+    for (auto e : sceneGr.getChangedEntities())
+    {
+        if (m_data.contains(e))
+            m_data.getData(e).holderTransform = sceneGr.getWorldTransformMatrix(e);
+    }
+
+    if (m_pausedGlobal)
+        return;
 
     const auto dt = svc().timer().getFrameDelta(TIME_CHANNEL_GAME);
     for (auto &compData : m_data.rawData())
@@ -74,9 +77,9 @@ void ParticleSystemComponentProcessor::update()
 
 ParticleSystemComponentProcessor::ParticleSystemComponentProcessor(World &world)
     : m_world(world),
-    m_allocator(MemoryManager::allocDefault())
+    m_allocator(MemoryManager::allocTagged(MEMORY_TAG_PARTICLES))
 {
-    m_globalIndexBuffer = MAKE_NEW(MemoryManager::allocDefault(), ParticleSystemIndexBuffer);
+    m_globalIndexBuffer = MAKE_NEW(m_allocator, ParticleSystemIndexBuffer);
 
     // Clamp the step to 100 ms.
     SPK::System::setClampStep(true, 0.1f);
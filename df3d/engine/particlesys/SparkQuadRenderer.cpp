@@ -21,6 +21,7 @@ namespace {
 
 class MyRenderBuffer : public SPK::RenderBuffer
 {
+    // Staging for the group capacity, refilled every frame without touching the heap.
     Vertex_p_tx_c *m_vertexData = nullptr;
     VertexBufferHandle m_vertexBuffer;
 
@@ -37,7 +38,7 @@ public:
 
         DF3D_ASSERT_MESS(verticesCount < 0xFFFF, "Using 16-bit indices for particle system");
 
-        m_vertexData = MEMORY_ALLOC(MemoryManager::allocDefault(), Vertex_p_tx_c, verticesCount);
+        m_vertexData = MEMORY_ALLOC(MemoryManager::allocTagged(MEMORY_TAG_PARTICLES), Vertex_p_tx_c, verticesCount);
         m_vertexBuffer = svc().renderManager().getBackend().createDynamicVertexBuffer(Vertex_p_tx_c::getFormat(), verticesCount, nullptr);
 
         m_particlesAllocated = nbParticles;
@@ -45,7 +46,7 @@ public:
 
     ~MyRenderBuffer()
     {
-        MEMORY_FREE(MemoryManager::allocDefault(), m_vertexData);
+        MEMORY_FREE(MemoryManager::allocTagged(MEMORY_TAG_PARTICLES), m_vertexData);
         svc().renderManager().getBackend().destroyVertexBuffer(m_vertexBuffer);
     }
 
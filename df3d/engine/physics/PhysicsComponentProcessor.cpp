@@ -28,19 +28,6 @@ namespace df3d {
 #endif
 #endif
 
-static btStridingMeshInterface* ShallowCopyBulletMeshData(btTriangleIndexVertexArray *input, Allocator &allocator)
-{
-    auto result = MAKE_NEW(allocator, btTriangleIndexVertexArray)();
-
-    for (int i = 0; i < input->getNumSubParts(); i++)
-    {
-        const auto &part = input->getIndexedMeshArray()[i];
-        result->addIndexedMesh(part, part.m_indexType);
-    }
-
-    return result;
-}
-
 ATTRIBUTE_ALIGNED16(class) PhysicsComponentMotionState : public btMotionState
 {
     btTransform m_transform;
@@ -211,7 +198,7 @@ btCollisionShape* PhysicsComponentProcessor::createCollisionShape(Data &data, df
     }
     case CollisionShapeType::CONVEX_HULL:
     {
-        auto &points = mesh->convexHull.m_vertices;
+        auto &points = mesh->collision.getConvexHull().m_vertices;
         auto colShape = MAKE_NEW(m_allocator, btConvexHullShape)((btScalar*)points.data(), points.size());
         colShape->setLocalScaling(scale);
 
@@ -221,16 +208,26 @@ btCollisionShape* PhysicsComponentProcessor::createCollisionShape(Data &data, df
     {
         DF3D_ASSERT_MESS(params.mass == 0.0f, "body should not be dynamic");
 
-        data.meshInterface = ShallowCopyBulletMeshData(mesh->physicsMeshInterface, m_allocator);
+        data.meshInterface = mesh->collision.createMeshInterface(m_allocator);
 
-        auto colShape = MAKE_NEW(m_allocator, btBvhTriangleMeshShape)(data.meshInterface, true);
-        colShape->setLocalScaling(scale);
+        // The precomputed BVH is built for the unscaled mesh, it's shared and not owned by the shape.
+        btBvhTriangleMeshShape *colShape;
+        if (mesh->collision.bvh && (scale - btVector3(1.0f, 1.0f, 1.0f)).length2() <= SIMD_EPSILON)
+        {
+            colShape = MAKE_NEW(m_allocator, btBvhTriangleMeshShape)(data.meshInterface, true, false);
+            colShape->setOptimizedBvh(mesh->collision.bvh);
+        }
+        else
+        {
+            colShape = MAKE_NEW(m_allocator, btBvhTriangleMeshShape)(data.meshInterface, true);
+            colShape->setLocalScaling(scale);
+        }
 
         return colShape;
     }
     case CollisionShapeType::DYNAMIC_MESH:
     {
-        data.meshInterface = ShallowCopyBulletMeshData(mesh->physicsMeshInterface, m_allocator);
+        data.meshInterface = mesh->collision.createMeshInterface(m_allocator);
 
         auto colShape = MAKE_NEW(m_allocator, btGImpactMeshShape)(data.meshInterface);
         colShape->setLocalScaling(scale);
@@ -308,7 +305,7 @@ void PhysicsComponentProcessor::draw(RenderQueue *ops)
 
 PhysicsComponentProcessor::PhysicsComponentProcessor(World &w)
     : m_df3dWorld(w),
-    m_allocator(MemoryManager::allocDefault()),
+    m_allocator(MemoryManager::allocTagged(MEMORY_TAG_PHYSICS)),
     m_config(svc().getInitParams().physicsConfigPath)
 {
     //btAlignedAllocSetCustom(CustomBulletAlloc, CustomBulletFree);
@@ -460,6 +457,26 @@ void PhysicsComponentProcessor::teleportOrientation(Entity e, const glm::quat &o
     }
 }
 
+void PhysicsComponentProcessor::teleport(const Entity *entities, size_t count, const glm::vec3 &pos, const glm::quat &orient)
+{
+    btQuaternion rotation(orient.x, orient.y, orient.z, orient.w);
+    btVector3 origin = PhysicsHelpers::glmTobt(pos);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto body = getBody(entities[i]);
+        if (body)
+        {
+            auto tr = body->getWorldTransform();
+            tr.setOrigin(origin);
+            tr.setRotation(rotation);
+
+            body->setWorldTransform(tr);
+            body->setInterpolationWorldTransform(tr);
+        }
+    }
+}
+
 void PhysicsComponentProcessor::add(Entity e, const PhysicsComponentCreationParams &params, Id meshResourceId)
 {
     DF3D_ASSERT_MESS(!m_data.contains(e), "An entity already has a physics component");
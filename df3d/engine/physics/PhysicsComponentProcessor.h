@@ -95,6 +95,8 @@ public:
 
     void teleportPosition(Entity e, const glm::vec3 &pos);
     void teleportOrientation(Entity e, const glm::quat &orient);
+    //! Teleports the bodies of the given entities, the ones without a body are skipped.
+    void teleport(const Entity *entities, size_t count, const glm::vec3 &pos, const glm::quat &orient);
 
     void add(Entity e, const PhysicsComponentCreationParams &params, Id meshResourceId);
     // NOTE: body should not be added to the Physics World as it will be added via this processor.
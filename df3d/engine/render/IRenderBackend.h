@@ -11,6 +11,9 @@ struct RenderBackendCaps
 {
     int maxTextureSize = 0;
     float maxAnisotropy = 0.0f;
+    bool instancing = false;
+    //! INDICES_32_BIT index buffers, missing on some GLES 2 GPUs (Mali 400).
+    bool indices32 = false;
 };
 
 class IRenderBackend
@@ -55,6 +58,10 @@ public:
 
     virtual void setState(uint64_t state) = 0;
     virtual void draw(Topology type, uint32_t numberOfElements) = 0;
+    //! Draws currently bound geometry once per transform. The program should declare
+    //! "a_instanceWorld" attribute, see isInstancingSupported.
+    virtual void drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount) = 0;
+    virtual bool isInstancingSupported(GPUProgramHandle program) = 0;
 
     virtual void setDestroyAndroidWorkaround() = 0;
     virtual RenderBackendID getID() const = 0;
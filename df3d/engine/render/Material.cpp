@@ -131,6 +131,22 @@ float RenderPass::paramAsFloat(Id name)
     return param.value.floatVal;
 }
 
+uint32_t RenderPass::getTexturesKey() const
+{
+    // FNV-1a over texture handles.
+    uint32_t hash = 2166136261u;
+    for (const auto &param : m_params)
+    {
+        if (param.type != ValuePassParam::TEXTURE)
+            continue;
+
+        hash ^= param.value.textureHandle;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
 void Material::addTechnique(const Technique &technique)
 {
     auto found = std::find_if(m_techniques.begin(), m_techniques.end(), [&technique](const Technique &other) {
@@ -61,6 +61,9 @@ public:
 
     glm::vec4 paramAsVec4(Id name);
     float paramAsFloat(Id name);
+
+    //! Hash of the bound textures. Passes with equal keys most likely share the texture set.
+    uint32_t getTexturesKey() const;
 };
 
 struct Technique
@@ -4,15 +4,92 @@
 #include <df3d/engine/render/Vertex.h>
 #include <df3d/engine/EngineController.h>
 #include <mikktspace/mikktspace.h>
-#include <map>
 
 namespace df3d {
 
-struct CompareVertices
+static const size_t VERTEX_COMPONENTS = sizeof(Vertex_p_n_tx_tan_bitan) / sizeof(float);
+static_assert(sizeof(Vertex_p_n_tx_tan_bitan) % sizeof(float) == 0, "vertex is expected to be floats only");
+
+static const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+// Raw bits of the components or the components quantized to the weld epsilon.
+static void GetVertexKey(const Vertex_p_n_tx_tan_bitan &vertex, float invEpsilon, uint32_t *key)
+{
+    auto components = reinterpret_cast<const float *>(&vertex);
+
+    if (invEpsilon == 0.0f)
+    {
+        memcpy(key, components, sizeof(Vertex_p_n_tx_tan_bitan));
+        return;
+    }
+
+    // Clamped to the int32 range first, out of range float to int conversion is undefined.
+    // fmax also maps NaN to the lower bound.
+    const float minKey = -2147483648.0f;
+    const float maxKey = 2147483520.0f;     // Largest float below 2^31.
+    for (size_t i = 0; i < VERTEX_COMPONENTS; i++)
+    {
+        auto q = std::floor(components[i] * invEpsilon + 0.5f);
+        key[i] = (uint32_t)(int32_t)std::fmin(std::fmax(q, minKey), maxKey);
+    }
+}
+
+static uint32_t HashVertexKey(const uint32_t *key)
 {
-    bool operator()(const Vertex_p_n_tx_tan_bitan &a, const Vertex_p_n_tx_tan_bitan &b) const
+    // FNV-1a over the words with a final avalanche.
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < VERTEX_COMPONENTS; i++)
+        h = (h ^ key[i]) * 16777619u;
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    return h;
+}
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation".
+static const int FORSYTH_CACHE_SIZE = 32;
+static const int FORSYTH_MAX_VALENCE = 32;
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+class ForsythScores
+{
+    float m_cache[FORSYTH_CACHE_SIZE];
+    float m_valence[FORSYTH_MAX_VALENCE];
+
+public:
+    ForsythScores()
+    {
+        for (int i = 0; i < FORSYTH_CACHE_SIZE; i++)
+        {
+            // The last triangle vertices get a fixed score so the same triangle isn't favored.
+            if (i < 3)
+                m_cache[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+            else
+                m_cache[i] = std::pow(1.0f - (float)(i - 3) / (FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+        }
+
+        m_valence[0] = 0.0f;
+        for (int i = 1; i < FORSYTH_MAX_VALENCE; i++)
+            m_valence[i] = FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)i, -FORSYTH_VALENCE_BOOST_POWER);
+    }
+
+    float get(int cachePosition, uint32_t remainingTriangles) const
     {
-        return memcmp(&a, &b, sizeof(Vertex_p_n_tx_tan_bitan)) > 0;
+        // Nothing left to draw with this vertex.
+        if (remainingTriangles == 0)
+            return -1.0f;
+
+        float score = cachePosition >= 0 ? m_cache[cachePosition] : 0.0f;
+        if (remainingTriangles < (uint32_t)FORSYTH_MAX_VALENCE)
+            score += m_valence[remainingTriangles];
+        else
+            score += FORSYTH_VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+
+        return score;
     }
 };
 
@@ -179,43 +256,175 @@ static void CalcTangentSpaceTriangle(Vertex_p_n_tx_tan_bitan &v0, Vertex_p_n_tx_
     v2.bitangent += tdir;
 }
 
-static bool FindSimilarVertexIndex(const Vertex_p_n_tx_tan_bitan &vertex, 
-                                   const std::map<Vertex_p_n_tx_tan_bitan, uint16_t, CompareVertices> &lookup,
-                                   uint16_t &result)
+void MeshUtils::indexize(const Vertex_p_n_tx_tan_bitan *vdata, size_t count,
+                         PodArray<Vertex_p_n_tx_tan_bitan> &outVertices, PodArray<uint32_t> &outIndices,
+                         float weldEpsilon)
 {
-    auto found = lookup.find(vertex);
-    if (found != lookup.end())
+    DF3D_ASSERT(weldEpsilon >= 0.0f);
+    DF3D_ASSERT(count < EMPTY_SLOT);
+
+    const float invEpsilon = weldEpsilon > 0.0f ? 1.0f / weldEpsilon : 0.0f;
+
+    // Open addressing with linear probing, at most half full.
+    size_t tableSize = 16;
+    while (tableSize < count * 2)
+        tableSize *= 2;
+    const size_t tableMask = tableSize - 1;
+
+    std::vector<uint32_t> table(tableSize, EMPTY_SLOT);
+    // Keys of the unique vertices.
+    std::vector<uint32_t> keys;
+    keys.reserve(count * VERTEX_COMPONENTS);
+
+    outIndices.reserve(outIndices.size() + count);
+
+    uint32_t key[VERTEX_COMPONENTS];
+    const auto firstVertex = outVertices.size();
+
+    for (size_t i = 0; i < count; i++)
     {
-        result = found->second;
-        return true;
+        GetVertexKey(vdata[i], invEpsilon, key);
+
+        auto slot = HashVertexKey(key) & tableMask;
+        while (table[slot] != EMPTY_SLOT)
+        {
+            if (memcmp(&keys[table[slot] * VERTEX_COMPONENTS], key, sizeof(key)) == 0)
+                break;
+            slot = (slot + 1) & tableMask;
+        }
+
+        if (table[slot] == EMPTY_SLOT)
+        {
+            table[slot] = (uint32_t)(outVertices.size() - firstVertex);
+            keys.insert(keys.end(), key, key + VERTEX_COMPONENTS);
+            outVertices.push_back(vdata[i]);
+        }
+
+        outIndices.push_back((uint32_t)firstVertex + table[slot]);
     }
-    return false;
 }
 
-void MeshUtils::indexize(const Vertex_p_n_tx_tan_bitan *vdata, size_t count,
-                         PodArray<Vertex_p_n_tx_tan_bitan> &outVertices, PodArray<uint16_t> &outIndices)
+void MeshUtils::optimizeVertexCache(uint32_t *indices, size_t indicesCount, size_t verticesCount)
 {
-    std::map<Vertex_p_n_tx_tan_bitan, uint16_t, CompareVertices> lookup;
+    const size_t trianglesCount = indicesCount / 3;
+    if (trianglesCount == 0)
+        return;
 
-    for (size_t i = 0; i < count; i++)
+    static const ForsythScores scores;
+
+    // Triangles of every vertex, the ones not yet emitted are kept in front.
+    std::vector<uint32_t> remaining(verticesCount, 0);
+    for (size_t i = 0; i < trianglesCount * 3; i++)
+    {
+        DF3D_ASSERT(indices[i] < verticesCount);
+        remaining[indices[i]]++;
+    }
+
+    std::vector<uint32_t> offsets(verticesCount + 1, 0);
+    for (size_t i = 0; i < verticesCount; i++)
+        offsets[i + 1] = offsets[i] + remaining[i];
+
+    std::vector<uint32_t> vertexTriangles(trianglesCount * 3);
+    {
+        std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < trianglesCount * 3; i++)
+            vertexTriangles[cursors[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<int> cachePositions(verticesCount, -1);
+    std::vector<float> vertexScores(verticesCount);
+    for (size_t i = 0; i < verticesCount; i++)
+        vertexScores[i] = scores.get(-1, remaining[i]);
+
+    std::vector<float> triangleScores(trianglesCount);
+    for (size_t i = 0; i < trianglesCount; i++)
     {
-        uint16_t index;
+        auto tri = indices + i * 3;
+        triangleScores[i] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+    }
+
+    std::vector<uint8_t> emitted(trianglesCount, 0);
+    std::vector<uint32_t> result;
+    result.reserve(trianglesCount * 3);
+
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    size_t cacheSize = 0;
 
-        if (FindSimilarVertexIndex(vdata[i], lookup, index))
+    size_t nextTriangle = 0;
+    int64_t bestTriangle = -1;
+
+    for (size_t emittedCount = 0; emittedCount < trianglesCount; emittedCount++)
+    {
+        // Nothing adjacent to the cache, continue in the original order.
+        if (bestTriangle < 0)
         {
-            outIndices.push_back(index);
+            while (emitted[nextTriangle])
+                nextTriangle++;
+            bestTriangle = nextTriangle;
         }
-        else
+
+        const uint32_t *tri = indices + bestTriangle * 3;
+        emitted[bestTriangle] = 1;
+        result.insert(result.end(), tri, tri + 3);
+
+        // Degenerate triangles are listed once per occurrence of the vertex.
+        for (int i = 0; i < 3; i++)
         {
-            outVertices.push_back(vdata[i]);
+            auto v = tri[i];
+            auto begin = &vertexTriangles[offsets[v]];
+            auto end = begin + remaining[v];
+            auto found = std::find(begin, end, (uint32_t)bestTriangle);
+            DF3D_ASSERT(found != end);
+            std::swap(*found, *(end - 1));
+            remaining[v]--;
+        }
+
+        // The triangle goes to the front of the cache, the least recently used vertices fall out.
+        uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+        size_t newCacheSize = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            if (std::find(newCache, newCache + newCacheSize, tri[i]) == newCache + newCacheSize)
+                newCache[newCacheSize++] = tri[i];
+        }
+        for (size_t i = 0; i < cacheSize; i++)
+        {
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2])
+                newCache[newCacheSize++] = cache[i];
+        }
 
-            DF3D_ASSERT(outVertices.size() < 0xFFFF);
+        for (size_t i = 0; i < newCacheSize; i++)
+        {
+            auto v = newCache[i];
+            cachePositions[v] = i < (size_t)FORSYTH_CACHE_SIZE ? (int)i : -1;
+            vertexScores[v] = scores.get(cachePositions[v], remaining[v]);
+        }
 
-            auto newIdx = (uint16_t)outVertices.size() - 1;
-            outIndices.push_back(newIdx);
-            lookup[vdata[i]] = newIdx;
+        // Only the triangles of the touched vertices change their scores.
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < newCacheSize; i++)
+        {
+            auto v = newCache[i];
+            for (uint32_t j = offsets[v]; j < offsets[v] + remaining[v]; j++)
+            {
+                auto t = vertexTriangles[j];
+                auto other = indices + t * 3;
+                triangleScores[t] = vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
         }
+
+        cacheSize = std::min(newCacheSize, (size_t)FORSYTH_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheSize, cache);
     }
+
+    std::copy(result.begin(), result.end(), indices);
 }
 
 void MeshUtils::computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t count)
@@ -241,8 +450,9 @@ void MeshUtils::computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t count
         DFLOG_WARN("Failed to calculate tangent space!");
 }
 
-void MeshUtils::computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t verticesCount,
-                                    const uint16_t *indices, size_t indicesCount)
+template<typename T>
+static void ComputeTangentBasisIndexed(Vertex_p_n_tx_tan_bitan *vdata, size_t verticesCount,
+                                       const T *indices, size_t indicesCount)
 {
     for (size_t i = 0; i < indicesCount; i += 3)
     {
@@ -262,4 +472,16 @@ void MeshUtils::computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t verti
     OrthogonalizeAndFixHandedness(vdata, verticesCount);
 }
 
+void MeshUtils::computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t verticesCount,
+                                    const uint16_t *indices, size_t indicesCount)
+{
+    ComputeTangentBasisIndexed(vdata, verticesCount, indices, indicesCount);
+}
+
+void MeshUtils::computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t verticesCount,
+                                    const uint32_t *indices, size_t indicesCount)
+{
+    ComputeTangentBasisIndexed(vdata, verticesCount, indices, indicesCount);
+}
+
 }
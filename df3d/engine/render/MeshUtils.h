@@ -9,12 +9,18 @@ struct Vertex_p_n_tx_tan_bitan;
 class MeshUtils
 {
 public:
+    //! Welds equal vertices. With non zero epsilon the components are quantized to it before comparison.
     static void indexize(const Vertex_p_n_tx_tan_bitan *vdata, size_t count,
-                         PodArray<Vertex_p_n_tx_tan_bitan> &outVertices, PodArray<uint16_t> &outIndices);
+                         PodArray<Vertex_p_n_tx_tan_bitan> &outVertices, PodArray<uint32_t> &outIndices,
+                         float weldEpsilon = 0.0f);
+    //! Reorders the triangles for the post-transform vertex cache (Forsyth).
+    static void optimizeVertexCache(uint32_t *indices, size_t indicesCount, size_t verticesCount);
 
     static void computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t count);
     static void computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t verticesCount,
                                     const uint16_t *indices, size_t indicesCount);
+    static void computeTangentBasis(Vertex_p_n_tx_tan_bitan *vdata, size_t verticesCount,
+                                    const uint32_t *indices, size_t indicesCount);
 };
 
 }
@@ -144,6 +144,22 @@ struct FrameStats
 
     size_t textures = 0;
     size_t gpuMemBytes = 0;
+
+    // Redundant calls filtering. Binds are programs, buffers and textures.
+    size_t bindsIssued = 0;
+    size_t bindsSkipped = 0;
+    size_t uniformsIssued = 0;
+    size_t uniformsSkipped = 0;
+    size_t stateChangesIssued = 0;
+    size_t stateChangesSkipped = 0;
+
+    // CPU side of the frame, filled by RenderManager.
+    float collectTimeMs = 0.0f;
+    float sortTimeMs = 0.0f;
+
+    // Frame allocator usage, filled by RenderManager.
+    size_t frameMemBytes = 0;
+    size_t frameMemHighWater = 0;
 };
 
 #define LIGHTS_MAX 2
@@ -184,7 +200,8 @@ enum class SharedUniformType
 enum class RenderBackendID
 {
     GL,
-    METAL
+    METAL,
+    NULL_RECORDING
 };
 
 struct Viewport
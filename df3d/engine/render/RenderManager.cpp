@@ -2,6 +2,7 @@
 #include "RenderManager.h"
 
 #include <df3d/engine/EngineController.h>
+#include <df3d/lib/memory/FrameAllocator.h>
 #include <df3d/engine/EngineCVars.h>
 #include <df3d/engine/resources/ResourceManager.h>
 #include <df3d/engine/resources/MaterialResource.h>
@@ -31,6 +32,8 @@
 
 #endif
 
+#include <df3d/engine/render/null/RenderBackendNull.h>
+
 namespace df3d {
 
 namespace {
@@ -39,6 +42,12 @@ bool g_usingAmbientPass = true;
 
 static unique_ptr<IRenderBackend> CreateRenderBackend(const EngineInitParams &params)
 {
+    if (params.headlessRender)
+    {
+        g_usingAmbientPass = false;
+        return make_unique<RenderBackendNull>();
+    }
+
 #if DF3D_USE_METAL_BACKEND
     g_usingAmbientPass = false;
     return make_unique<RenderBackendMetal>(params);
@@ -52,7 +61,7 @@ static unique_ptr<IRenderBackend> CreateRenderBackend(const EngineInitParams &pa
 
 RenderManagerEmbedResources::RenderManagerEmbedResources(RenderManager *render)
 {
-    auto &allocator = MemoryManager::allocDefault();
+    auto &allocator = MemoryManager::allocTagged(MEMORY_TAG_RENDER);
 
     // Create white texture.
     {
@@ -72,7 +81,7 @@ RenderManagerEmbedResources::RenderManagerEmbedResources(RenderManager *render)
 
     // Load GPU programs.
     {
-        if (render->getBackendID() == RenderBackendID::GL)
+        if (render->getBackendID() != RenderBackendID::METAL)
         {
             const std::string colored_vert =
 #include "gl/embed_glsl/colored_vert.h"
@@ -123,7 +132,7 @@ RenderManagerEmbedResources::RenderManagerEmbedResources(RenderManager *render)
 
 RenderManagerEmbedResources::~RenderManagerEmbedResources()
 {
-    auto &allocator = MemoryManager::allocDefault();
+    auto &allocator = MemoryManager::allocTagged(MEMORY_TAG_RENDER);
     svc().renderManager().getBackend().destroyTexture(whiteTexture);
     svc().renderManager().getBackend().destroyGPUProgram(coloredProgram->handle);
     svc().renderManager().getBackend().destroyGPUProgram(ambientPassProgram->handle);
@@ -149,10 +158,16 @@ void RenderManager::onFrameEnd()
 
 void RenderManager::doRenderWorld(World &world)
 {
+    using namespace std::chrono;
+
+    auto collectStarted = high_resolution_clock::now();
+
     m_renderQueue->clear();
 
     world.collectRenderOperations(m_renderQueue.get());
 
+    m_collectTimeMs = duration<float, std::milli>(high_resolution_clock::now() - collectStarted).count();
+
     m_renderBackend->setViewport(m_viewport);
 
     m_sharedState->setViewPort(m_viewport);
@@ -161,7 +176,12 @@ void RenderManager::doRenderWorld(World &world)
     m_sharedState->setAmbientColor(world.getRenderingParams().getAmbientLight());
     m_sharedState->setFog(world.getRenderingParams().getFogDensity(), world.getRenderingParams().getFogColor());
 
-    m_renderQueue->sort();
+    auto sortStarted = high_resolution_clock::now();
+
+    m_renderQueue->sort(world.getCamera()->getPosition(), world.getCamera()->getDir());
+    m_renderQueue->mergeInstances();
+
+    m_sortTimeMs = duration<float, std::milli>(high_resolution_clock::now() - sortStarted).count();
 
     for (size_t i = 0; i < LIGHTS_MAX; i++)
         m_sharedState->setLight(m_renderQueue->lights[i], i);
@@ -233,6 +253,49 @@ void RenderManager::bindPass(RenderPass *pass)
     }
 }
 
+void RenderManager::drawInstancedOperation(const RenderOperation &op, RenderPass *pass)
+{
+    DF3D_ASSERT(op.instanceTransforms && op.instancesCount > 0);
+
+    if (m_renderBackend->getCaps().instancing && m_renderBackend->isInstancingSupported(pass->program->handle))
+    {
+        // Shader applies a_instanceWorld on top of shared matrices.
+        m_sharedState->setWorldMatrix(glm::mat4(1.0f));
+        bindPass(pass);
+
+        m_renderBackend->bindVertexBuffer(op.vertexBuffer, op.startVertex);
+        if (op.indexBuffer.isValid())
+            m_renderBackend->bindIndexBuffer(op.indexBuffer);
+
+        m_renderBackend->drawInstanced(op.topology, op.numberOfElements, op.instanceTransforms, op.instancesCount);
+    }
+    else
+    {
+        // Fallback: bind the pass and the geometry once, update only world dependent uniforms per instance.
+        // No u_instanceWorld[] uniform array batching: GLES2 has no gl_InstanceID, so it would need
+        // every mesh duplicated per batch slot with an instance index stream. See TODO.
+        for (uint32_t i = 0; i < op.instancesCount; i++)
+        {
+            m_sharedState->setWorldMatrix(op.instanceTransforms[i]);
+
+            if (i == 0)
+            {
+                bindPass(pass);
+
+                m_renderBackend->bindVertexBuffer(op.vertexBuffer, op.startVertex);
+                if (op.indexBuffer.isValid())
+                    m_renderBackend->bindIndexBuffer(op.indexBuffer);
+            }
+            else
+            {
+                m_sharedState->updateSharedUniforms(*pass->program);
+            }
+
+            m_renderBackend->draw(op.topology, op.numberOfElements);
+        }
+    }
+}
+
 void RenderManager::render2D()
 {
     m_sharedState->setProjectionMatrix(glm::ortho(0.0f, (float)m_viewport.width, (float)m_viewport.height, 0.0f));
@@ -302,6 +365,12 @@ void RenderManager::drawRenderOperation(const RenderOperation &op, RenderPass *p
         return;
     }
 
+    if (op.instancesCount > 0)
+    {
+        drawInstancedOperation(op, passPropsOverride ? passPropsOverride : op.passProps);
+        return;
+    }
+
     m_sharedState->setWorldMatrix(op.worldTransform);
     bindPass(passPropsOverride ? passPropsOverride : op.passProps);
 
@@ -314,9 +383,17 @@ void RenderManager::drawRenderOperation(const RenderOperation &op, RenderPass *p
 
 FrameStats RenderManager::getFrameStats() const
 {
+    FrameStats stats;
     if (m_renderBackend)
-        return m_renderBackend->getLastFrameStats();
-    return {};
+        stats = m_renderBackend->getLastFrameStats();
+
+    stats.collectTimeMs = m_collectTimeMs;
+    stats.sortTimeMs = m_sortTimeMs;
+
+    stats.frameMemBytes = MemoryManager::allocFrame().getLastFrameBytes();
+    stats.frameMemHighWater = MemoryManager::allocFrame().getHighWaterMark();
+
+    return stats;
 }
 
 IRenderBackend& RenderManager::getBackend()
@@ -44,11 +44,15 @@ class RenderManager : NonCopyable
     bool m_initialized = false;
     unique_ptr<RenderManagerEmbedResources> m_embedResources;
 
+    float m_collectTimeMs = 0.0f;
+    float m_sortTimeMs = 0.0f;
+
     void onFrameBegin();
     void onFrameEnd();
     void doRenderWorld(World &world);
 
     void bindPass(RenderPass *pass);
+    void drawInstancedOperation(const RenderOperation &op, RenderPass *pass);
 
     void render2D();
 
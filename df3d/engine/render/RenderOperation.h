@@ -24,6 +24,13 @@ public:
     uint32_t numberOfElements = 0;
 
     float z = 0.0f;
+
+    //! Per-instance world transforms if this operation is an instanced batch. worldTransform is ignored then.
+    const glm::mat4 *instanceTransforms = nullptr;
+    uint32_t instancesCount = 0;
+
+    //! Packed key used by the render queue to order operations. Filled in RenderQueue::sort.
+    uint64_t sortKey = 0;
 };
 
 }
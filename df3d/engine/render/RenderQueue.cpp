@@ -1,30 +1,220 @@
 #include "RenderQueue.h"
 
 #include "RenderOperation.h"
-#include <df3d/engine/EngineController.h>
-#include <df3d/engine/3d/Camera.h>
-#include <df3d/game/World.h>
+#include "Material.h"
+#include <df3d/engine/resources/GpuProgramResource.h>
 
 namespace df3d {
 
-void RenderQueue::sort()
+namespace {
+
+// Sort key layout (most significant bits first).
+// Opaque:      | bucket 3 | program 10 | state 16 | textures 10 | vertex buffer 9 | depth 16 (front to back) |
+// Transparent: | bucket 3 | depth 32 (back to front) | program 13 | state 16 |
+// 2D:          | bucket 3 | z 32 | 0 |, ties keep submission order.
+// Opaque program, textures and vertex buffer fields are truncated to leave depth 8 exponent and
+// 8 mantissa bits (~0.4% of the distance). With 8 bits depth was a bucket per 4x of distance
+// (everything from 8 to 32 units compared equal), so front to back order barely held.
+// Truncated fields only collide when there are more than 1024 programs or 512 vertex buffers,
+// which costs some extra state changes and missed batches but never a wrong merge.
+const uint64_t SORT_KEY_BUCKET_SHIFT = 61;
+
+const uint64_t OPAQUE_PROGRAM_SHIFT = 51;
+const uint64_t OPAQUE_STATE_SHIFT = 35;
+const uint64_t OPAQUE_TEXTURES_SHIFT = 25;
+const uint64_t OPAQUE_VERTEX_BUFFER_SHIFT = 16;
+
+const uint64_t TRANSPARENT_DEPTH_SHIFT = 29;
+const uint64_t TRANSPARENT_PROGRAM_SHIFT = 16;
+
+const uint64_t Z_2D_SHIFT = 29;
+
+// Maps float to uint32 so that unsigned integer comparison gives the same order.
+DF3D_FINLINE uint32_t FloatToSortable(float f)
 {
-    auto cameraDir = svc().defaultWorld().getCamera()->getDir();
-    auto cameraPos = svc().defaultWorld().getCamera()->getPosition();
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
 
-    auto &transparentOps = rops[RQ_BUCKET_TRANSPARENT];
+DF3D_FINLINE uint64_t GetProgramKey(const RenderPass *pass, uint64_t mask)
+{
+    if (!pass || !pass->program)
+        return 0;
+    return pass->program->handle.getIndex() & mask;
+}
 
-    std::sort(transparentOps.begin(), transparentOps.end(), [&cameraDir, &cameraPos](const RenderOperation &a, const RenderOperation &b) {
-        auto d1 = glm::dot(cameraDir, glm::vec3(a.worldTransform[3]) - cameraPos);
-        auto d2 = glm::dot(cameraDir, glm::vec3(b.worldTransform[3]) - cameraPos);
-        return d1 > d2;
-    });
+DF3D_FINLINE uint64_t GetStateKey(const RenderPass *pass)
+{
+    return pass ? (pass->state & 0xFFFF) : 0;
+}
+
+DF3D_FINLINE uint64_t GetTexturesKey(const RenderPass *pass)
+{
+    return pass ? (pass->getTexturesKey() & 0x3FF) : 0;
+}
 
-    auto &ops2D = rops[RQ_BUCKET_2D];
+// Positive depth only, objects behind the camera go first. Drops the always set sign bit.
+DF3D_FINLINE uint64_t GetOpaqueDepthKey(float viewDepth)
+{
+    return (FloatToSortable(std::max(viewDepth, 0.0f)) >> 15) & 0xFFFF;
+}
 
-    std::sort(ops2D.begin(), ops2D.end(), [](const RenderOperation &a, const RenderOperation &b) {
-        return a.z < b.z;
-    });
+uint64_t MakeOpaqueKey(uint64_t bucket, const RenderOperation &op, float viewDepth)
+{
+    // Same geometry with the same pass ends up adjacent, so it can be merged into instanced batches.
+    return (bucket << SORT_KEY_BUCKET_SHIFT) |
+        (GetProgramKey(op.passProps, 0x3FF) << OPAQUE_PROGRAM_SHIFT) |
+        (GetStateKey(op.passProps) << OPAQUE_STATE_SHIFT) |
+        (GetTexturesKey(op.passProps) << OPAQUE_TEXTURES_SHIFT) |
+        (uint64_t(op.vertexBuffer.getIndex() & 0x1FF) << OPAQUE_VERTEX_BUFFER_SHIFT) |
+        GetOpaqueDepthKey(viewDepth);
+}
+
+uint64_t MakeTransparentKey(uint64_t bucket, const RenderOperation &op, float viewDepth)
+{
+    return (bucket << SORT_KEY_BUCKET_SHIFT) |
+        (uint64_t(~FloatToSortable(viewDepth)) << TRANSPARENT_DEPTH_SHIFT) |
+        (GetProgramKey(op.passProps, 0x1FFF) << TRANSPARENT_PROGRAM_SHIFT) |
+        GetStateKey(op.passProps);
+}
+
+uint64_t Make2DKey(uint64_t bucket, const RenderOperation &op)
+{
+    return (bucket << SORT_KEY_BUCKET_SHIFT) | (uint64_t(FloatToSortable(op.z)) << Z_2D_SHIFT);
+}
+
+const size_t MIN_INSTANCES_TO_MERGE = 2;
+
+bool CanBeInstanced(const RenderOperation &a, const RenderOperation &b)
+{
+    return a.passProps == b.passProps &&
+        a.vertexBuffer == b.vertexBuffer &&
+        a.indexBuffer == b.indexBuffer &&
+        a.startVertex == b.startVertex &&
+        a.numberOfElements == b.numberOfElements &&
+        a.topology == b.topology &&
+        a.instancesCount == 0 && b.instancesCount == 0;
+}
+
+}
+
+void RenderQueue::sortBucket(std::vector<RenderOperation> &ops)
+{
+    const size_t count = ops.size();
+    if (count < 2)
+        return;
+
+    m_sortItems.resize(count);
+    m_sortTemp.resize(count);
+
+    // Histograms for every byte of the key are built in one pass.
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto key = ops[i].sortKey;
+        m_sortItems[i] = { key, (uint32_t)i };
+
+        for (int byte = 0; byte < 8; byte++)
+            histograms[byte][(key >> (byte * 8)) & 0xFF]++;
+    }
+
+    // LSD radix sort, stable. Skip passes where all the keys share the same byte.
+    auto src = m_sortItems.data();
+    auto dst = m_sortTemp.data();
+    for (int byte = 0; byte < 8; byte++)
+    {
+        auto &hist = histograms[byte];
+        if (hist[(src[0].key >> (byte * 8)) & 0xFF] == count)
+            continue;
+
+        uint32_t offsets[256];
+        uint32_t total = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            offsets[b] = total;
+            total += hist[b];
+        }
+
+        for (size_t i = 0; i < count; i++)
+            dst[offsets[(src[i].key >> (byte * 8)) & 0xFF]++] = src[i];
+
+        std::swap(src, dst);
+    }
+
+    m_sortedOps.resize(count);
+    for (size_t i = 0; i < count; i++)
+        m_sortedOps[i] = ops[src[i].idx];
+
+    ops.swap(m_sortedOps);
+}
+
+void RenderQueue::mergeBucket(std::vector<RenderOperation> &ops)
+{
+    m_sortedOps.clear();
+
+    size_t i = 0;
+    while (i < ops.size())
+    {
+        size_t j = i + 1;
+        while (j < ops.size() && CanBeInstanced(ops[i], ops[j]))
+            j++;
+
+        if (j - i >= MIN_INSTANCES_TO_MERGE)
+        {
+            RenderOperation batch = ops[i];
+            batch.instanceTransforms = instanceTransforms.data() + instanceTransforms.size();
+            batch.instancesCount = (uint32_t)(j - i);
+
+            for (size_t k = i; k < j; k++)
+                instanceTransforms.push_back(ops[k].worldTransform);
+
+            m_sortedOps.push_back(batch);
+        }
+        else
+        {
+            m_sortedOps.insert(m_sortedOps.end(), ops.begin() + i, ops.begin() + j);
+        }
+
+        i = j;
+    }
+
+    ops.swap(m_sortedOps);
+}
+
+void RenderQueue::mergeInstances()
+{
+    // Reserve in advance, batches point into this storage.
+    instanceTransforms.clear();
+    instanceTransforms.reserve(rops[RQ_BUCKET_LIT].size() + rops[RQ_BUCKET_NOT_LIT].size());
+
+    mergeBucket(rops[RQ_BUCKET_LIT]);
+    mergeBucket(rops[RQ_BUCKET_NOT_LIT]);
+}
+
+void RenderQueue::sort(const glm::vec3 &cameraPos, const glm::vec3 &cameraDir)
+{
+    auto viewDepth = [&cameraPos, &cameraDir](const RenderOperation &op) {
+        return glm::dot(cameraDir, glm::vec3(op.worldTransform[3]) - cameraPos);
+    };
+
+    // Group opaque geometry by program, state and textures in order to minimize state changes.
+    for (auto bucket : { RQ_BUCKET_LIT, RQ_BUCKET_NOT_LIT })
+    {
+        for (auto &op : rops[bucket])
+            op.sortKey = MakeOpaqueKey(bucket, op, viewDepth(op));
+        sortBucket(rops[bucket]);
+    }
+
+    for (auto &op : rops[RQ_BUCKET_TRANSPARENT])
+        op.sortKey = MakeTransparentKey(RQ_BUCKET_TRANSPARENT, op, viewDepth(op));
+    sortBucket(rops[RQ_BUCKET_TRANSPARENT]);
+
+    for (auto &op : rops[RQ_BUCKET_2D])
+        op.sortKey = Make2DKey(RQ_BUCKET_2D, op);
+    sortBucket(rops[RQ_BUCKET_2D]);
 }
 
 void RenderQueue::clear()
@@ -34,6 +224,16 @@ void RenderQueue::clear()
 
     for (auto &l : lights)
         l = {};
+
+    instanceTransforms.clear();
+}
+
+void RenderQueue::append(const RenderQueue &other)
+{
+    DF3D_ASSERT(other.instanceTransforms.empty());
+
+    for (size_t i = 0; i < RQ_BUCKET_COUNT; i++)
+        rops[i].insert(rops[i].end(), other.rops[i].begin(), other.rops[i].end());
 }
 
 }
@@ -10,9 +10,30 @@ struct RenderQueue
 {
     std::vector<RenderOperation> rops[RQ_BUCKET_COUNT];
     Light lights[LIGHTS_MAX];
+    //! Storage for the instanced batches transforms.
+    std::vector<glm::mat4> instanceTransforms;
 
-    void sort();
+    void sort(const glm::vec3 &cameraPos, const glm::vec3 &cameraDir);
+    //! Merges sorted opaque operations with the same geometry and pass into instanced batches.
+    void mergeInstances();
     void clear();
+    //! Appends render operations of the other queue, lights are not touched.
+    void append(const RenderQueue &other);
+
+private:
+    struct SortItem
+    {
+        uint64_t key;
+        uint32_t idx;
+    };
+
+    // Scratch storage, reused between frames.
+    std::vector<SortItem> m_sortItems;
+    std::vector<SortItem> m_sortTemp;
+    std::vector<RenderOperation> m_sortedOps;
+
+    void sortBucket(std::vector<RenderOperation> &ops);
+    void mergeBucket(std::vector<RenderOperation> &ops);
 };
 
 }
@@ -95,22 +95,42 @@ VertexData::VertexData(const VertexFormat &format)
 void VertexData::addVertices(size_t verticesCount)
 {
     DF3D_ASSERT(verticesCount > 0);
+    DF3D_ASSERT(!m_view);
 
     m_data.resize(m_format.getVertexSize() * verticesCount + m_data.size());
 }
 
 void VertexData::addVertex()
 {
+    DF3D_ASSERT(!m_view);
+
     m_data.resize(m_data.size() + m_format.getVertexSize());
 }
 
+void VertexData::setView(const void *data, size_t sizeInBytes)
+{
+    DF3D_ASSERT(sizeInBytes % m_format.getVertexSize() == 0);
+
+    m_data.clear();
+    m_view = static_cast<const uint8_t *>(data);
+    m_viewSize = sizeInBytes;
+}
+
 void* VertexData::getVertex(size_t idx)
 {
+    DF3D_ASSERT(!m_view);
     DF3D_ASSERT(idx < getVerticesCount());
 
     return m_data.data() + m_format.getVertexSize() * idx;
 }
 
+const void* VertexData::getVertex(size_t idx) const
+{
+    DF3D_ASSERT(idx < getVerticesCount());
+
+    return static_cast<const uint8_t *>(getRawData()) + m_format.getVertexSize() * idx;
+}
+
 void* VertexData::getVertexAttribute(size_t idx, VertexFormat::VertexAttribute attrib)
 {
     DF3D_ASSERT(m_format.hasAttribute(attrib));
@@ -119,9 +139,17 @@ void* VertexData::getVertexAttribute(size_t idx, VertexFormat::VertexAttribute a
     return vertex + m_format.getOffsetTo(attrib);
 }
 
+const void* VertexData::getVertexAttribute(size_t idx, VertexFormat::VertexAttribute attrib) const
+{
+    DF3D_ASSERT(m_format.hasAttribute(attrib));
+
+    auto vertex = (const uint8_t*)getVertex(idx);
+    return vertex + m_format.getOffsetTo(attrib);
+}
+
 size_t VertexData::getVerticesCount() const
 {
-    return m_data.size() / m_format.getVertexSize();
+    return getSizeInBytes() / m_format.getVertexSize();
 }
 
 const VertexFormat& Vertex_p_tx_c::getFormat()
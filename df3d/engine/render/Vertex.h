@@ -67,6 +67,9 @@ class VertexData
 {
     PodArray<uint8_t> m_data;
     VertexFormat m_format;
+    // Not owned vertices, e.g. in a memory mapped file.
+    const uint8_t *m_view = nullptr;
+    size_t m_viewSize = 0;
 
 public:
     VertexData(const VertexFormat &format);
@@ -74,14 +77,21 @@ public:
     void addVertices(size_t verticesCount);
     void addVertex();
 
+    //! Uses external vertices instead of own ones, the memory must outlive this object.
+    //! Such data is read only.
+    void setView(const void *data, size_t sizeInBytes);
+    bool isView() const { return m_view != nullptr; }
+
     void* getVertex(size_t idx);
+    const void* getVertex(size_t idx) const;
     void* getVertexAttribute(size_t idx, VertexFormat::VertexAttribute attrib);
+    const void* getVertexAttribute(size_t idx, VertexFormat::VertexAttribute attrib) const;
     const VertexFormat& getFormat() const { return m_format; }
     size_t getVerticesCount() const;
-    void* getRawData() { return m_data.data(); }
-    const void* getRawData() const { return m_data.data(); }
-    size_t getSizeInBytes() const { return m_data.size(); }
-    void clear() { m_data.clear(); }
+    void* getRawData() { DF3D_ASSERT(!m_view); return m_data.data(); }
+    const void* getRawData() const { return m_view ? m_view : m_data.data(); }
+    size_t getSizeInBytes() const { return m_view ? m_viewSize : m_data.size(); }
+    void clear() { m_data.clear(); m_view = nullptr; m_viewSize = 0; }
 };
 
 struct Vertex_p_tx_c
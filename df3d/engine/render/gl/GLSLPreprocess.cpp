@@ -6,6 +6,8 @@
 #include <df3d/engine/resources/ResourceManager.h>
 #include <df3d/engine/resources/ResourceFileSystem.h>
 #include <df3d/engine/resources/ResourceDataSource.h>
+#include <df3d/engine/render/RenderManager.h>
+#include <df3d/engine/render/IRenderBackend.h>
 #include <df3d/lib/Utils.h>
 
 namespace df3d {
@@ -75,7 +77,12 @@ static std::string ShaderPreprocess(const std::string &shaderData)
         "#define MEDIUMP\n"
         "#endif\n";
 
-    return versionPrefix + precisionPrefix + shaderData;
+    // a_instanceWorld attribute can be declared only when the backend binds and streams it.
+    std::string instancingPrefix = "";
+    if (svc().renderManager().getBackend().getCaps().instancing)
+        instancingPrefix = "#define DF3D_INSTANCING\n";
+
+    return versionPrefix + precisionPrefix + instancingPrefix + shaderData;
 }
 
 static std::string ShaderPreprocessInclude(std::string shaderData, const std::string &shaderFilePath)
@@ -140,6 +140,33 @@ GLenum GetGLDrawMode(Topology topologyType)
     return GL_INVALID_ENUM;
 }
 
+size_t GetGLUniformSize(GLenum type)
+{
+    switch (type)
+    {
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_CUBE:
+    case GL_INT:
+        return sizeof(GLint);
+    case GL_FLOAT:
+        return sizeof(GLfloat);
+    case GL_FLOAT_VEC2:
+        return sizeof(GLfloat) * 2;
+    case GL_FLOAT_VEC3:
+        return sizeof(GLfloat) * 3;
+    case GL_FLOAT_VEC4:
+        return sizeof(GLfloat) * 4;
+    case GL_FLOAT_MAT3:
+        return sizeof(GLfloat) * 9;
+    case GL_FLOAT_MAT4:
+        return sizeof(GLfloat) * 16;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
 #ifdef _DEBUG
 void PrintShaderLog(GLuint shader)
 {
@@ -166,6 +193,21 @@ void PrintGPUProgramLog(GLuint program)
 }
 #endif
 
+// mat4 attribute occupies 4 consecutive locations right after the vertex attributes.
+const GLuint INSTANCE_WORLD_ATTRIB = VertexFormat::COUNT;
+const char *INSTANCE_WORLD_ATTRIB_NAME = "a_instanceWorld";
+
+void ResetInstanceWorldAttrib()
+{
+    // Regular draw calls with an instanced program get identity transform.
+    for (GLuint i = 0; i < 4; i++)
+    {
+        glm::vec4 column(0.0f);
+        column[i] = 1.0f;
+        GL_CHECK(glVertexAttrib4fv(INSTANCE_WORLD_ATTRIB + i, &column[0]));
+    }
+}
+
 GLenum g_depthFuncLookup[] = {
     GL_INVALID_ENUM,
 
@@ -354,10 +396,10 @@ bool GLTexture::init(const TextureResourceData &data, uint32_t flags, int maxSiz
             const auto &mipLevel = data.mipLevels[mip];
 
             GL_CHECK(glCompressedTexImage2D(GL_TEXTURE_2D, mip, glInternalFormat,
-                                            mipLevel.width, mipLevel.height, 0, mipLevel.pixels.size(),
-                                            mipLevel.pixels.data()));
+                                            mipLevel.width, mipLevel.height, 0, mipLevel.getPixelsSize(),
+                                            mipLevel.getPixels()));
 
-            m_sizeInBytes += mipLevel.pixels.size();
+            m_sizeInBytes += mipLevel.getPixelsSize();
         }
     }
     else
@@ -365,7 +407,7 @@ bool GLTexture::init(const TextureResourceData &data, uint32_t flags, int maxSiz
         DF3D_ASSERT(data.mipLevels.size() == 1);
         GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, glInternalFormat,
                               width, height, 0, pixelDataFormat,
-                              GL_UNSIGNED_BYTE, data.mipLevels[0].pixels.data()));
+                              GL_UNSIGNED_BYTE, data.mipLevels[0].getPixels()));
 
         bool mipmapped = false;
         if (((flags & TEXTURE_FILTERING_MASK) == TEXTURE_FILTERING_TRILINEAR) ||
@@ -568,11 +610,18 @@ void RenderBackendGL::setupBlending(uint64_t srcFactor, uint64_t dstFactor)
     }
 }
 
+void RenderBackendGL::invalidateTexturesCache()
+{
+    // Texture creation and update rebind the active unit.
+    for (auto &unit : m_pipeLineState.textures)
+        unit = {};
+}
+
 RenderBackendGL::RenderBackendGL(int width, int height)
-    : m_vertexBuffersBag(MemoryManager::allocDefault()),
-    m_indexBuffersBag(MemoryManager::allocDefault()),
-    m_texturesBag(MemoryManager::allocDefault()),
-    m_gpuProgramsBag(MemoryManager::allocDefault())
+    : m_vertexBuffersBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_indexBuffersBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_texturesBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_gpuProgramsBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER))
 {
 #ifdef DF3D_DESKTOP
     // Init GLEW.
@@ -617,6 +666,16 @@ RenderBackendGL::RenderBackendGL(int width, int height)
     if (m_caps.maxTextureSize < 2048)
         throw std::runtime_error("Hardware not supported");
 
+#if defined(DF3D_DESKTOP)
+    m_caps.instancing = glewIsSupported("GL_ARB_instanced_arrays GL_ARB_draw_instanced") == GL_TRUE;
+    if (m_caps.instancing)
+        ResetInstanceWorldAttrib();
+
+    m_caps.indices32 = true;
+#else
+    m_caps.indices32 = m_extensionsString.find("GL_OES_element_index_uint") != std::string::npos;
+#endif
+
 #ifdef _DEBUG
     // Print GPU info.
     const char *ver = (const char *)glGetString(GL_VERSION);
@@ -630,6 +689,7 @@ RenderBackendGL::RenderBackendGL(int width, int height)
     DFLOG_MESS("Shaders version %s", shaderVer);
 
     DFLOG_MESS("Max texture size %d", m_caps.maxTextureSize);
+    DFLOG_MESS("32-bit indices %s", m_caps.indices32 ? "supported" : "not supported");
 
     DFLOG_DEBUG("RenderBackendGL storage %d KB", utils::sizeKB(sizeof(*this)));
 #endif
@@ -641,6 +701,9 @@ RenderBackendGL::RenderBackendGL(int width, int height)
 
 RenderBackendGL::~RenderBackendGL()
 {
+    if (m_instanceBuffer && !m_destroyAndroidWorkaround)
+        GL_CHECK(glDeleteBuffers(1, &m_instanceBuffer));
+
     DF3D_ASSERT(m_vertexBuffersBag.empty());
     DF3D_ASSERT(m_indexBuffersBag.empty());
     DF3D_ASSERT(m_texturesBag.empty());
@@ -684,6 +747,9 @@ void RenderBackendGL::frameBegin()
     GL_CHECK(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
 
     m_frameStats.drawCalls = m_frameStats.totalLines = m_frameStats.totalTriangles = 0;
+    m_frameStats.bindsIssued = m_frameStats.bindsSkipped = 0;
+    m_frameStats.uniformsIssued = m_frameStats.uniformsSkipped = 0;
+    m_frameStats.stateChangesIssued = m_frameStats.stateChangesSkipped = 0;
 
     m_pipeLineState = {};
 }
@@ -715,6 +781,9 @@ void RenderBackendGL::destroyVertexBuffer(VertexBufferHandle handle)
             vbuffer.destroy();
 
         vbuffer = {};
+
+        if (m_pipeLineState.vertexBuffer == handle)
+            m_pipeLineState.vertexBuffer = {};
         m_vertexBuffersBag.release(handle.getID());
     }
     else
@@ -725,11 +794,21 @@ void RenderBackendGL::bindVertexBuffer(VertexBufferHandle handle, uint32_t verte
 {
     if (m_vertexBuffersBag.isValid(handle.getID()))
     {
+        m_pipeLineState.indexedDrawCall = false;
+
+        if (m_pipeLineState.vertexBuffer == handle && m_pipeLineState.vertexStart == vertexStart)
+        {
+            m_frameStats.bindsSkipped++;
+            return;
+        }
+
         auto &vertexBuffer = m_vertexBuffers[handle.getIndex()];
 
         vertexBuffer.bindBuffer(vertexStart);
 
-        m_pipeLineState.indexedDrawCall = false;
+        m_pipeLineState.vertexBuffer = handle;
+        m_pipeLineState.vertexStart = vertexStart;
+        m_frameStats.bindsIssued++;
     }
     else
         DF3D_ASSERT(false);
@@ -749,10 +828,14 @@ void RenderBackendGL::updateVertexBuffer(VertexBufferHandle handle, uint32_t ver
 
 IndexBufferHandle RenderBackendGL::createIndexBuffer(uint32_t numIndices, const void *data, IndicesType indicesType)
 {
-    // NOTE: some GPUs do not support 32-bit indices (Mali 400)
-    DF3D_ASSERT(indicesType == INDICES_16_BIT);
     DF3D_ASSERT(numIndices > 0);
 
+    if (indicesType == INDICES_32_BIT && !m_caps.indices32)
+    {
+        DFLOG_WARN("Failed to create index buffer: 32-bit indices are not supported");
+        return {};
+    }
+
     IndexBufferHandle ibHandle;
     GLIndexBuffer ibuffer;
 
@@ -762,6 +845,9 @@ IndexBufferHandle RenderBackendGL::createIndexBuffer(uint32_t numIndices, const
 
         m_indexBuffers[ibHandle.getIndex()] = ibuffer;
 
+        // GLIndexBuffer::init resets GL_ELEMENT_ARRAY_BUFFER binding.
+        m_pipeLineState.indexBuffer = {};
+
         TRACE_GPU_ALLOC("Index Buffer", ibuffer.getSize());
     }
 
@@ -781,6 +867,8 @@ void RenderBackendGL::destroyIndexBuffer(IndexBufferHandle handle)
 
         indexBuffer = {};
 
+        m_pipeLineState.indexBuffer = {};
+
         m_indexBuffersBag.release(handle.getID());
     }
     else
@@ -793,7 +881,17 @@ void RenderBackendGL::bindIndexBuffer(IndexBufferHandle handle)
     {
         auto &indexBuffer = m_indexBuffers[handle.getIndex()];
 
-        indexBuffer.bindBuffer();
+        if (m_pipeLineState.indexBuffer != handle)
+        {
+            indexBuffer.bindBuffer();
+
+            m_pipeLineState.indexBuffer = handle;
+            m_frameStats.bindsIssued++;
+        }
+        else
+        {
+            m_frameStats.bindsSkipped++;
+        }
 
         m_pipeLineState.indexedDrawCall = true;
         m_pipeLineState.currIndicesType = indexBuffer.is16Bit() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
@@ -813,6 +911,8 @@ TextureHandle RenderBackendGL::createTexture(const TextureResourceData &data, ui
 
         m_textures[textureHandle.getIndex()] = texture;
 
+        invalidateTexturesCache();
+
         m_frameStats.textures++;
         TRACE_GPU_ALLOC("Texture", texture.getSize());
     }
@@ -825,6 +925,8 @@ void RenderBackendGL::updateTexture(TextureHandle handle, int originX, int origi
     if (m_texturesBag.isValid(handle.getID()))
     {
         m_textures[handle.getIndex()].updateData(originX, originY, width, height, data);
+
+        invalidateTexturesCache();
     }
     else
         DF3D_ASSERT(false);
@@ -845,6 +947,8 @@ void RenderBackendGL::destroyTexture(TextureHandle handle)
 
         texture = {};
 
+        invalidateTexturesCache();
+
         m_texturesBag.release(handle.getID());
     }
     else
@@ -855,7 +959,20 @@ void RenderBackendGL::bindTexture(GPUProgramHandle program, TextureHandle handle
 {
     if (m_texturesBag.isValid(handle.getID()))
     {
-        m_textures[handle.getIndex()].bindTexture(unit);
+        DF3D_ASSERT(unit >= 0 && unit < MAX_TEXTURE_UNITS);
+
+        auto &boundTexture = m_pipeLineState.textures[unit];
+        if (boundTexture != handle)
+        {
+            m_textures[handle.getIndex()].bindTexture(unit);
+
+            boundTexture = handle;
+            m_frameStats.bindsIssued++;
+        }
+        else
+        {
+            m_frameStats.bindsSkipped++;
+        }
 
         setUniformValue(program, textureUniform, &unit);
     }
@@ -888,6 +1005,10 @@ GPUProgramHandle RenderBackendGL::createGPUProgram(const char *vertexShaderData,
     GL_CHECK(glBindAttribLocation(program.glID, VertexFormat::COLOR, "a_vertexColor"));
     GL_CHECK(glBindAttribLocation(program.glID, VertexFormat::TANGENT, "a_tangent"));
     GL_CHECK(glBindAttribLocation(program.glID, VertexFormat::BITANGENT, "a_bitangent"));
+#if defined(DF3D_DESKTOP)
+    if (m_caps.instancing)
+        GL_CHECK(glBindAttribLocation(program.glID, INSTANCE_WORLD_ATTRIB, INSTANCE_WORLD_ATTRIB_NAME));
+#endif
 
     GL_CHECK(glLinkProgram(program.glID));
 
@@ -905,6 +1026,13 @@ GPUProgramHandle RenderBackendGL::createGPUProgram(const char *vertexShaderData,
 
     GL_CHECK(glUseProgram(0));
 
+    if (m_caps.instancing)
+    {
+        GLint instanceAttrib = -1;
+        GL_CHECK(instanceAttrib = glGetAttribLocation(program.glID, INSTANCE_WORLD_ATTRIB_NAME));
+        program.instanced = instanceAttrib == (GLint)INSTANCE_WORLD_ATTRIB;
+    }
+
     requestUniforms(program);
 
     // Must detach shaders only after uniforms were retreived.
@@ -930,6 +1058,8 @@ void RenderBackendGL::destroyGPUProgram(GPUProgramHandle handle)
             GL_CHECK(glDeleteProgram(programGL.glID));
         }
 
+        m_pipeLineState.program = {};
+
         programGL = {};
         m_gpuProgramsBag.release(handle.getID());
     }
@@ -940,7 +1070,10 @@ void RenderBackendGL::destroyGPUProgram(GPUProgramHandle handle)
 void RenderBackendGL::bindGPUProgram(GPUProgramHandle handle)
 {
     if (handle == m_pipeLineState.program)
+    {
+        m_frameStats.bindsSkipped++;
         return;
+    }
 
     if (m_gpuProgramsBag.isValid(handle.getID()))
     {
@@ -950,6 +1083,7 @@ void RenderBackendGL::bindGPUProgram(GPUProgramHandle handle)
         GL_CHECK(glUseProgram(programGL.glID));
 
         m_pipeLineState.program = handle;
+        m_frameStats.bindsIssued++;
     }
     else
         DF3D_ASSERT(false);
@@ -976,11 +1110,27 @@ UniformHandle RenderBackendGL::getUniform(GPUProgramHandle program, const char *
 
 void RenderBackendGL::setUniformValue(GPUProgramHandle program, UniformHandle uniformHandle, const void *data)
 {
-    const auto &programGL = m_gpuPrograms[program.getIndex()];
-    const auto &uniformGL = programGL.uniforms[uniformHandle.getID() - 1];
+    auto &programGL = m_gpuPrograms[program.getIndex()];
+    auto &uniformGL = programGL.uniforms[uniformHandle.getID() - 1];
 
     DF3D_ASSERT(uniformGL.type != GL_INVALID_ENUM && uniformGL.location != -1);
 
+    // Uniform values are a part of the program object state, skip if unchanged.
+    const auto uniformSize = GetGLUniformSize(uniformGL.type);
+    if (uniformSize > 0)
+    {
+        if (uniformGL.cachedValueValid && memcmp(uniformGL.cachedValue, data, uniformSize) == 0)
+        {
+            m_frameStats.uniformsSkipped++;
+            return;
+        }
+
+        memcpy(uniformGL.cachedValue, data, uniformSize);
+        uniformGL.cachedValueValid = true;
+    }
+
+    m_frameStats.uniformsIssued++;
+
     switch (uniformGL.type)
     {
     case GL_SAMPLER_2D:
@@ -1042,15 +1192,25 @@ void RenderBackendGL::setClearData(const glm::vec3 &color, float depth)
 
 void RenderBackendGL::setState(uint64_t state)
 {
-    if (state == m_pipeLineState.state)
+    const auto changed = state ^ m_pipeLineState.state;
+    if (changed == 0)
+    {
+        m_frameStats.stateChangesSkipped++;
         return;
+    }
 
-    setupDepthTest(state & RENDER_STATE_DEPTH_MASK);
-    setupDepthWrite(state & RENDER_STATE_DEPTH_WRITE_MASK);
-    setupFaceCulling(state & RENDER_STATE_FACE_CULL_MASK);
-    setupBlending(GetBlendingSrcFactor(state), GetBlendingDstFactor(state));
+    // Touch only those state groups that have been changed.
+    if (changed & RENDER_STATE_DEPTH_MASK)
+        setupDepthTest(state & RENDER_STATE_DEPTH_MASK);
+    if (changed & RENDER_STATE_DEPTH_WRITE_MASK)
+        setupDepthWrite(state & RENDER_STATE_DEPTH_WRITE_MASK);
+    if (changed & RENDER_STATE_FACE_CULL_MASK)
+        setupFaceCulling(state & RENDER_STATE_FACE_CULL_MASK);
+    if (changed & RENDER_STATE_BLENDING_MASK)
+        setupBlending(GetBlendingSrcFactor(state), GetBlendingDstFactor(state));
 
     m_pipeLineState.state = state;
+    m_frameStats.stateChangesIssued++;
 }
 
 void RenderBackendGL::draw(Topology type, uint32_t numberOfElements)
@@ -1083,4 +1243,89 @@ void RenderBackendGL::draw(Topology type, uint32_t numberOfElements)
 #endif
 }
 
+void RenderBackendGL::drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount)
+{
+#if defined(DF3D_DESKTOP)
+    DF3D_ASSERT(m_caps.instancing && isInstancingSupported(m_pipeLineState.program));
+
+    if (m_instanceBuffer == 0)
+        GL_CHECK(glGenBuffers(1, &m_instanceBuffer));
+
+    // Upload instances stream, orphaning the previous storage.
+    const uint32_t sizeInBytes = instancesCount * sizeof(glm::mat4);
+
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer));
+    if (sizeInBytes > m_instanceBufferSize)
+    {
+        TRACE_GPU_FREE("Instance Buffer", m_instanceBufferSize);
+
+        m_instanceBufferSize = std::max(sizeInBytes, m_instanceBufferSize * 2);
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_instanceBufferSize, nullptr, GL_STREAM_DRAW));
+
+        TRACE_GPU_ALLOC("Instance Buffer", m_instanceBufferSize);
+    }
+    else
+    {
+        GL_CHECK(glBufferData(GL_ARRAY_BUFFER, m_instanceBufferSize, nullptr, GL_STREAM_DRAW));
+    }
+    GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeInBytes, instanceTransforms));
+
+    // The ARB entry points, a legacy context may not expose the core ones.
+    for (GLuint i = 0; i < 4; i++)
+    {
+        GL_CHECK(glEnableVertexAttribArray(INSTANCE_WORLD_ATTRIB + i));
+        GL_CHECK(glVertexAttribPointer(INSTANCE_WORLD_ATTRIB + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (const GLvoid*)(sizeof(glm::vec4) * i)));
+        GL_CHECK(glVertexAttribDivisorARB(INSTANCE_WORLD_ATTRIB + i, 1));
+    }
+
+    if (m_pipeLineState.indexedDrawCall)
+        GL_CHECK(glDrawElementsInstancedARB(GetGLDrawMode(type), numberOfElements, m_pipeLineState.currIndicesType, nullptr, instancesCount));
+    else
+        GL_CHECK(glDrawArraysInstancedARB(GetGLDrawMode(type), 0, numberOfElements, instancesCount));
+
+    for (GLuint i = 0; i < 4; i++)
+    {
+        GL_CHECK(glVertexAttribDivisorARB(INSTANCE_WORLD_ATTRIB + i, 0));
+        GL_CHECK(glDisableVertexAttribArray(INSTANCE_WORLD_ATTRIB + i));
+    }
+
+    ResetInstanceWorldAttrib();
+
+    // Vertex attributes of the current vertex buffer are kept, only the binding point has changed.
+    GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+    // Update stats.
+#ifdef _DEBUG
+    {
+        m_frameStats.drawCalls++;
+        switch (type)
+        {
+        case Topology::LINES:
+            m_frameStats.totalLines += numberOfElements / 2 * instancesCount;
+            break;
+        case Topology::TRIANGLES:
+            m_frameStats.totalTriangles += numberOfElements / 3 * instancesCount;
+            break;
+        case Topology::TRIANGLE_STRIP:
+            if (numberOfElements >= 3)
+                m_frameStats.totalTriangles += (numberOfElements - 2) * instancesCount;
+            break;
+        default:
+            break;
+        }
+    }
+#endif
+#else
+    DF3D_ASSERT_MESS(false, "instancing is not supported");
+#endif
+}
+
+bool RenderBackendGL::isInstancingSupported(GPUProgramHandle program)
+{
+    if (!m_caps.instancing || !m_gpuProgramsBag.isValid(program.getID()))
+        return false;
+
+    return m_gpuPrograms[program.getIndex()].instanced;
+}
+
 }
@@ -94,10 +94,16 @@ struct GLProgram
         std::string name;
         GLenum type = GL_INVALID_ENUM;
         GLint location = -1;
+
+        // Last value uploaded to the program, used to skip redundant glUniform calls.
+        uint8_t cachedValue[sizeof(float) * 16];
+        bool cachedValueValid = false;
     };
 
     std::vector<Uniform> uniforms;
     GLuint glID = 0;
+    //! Whether the program declares a_instanceWorld attribute.
+    bool instanced = false;
 };
 
 class RenderBackendGL : public IRenderBackend
@@ -122,10 +128,19 @@ class RenderBackendGL : public IRenderBackend
     GLTexture m_textures[MAX_SIZE];
     GLProgram m_gpuPrograms[MAX_SIZE];
 
+    enum {
+        MAX_TEXTURE_UNITS = 8
+    };
+
+    // Shadow copy of the GL state in order to filter out redundant calls.
     struct PipelineState
     {
         uint64_t state = 0;
         GPUProgramHandle program;
+        VertexBufferHandle vertexBuffer;
+        uint32_t vertexStart = 0;
+        IndexBufferHandle indexBuffer;
+        TextureHandle textures[MAX_TEXTURE_UNITS];
         GLenum currIndicesType = GL_INVALID_ENUM;
         bool indexedDrawCall = false;
     };
@@ -137,6 +152,10 @@ class RenderBackendGL : public IRenderBackend
 
     bool m_destroyAndroidWorkaround = false;
 
+    // Per-instance transforms stream.
+    GLuint m_instanceBuffer = 0;
+    uint32_t m_instanceBufferSize = 0;
+
     VertexBufferHandle createVBHelper(const VertexFormat &format, uint32_t numVertices, const void *data, bool dynamic);
     GLuint createShader(const char *data, GLenum type);
     void destroyShader(GLuint programID, GLuint shaderID);
@@ -147,6 +166,8 @@ class RenderBackendGL : public IRenderBackend
     void setupFaceCulling(uint64_t faceState);
     void setupBlending(uint64_t srcFactor, uint64_t dstFactor);
 
+    void invalidateTexturesCache();
+
 public:
     RenderBackendGL(int width, int height);
     ~RenderBackendGL();
@@ -187,6 +208,8 @@ public:
 
     void setState(uint64_t state) override;
     void draw(Topology type, uint32_t numberOfElements) override;
+    void drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount) override;
+    bool isInstancingSupported(GPUProgramHandle program) override;
 
     void setDestroyAndroidWorkaround() override { m_destroyAndroidWorkaround = true; }
     RenderBackendID getID() const override { return RenderBackendID::GL; }
@@ -2,6 +2,10 @@
 \
 attribute vec3 a_vertex3;                   \n\
 \
+#ifdef DF3D_INSTANCING                      \n\
+attribute mat4 a_instanceWorld;             \n\
+#endif                                      \n\
+\
 uniform mat4 u_worldViewProjectionMatrix;   \n\
 uniform LOWP vec4 u_globalAmbient;               \n\
 \
@@ -13,6 +17,10 @@ void main()                                 \n\
     color = u_globalAmbient; \n\
     color.a = 1.0;                          \n\
 \
+#ifdef DF3D_INSTANCING                      \n\
+    gl_Position = u_worldViewProjectionMatrix * a_instanceWorld * vec4( a_vertex3, 1.0 );\n\
+#else                                       \n\
     gl_Position = u_worldViewProjectionMatrix * vec4( a_vertex3, 1.0 );\n\
+#endif                                      \n\
 }                                           \n\
 "
\ No newline at end of file
@@ -4,6 +4,10 @@ attribute vec3 a_vertex3;                   \n\
 attribute vec2 a_txCoord;                   \n\
 attribute vec4 a_vertexColor;               \n\
 \
+#ifdef DF3D_INSTANCING                      \n\
+attribute mat4 a_instanceWorld;             \n\
+#endif                                      \n\
+\
 uniform mat4 u_worldViewProjectionMatrix;   \n\
 \
 uniform LOWP vec4 material_diffuse;                  \n\
@@ -16,7 +20,11 @@ void main()                                 \n\
 \
     color = a_vertexColor * material_diffuse; \n\
 \
+#ifdef DF3D_INSTANCING                      \n\
+    gl_Position = u_worldViewProjectionMatrix * a_instanceWorld * vec4( a_vertex3, 1.0 );\n\
+#else                                       \n\
     gl_Position = u_worldViewProjectionMatrix * vec4( a_vertex3, 1.0 );\n\
+#endif                                      \n\
 \
     UV = a_txCoord;                         \n\
 }                                           \n\
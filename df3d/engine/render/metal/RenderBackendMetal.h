@@ -127,6 +127,8 @@ public:
     void setState(uint64_t state) override;
 
     void draw(Topology type, uint32_t numberOfElements) override;
+    void drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount) override;
+    bool isInstancingSupported(GPUProgramHandle program) override { return false; }
 
     void setDestroyAndroidWorkaround() override { }
     RenderBackendID getID() const { return RenderBackendID::METAL; }
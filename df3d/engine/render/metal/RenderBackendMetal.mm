@@ -545,7 +545,7 @@ public:
 
     bool init(id<MTLDevice> device, uint32_t numIndices, const void *data, bool indices16)
     {
-        DF3D_ASSERT(data != nullptr && indices16);
+        DF3D_ASSERT(data != nullptr);
 
         if (indices16)
             m_indexType = MTLIndexTypeUInt16;
@@ -613,7 +613,7 @@ public:
         for (size_t i = 0; i < data.mipLevels.size(); i++)
         {
             const auto &mipLevel = data.mipLevels[i];
-            if (mipLevel.pixels.size() > 0)
+            if (mipLevel.getPixelsSize() > 0)
             {
                 int levelBytesPerRow = 0;
 
@@ -623,7 +623,7 @@ public:
                 auto region = MTLRegionMake2D(0, 0, mipLevel.width, mipLevel.height);
                 [m_texture replaceRegion:region
                              mipmapLevel:i
-                               withBytes:mipLevel.pixels.data()
+                               withBytes:mipLevel.getPixels()
                              bytesPerRow:levelBytesPerRow];
             }
         }
@@ -746,6 +746,8 @@ RenderBackendMetal::RenderBackendMetal(const EngineInitParams &params)
 
     m_caps.maxTextureSize = 4096;
     m_caps.maxAnisotropy = 16.0f;
+    m_caps.indices32 = true;
+    m_caps.instancing = false;
 
     m_frameBoundarySemaphore = dispatch_semaphore_create(MAX_IN_FLIGHT_FRAMES);
 }
@@ -931,7 +933,6 @@ void RenderBackendMetal::bindVertexBuffer(VertexBufferHandle handle, uint32_t ve
 IndexBufferHandle RenderBackendMetal::createIndexBuffer(uint32_t numIndices, const void *data, IndicesType indicesType)
 {
     DF3D_ASSERT(numIndices > 0);
-    DF3D_ASSERT(indicesType == INDICES_16_BIT);
 
     unique_ptr<MetalIndexBuffer> ibuffer = make_unique<MetalIndexBuffer>();
     IndexBufferHandle ibHandle;
@@ -1326,4 +1327,10 @@ void RenderBackendMetal::draw(Topology type, uint32_t numberOfElements)
     m_pipelineState.vbVertexStart = 0;
 }
 
+void RenderBackendMetal::drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount)
+{
+    // Never called: caps.instancing is off and Metal shaders have no per-instance transforms,
+    // RenderManager replays instanced batches with regular draws.
+}
+
 }
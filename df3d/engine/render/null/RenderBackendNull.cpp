@@ -0,0 +1,404 @@
+#include "RenderBackendNull.h"
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/render/RenderCommon.h>
+#include <df3d/engine/resources/TextureResource.h>
+
+namespace df3d {
+
+void RenderBackendNull::record(RecordedCommandType type, uint32_t arg0, uint32_t arg1)
+{
+    m_commandsCount[(size_t)type]++;
+
+    if (m_recordingEnabled)
+        m_commands.push_back({ type, arg0, arg1 });
+}
+
+static void KeepData(std::vector<uint8_t> &dst, size_t offset, const void *data, size_t size)
+{
+    if (!data)
+        return;
+
+    if (dst.size() < offset + size)
+        dst.resize(offset + size);
+    memcpy(dst.data() + offset, data, size);
+}
+
+void RenderBackendNull::updateDrawStats(Topology type, uint32_t numberOfElements, uint32_t instancesCount)
+{
+    m_frameStats.drawCalls++;
+    switch (type)
+    {
+    case Topology::LINES:
+        m_frameStats.totalLines += numberOfElements / 2 * instancesCount;
+        break;
+    case Topology::TRIANGLES:
+        m_frameStats.totalTriangles += numberOfElements / 3 * instancesCount;
+        break;
+    case Topology::TRIANGLE_STRIP:
+        if (numberOfElements >= 3)
+            m_frameStats.totalTriangles += (numberOfElements - 2) * instancesCount;
+        break;
+    default:
+        break;
+    }
+}
+
+RenderBackendNull::RenderBackendNull()
+    : m_vertexBuffersBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_indexBuffersBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_texturesBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_gpuProgramsBag(MemoryManager::allocTagged(MEMORY_TAG_RENDER)),
+    m_commands(MemoryManager::allocTagged(MEMORY_TAG_RENDER))
+{
+    m_caps.maxTextureSize = 4096;
+    m_caps.maxAnisotropy = 1.0f;
+    m_caps.instancing = true;
+    m_caps.indices32 = true;
+
+    clearCommands();
+}
+
+RenderBackendNull::~RenderBackendNull()
+{
+    DF3D_ASSERT(m_vertexBuffersBag.empty());
+    DF3D_ASSERT(m_indexBuffersBag.empty());
+    DF3D_ASSERT(m_texturesBag.empty());
+    DF3D_ASSERT(m_gpuProgramsBag.empty());
+}
+
+void RenderBackendNull::clearCommands()
+{
+    m_commands.clear();
+    for (auto &count : m_commandsCount)
+        count = 0;
+}
+
+const char* RenderBackendNull::GetCommandName(RecordedCommandType type)
+{
+    switch (type)
+    {
+    case RecordedCommandType::FRAME_BEGIN:
+        return "frameBegin";
+    case RecordedCommandType::FRAME_END:
+        return "frameEnd";
+    case RecordedCommandType::CREATE_VERTEX_BUFFER:
+        return "createVertexBuffer";
+    case RecordedCommandType::DESTROY_VERTEX_BUFFER:
+        return "destroyVertexBuffer";
+    case RecordedCommandType::BIND_VERTEX_BUFFER:
+        return "bindVertexBuffer";
+    case RecordedCommandType::UPDATE_VERTEX_BUFFER:
+        return "updateVertexBuffer";
+    case RecordedCommandType::CREATE_INDEX_BUFFER:
+        return "createIndexBuffer";
+    case RecordedCommandType::DESTROY_INDEX_BUFFER:
+        return "destroyIndexBuffer";
+    case RecordedCommandType::BIND_INDEX_BUFFER:
+        return "bindIndexBuffer";
+    case RecordedCommandType::CREATE_TEXTURE:
+        return "createTexture";
+    case RecordedCommandType::UPDATE_TEXTURE:
+        return "updateTexture";
+    case RecordedCommandType::DESTROY_TEXTURE:
+        return "destroyTexture";
+    case RecordedCommandType::BIND_TEXTURE:
+        return "bindTexture";
+    case RecordedCommandType::CREATE_GPU_PROGRAM:
+        return "createGPUProgram";
+    case RecordedCommandType::DESTROY_GPU_PROGRAM:
+        return "destroyGPUProgram";
+    case RecordedCommandType::BIND_GPU_PROGRAM:
+        return "bindGPUProgram";
+    case RecordedCommandType::SET_UNIFORM:
+        return "setUniformValue";
+    case RecordedCommandType::SET_VIEWPORT:
+        return "setViewport";
+    case RecordedCommandType::SET_SCISSOR_TEST:
+        return "setScissorTest";
+    case RecordedCommandType::SET_CLEAR_DATA:
+        return "setClearData";
+    case RecordedCommandType::SET_STATE:
+        return "setState";
+    case RecordedCommandType::DRAW:
+        return "draw";
+    case RecordedCommandType::DRAW_INSTANCED:
+        return "drawInstanced";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+RenderBackendCaps RenderBackendNull::getCaps()
+{
+    return m_caps;
+}
+
+FrameStats RenderBackendNull::getLastFrameStats()
+{
+    return m_frameStats;
+}
+
+void RenderBackendNull::frameBegin()
+{
+    clearCommands();
+
+    auto textures = m_frameStats.textures;
+    m_frameStats = {};
+    m_frameStats.textures = textures;
+
+    record(RecordedCommandType::FRAME_BEGIN);
+}
+
+void RenderBackendNull::frameEnd()
+{
+    record(RecordedCommandType::FRAME_END);
+}
+
+VertexBufferHandle RenderBackendNull::createStaticVertexBuffer(const VertexFormat &format, uint32_t numVertices, const void *data)
+{
+    VertexBufferHandle handle(m_vertexBuffersBag.getNew());
+    DF3D_ASSERT(handle.getIndex() < MAX_SIZE);
+
+    auto &buffer = m_vertexBuffers[handle.getIndex()];
+    buffer.data.clear();
+    buffer.elementSize = format.getVertexSize();
+    if (m_keepBuffersData)
+        KeepData(buffer.data, 0, data, numVertices * buffer.elementSize);
+
+    record(RecordedCommandType::CREATE_VERTEX_BUFFER, handle.getID(), numVertices);
+
+    return handle;
+}
+
+VertexBufferHandle RenderBackendNull::createDynamicVertexBuffer(const VertexFormat &format, uint32_t numVertices, const void *data)
+{
+    return createStaticVertexBuffer(format, numVertices, data);
+}
+
+void RenderBackendNull::destroyVertexBuffer(VertexBufferHandle handle)
+{
+    DF3D_ASSERT(m_vertexBuffersBag.isValid(handle.getID()));
+
+    m_vertexBuffersBag.release(handle.getID());
+    m_vertexBuffers[handle.getIndex()].data.clear();
+
+    record(RecordedCommandType::DESTROY_VERTEX_BUFFER, handle.getID());
+}
+
+void RenderBackendNull::bindVertexBuffer(VertexBufferHandle handle, uint32_t vertexStart)
+{
+    DF3D_ASSERT(m_vertexBuffersBag.isValid(handle.getID()));
+
+    m_indexedDrawCall = false;
+
+    m_frameStats.bindsIssued++;
+
+    record(RecordedCommandType::BIND_VERTEX_BUFFER, handle.getID(), vertexStart);
+}
+
+void RenderBackendNull::updateVertexBuffer(VertexBufferHandle handle, uint32_t vertexStart, uint32_t numVertices, const void *data)
+{
+    DF3D_ASSERT(m_vertexBuffersBag.isValid(handle.getID()));
+
+    auto &buffer = m_vertexBuffers[handle.getIndex()];
+    if (m_keepBuffersData)
+        KeepData(buffer.data, vertexStart * buffer.elementSize, data, numVertices * buffer.elementSize);
+
+    record(RecordedCommandType::UPDATE_VERTEX_BUFFER, handle.getID(), numVertices);
+}
+
+IndexBufferHandle RenderBackendNull::createIndexBuffer(uint32_t numIndices, const void *data, IndicesType indicesType)
+{
+    IndexBufferHandle handle(m_indexBuffersBag.getNew());
+    DF3D_ASSERT(handle.getIndex() < MAX_SIZE);
+
+    auto &buffer = m_indexBuffers[handle.getIndex()];
+    buffer.data.clear();
+    buffer.elementSize = indicesType == INDICES_16_BIT ? sizeof(uint16_t) : sizeof(uint32_t);
+    if (m_keepBuffersData)
+        KeepData(buffer.data, 0, data, numIndices * buffer.elementSize);
+
+    record(RecordedCommandType::CREATE_INDEX_BUFFER, handle.getID(), numIndices);
+
+    return handle;
+}
+
+void RenderBackendNull::destroyIndexBuffer(IndexBufferHandle handle)
+{
+    DF3D_ASSERT(m_indexBuffersBag.isValid(handle.getID()));
+
+    m_indexBuffersBag.release(handle.getID());
+    m_indexBuffers[handle.getIndex()].data.clear();
+
+    record(RecordedCommandType::DESTROY_INDEX_BUFFER, handle.getID());
+}
+
+void RenderBackendNull::bindIndexBuffer(IndexBufferHandle handle)
+{
+    DF3D_ASSERT(m_indexBuffersBag.isValid(handle.getID()));
+
+    m_indexedDrawCall = true;
+
+    m_frameStats.bindsIssued++;
+
+    record(RecordedCommandType::BIND_INDEX_BUFFER, handle.getID());
+}
+
+TextureHandle RenderBackendNull::createTexture(const TextureResourceData &data, uint32_t flags)
+{
+    TextureHandle handle(m_texturesBag.getNew());
+    DF3D_ASSERT(handle.getIndex() < MAX_SIZE);
+
+    m_frameStats.textures++;
+
+    record(RecordedCommandType::CREATE_TEXTURE, handle.getID(), flags);
+
+    return handle;
+}
+
+void RenderBackendNull::updateTexture(TextureHandle handle, int originX, int originY, int width, int height, const void *data)
+{
+    DF3D_ASSERT(m_texturesBag.isValid(handle.getID()));
+
+    record(RecordedCommandType::UPDATE_TEXTURE, handle.getID(), width * height);
+}
+
+void RenderBackendNull::destroyTexture(TextureHandle handle)
+{
+    DF3D_ASSERT(m_texturesBag.isValid(handle.getID()));
+
+    m_texturesBag.release(handle.getID());
+
+    DF3D_ASSERT(m_frameStats.textures > 0);
+    m_frameStats.textures--;
+
+    record(RecordedCommandType::DESTROY_TEXTURE, handle.getID());
+}
+
+void RenderBackendNull::bindTexture(GPUProgramHandle program, TextureHandle handle, UniformHandle textureUniform, int unit)
+{
+    DF3D_ASSERT(m_gpuProgramsBag.isValid(program.getID()));
+    DF3D_ASSERT(m_texturesBag.isValid(handle.getID()));
+
+    m_frameStats.bindsIssued++;
+
+    record(RecordedCommandType::BIND_TEXTURE, handle.getID(), unit);
+}
+
+GPUProgramHandle RenderBackendNull::createGPUProgram(const char *vertexShaderData, const char *fragmentShaderData)
+{
+    DF3D_ASSERT(vertexShaderData != nullptr && fragmentShaderData != nullptr);
+
+    GPUProgramHandle handle(m_gpuProgramsBag.getNew());
+    DF3D_ASSERT(handle.getIndex() < MAX_SIZE);
+
+    // Same opt-in rule as the GL backend.
+    auto &program = m_gpuPrograms[handle.getIndex()];
+    program.uniforms.clear();
+    program.instanced = strstr(vertexShaderData, "a_instanceWorld") != nullptr;
+
+    record(RecordedCommandType::CREATE_GPU_PROGRAM, handle.getID());
+
+    return handle;
+}
+
+void RenderBackendNull::destroyGPUProgram(GPUProgramHandle handle)
+{
+    DF3D_ASSERT(m_gpuProgramsBag.isValid(handle.getID()));
+
+    m_gpuPrograms[handle.getIndex()] = {};
+    m_gpuProgramsBag.release(handle.getID());
+
+    record(RecordedCommandType::DESTROY_GPU_PROGRAM, handle.getID());
+}
+
+void RenderBackendNull::bindGPUProgram(GPUProgramHandle handle)
+{
+    DF3D_ASSERT(m_gpuProgramsBag.isValid(handle.getID()));
+
+    m_frameStats.bindsIssued++;
+
+    record(RecordedCommandType::BIND_GPU_PROGRAM, handle.getID());
+}
+
+UniformHandle RenderBackendNull::getUniform(GPUProgramHandle program, const char *name)
+{
+    if (!m_gpuProgramsBag.isValid(program.getID()))
+    {
+        DF3D_ASSERT(false);
+        return {};
+    }
+
+    // There is no shader reflection, so any requested uniform is considered to be active.
+    auto &uniforms = m_gpuPrograms[program.getIndex()].uniforms;
+    for (size_t i = 0; i < uniforms.size(); i++)
+    {
+        if (uniforms[i] == name)
+            return UniformHandle(i + 1);  // Zero is reserved for invalid handle.
+    }
+
+    uniforms.push_back(name);
+
+    return UniformHandle(uniforms.size());
+}
+
+void RenderBackendNull::setUniformValue(GPUProgramHandle program, UniformHandle uniformHandle, const void *data)
+{
+    DF3D_ASSERT(m_gpuProgramsBag.isValid(program.getID()));
+    DF3D_ASSERT(uniformHandle.isValid() && uniformHandle.getID() <= m_gpuPrograms[program.getIndex()].uniforms.size());
+
+    m_frameStats.uniformsIssued++;
+
+    record(RecordedCommandType::SET_UNIFORM, program.getID(), uniformHandle.getID());
+}
+
+void RenderBackendNull::setViewport(const Viewport &viewport)
+{
+    record(RecordedCommandType::SET_VIEWPORT, viewport.width, viewport.height);
+}
+
+void RenderBackendNull::setScissorTest(bool enabled, const Viewport &rect)
+{
+    record(RecordedCommandType::SET_SCISSOR_TEST, enabled);
+}
+
+void RenderBackendNull::setClearData(const glm::vec3 &color, float depth)
+{
+    record(RecordedCommandType::SET_CLEAR_DATA);
+}
+
+void RenderBackendNull::setState(uint64_t state)
+{
+    m_frameStats.stateChangesIssued++;
+
+    record(RecordedCommandType::SET_STATE, (uint32_t)(state & 0xFFFFFFFF), (uint32_t)(state >> 32));
+}
+
+void RenderBackendNull::draw(Topology type, uint32_t numberOfElements)
+{
+    updateDrawStats(type, numberOfElements, 1);
+
+    record(RecordedCommandType::DRAW, numberOfElements, m_indexedDrawCall);
+}
+
+void RenderBackendNull::drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount)
+{
+    DF3D_ASSERT(instanceTransforms != nullptr && instancesCount > 0);
+
+    updateDrawStats(type, numberOfElements, instancesCount);
+
+    record(RecordedCommandType::DRAW_INSTANCED, numberOfElements, instancesCount);
+}
+
+bool RenderBackendNull::isInstancingSupported(GPUProgramHandle program)
+{
+    if (!m_gpuProgramsBag.isValid(program.getID()))
+        return false;
+
+    return m_gpuPrograms[program.getIndex()].instanced;
+}
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <df3d/engine/render/IRenderBackend.h>
+#include <df3d/lib/Handles.h>
+#include <df3d/lib/containers/PodArray.h>
+
+namespace df3d {
+
+enum class RecordedCommandType : uint8_t
+{
+    FRAME_BEGIN,
+    FRAME_END,
+
+    CREATE_VERTEX_BUFFER,
+    DESTROY_VERTEX_BUFFER,
+    BIND_VERTEX_BUFFER,
+    UPDATE_VERTEX_BUFFER,
+
+    CREATE_INDEX_BUFFER,
+    DESTROY_INDEX_BUFFER,
+    BIND_INDEX_BUFFER,
+
+    CREATE_TEXTURE,
+    UPDATE_TEXTURE,
+    DESTROY_TEXTURE,
+    BIND_TEXTURE,
+
+    CREATE_GPU_PROGRAM,
+    DESTROY_GPU_PROGRAM,
+    BIND_GPU_PROGRAM,
+    SET_UNIFORM,
+
+    SET_VIEWPORT,
+    SET_SCISSOR_TEST,
+    SET_CLEAR_DATA,
+    SET_STATE,
+
+    DRAW,
+    DRAW_INSTANCED,
+
+    COUNT
+};
+
+//! Compact entry of the command log. Arguments meaning depends on the command type,
+//! usually it's a handle id and an element count.
+struct RecordedCommand
+{
+    RecordedCommandType type;
+    uint32_t arg0;
+    uint32_t arg1;
+};
+
+//! Render backend which doesn't need any graphics context. All the resources are
+//! tracked in memory and every call is appended to a command log, so the CPU side
+//! of the renderer can be profiled and tested on machines without a GPU.
+class RenderBackendNull : public IRenderBackend
+{
+    struct NullProgram
+    {
+        std::vector<std::string> uniforms;
+        bool instanced = false;
+    };
+
+    struct NullBuffer
+    {
+        //! Only when keeping the data is enabled.
+        std::vector<uint8_t> data;
+        size_t elementSize = 0;
+    };
+
+    RenderBackendCaps m_caps;
+    FrameStats m_frameStats;
+
+    HandleBag m_vertexBuffersBag;
+    HandleBag m_indexBuffersBag;
+    HandleBag m_texturesBag;
+    HandleBag m_gpuProgramsBag;
+
+    enum {
+        MAX_SIZE = 0xFFF
+    };
+
+    NullProgram m_gpuPrograms[MAX_SIZE];
+    NullBuffer m_vertexBuffers[MAX_SIZE];
+    NullBuffer m_indexBuffers[MAX_SIZE];
+    bool m_keepBuffersData = false;
+    bool m_indexedDrawCall = false;
+
+    PodArray<RecordedCommand> m_commands;
+    uint32_t m_commandsCount[(size_t)RecordedCommandType::COUNT];
+    bool m_recordingEnabled = true;
+
+    void record(RecordedCommandType type, uint32_t arg0 = 0, uint32_t arg1 = 0);
+    void updateDrawStats(Topology type, uint32_t numberOfElements, uint32_t instancesCount);
+
+public:
+    RenderBackendNull();
+    ~RenderBackendNull();
+
+    //! Commands recorded since the last frameBegin (or since the last clearCommands).
+    const PodArray<RecordedCommand>& getCommands() const { return m_commands; }
+    uint32_t getCommandsCount(RecordedCommandType type) const { return m_commandsCount[(size_t)type]; }
+    void clearCommands();
+    //! Disables the log, only per type counters are updated.
+    void enableRecording(bool enable) { m_recordingEnabled = enable; }
+    //! Keeps a copy of the data given to the buffers created from now on, so uploads can be checked.
+    void keepBuffersData(bool keep) { m_keepBuffersData = keep; }
+    const std::vector<uint8_t>& getVertexBufferData(VertexBufferHandle handle) const { return m_vertexBuffers[handle.getIndex()].data; }
+    const std::vector<uint8_t>& getIndexBufferData(IndexBufferHandle handle) const { return m_indexBuffers[handle.getIndex()].data; }
+
+    static const char* GetCommandName(RecordedCommandType type);
+
+    RenderBackendCaps getCaps() override;
+    FrameStats getLastFrameStats() override;
+
+    void frameBegin() override;
+    void frameEnd() override;
+
+    VertexBufferHandle createStaticVertexBuffer(const VertexFormat &format, uint32_t numVertices, const void *data) override;
+    VertexBufferHandle createDynamicVertexBuffer(const VertexFormat &format, uint32_t numVertices, const void *data) override;
+    void destroyVertexBuffer(VertexBufferHandle handle) override;
+    void bindVertexBuffer(VertexBufferHandle handle, uint32_t vertexStart) override;
+    void updateVertexBuffer(VertexBufferHandle handle, uint32_t vertexStart, uint32_t numVertices, const void *data) override;
+
+    IndexBufferHandle createIndexBuffer(uint32_t numIndices, const void *data, IndicesType indicesType) override;
+    void destroyIndexBuffer(IndexBufferHandle handle) override;
+    void bindIndexBuffer(IndexBufferHandle handle) override;
+
+    TextureHandle createTexture(const TextureResourceData &data, uint32_t flags) override;
+    void updateTexture(TextureHandle handle, int originX, int originY, int width, int height, const void *data) override;
+    void destroyTexture(TextureHandle handle) override;
+
+    void bindTexture(GPUProgramHandle program, TextureHandle handle, UniformHandle textureUniform, int unit) override;
+
+    GPUProgramHandle createGPUProgram(const char *vertexShaderData, const char *fragmentShaderData) override;
+    void destroyGPUProgram(GPUProgramHandle handle) override;
+    void bindGPUProgram(GPUProgramHandle handle) override;
+
+    UniformHandle getUniform(GPUProgramHandle program, const char *name) override;
+    void setUniformValue(GPUProgramHandle program, UniformHandle uniformHandle, const void *data) override;
+
+    void setViewport(const Viewport &viewport) override;
+    void setScissorTest(bool enabled, const Viewport &rect) override;
+
+    void setClearData(const glm::vec3 &color, float depth) override;
+
+    void setState(uint64_t state) override;
+    void draw(Topology type, uint32_t numberOfElements) override;
+    void drawInstanced(Topology type, uint32_t numberOfElements, const glm::mat4 *instanceTransforms, uint32_t instancesCount) override;
+    bool isInstancingSupported(GPUProgramHandle program) override;
+
+    void setDestroyAndroidWorkaround() override { }
+    RenderBackendID getID() const override { return RenderBackendID::NULL_RECORDING; }
+};
+
+}
@@ -1,10 +1,14 @@
 #include "EntityResource.h"
 
+#include "ResourceDataSource.h"
+#include "ResourceFileSystem.h"
+#include "ResourceManager.h"
+#include <df3d/engine/EngineController.h>
 #include <df3d/lib/JsonUtils.h>
 
 namespace df3d {
 
-static void PreloadEntityData(const Json::Value &root, std::vector<std::string> &outDeps)
+void GetEntityDependencies(const Json::Value &root, std::vector<std::string> &outDeps)
 {
     if (root.isMember("components"))
     {
@@ -25,45 +29,191 @@ static void PreloadEntityData(const Json::Value &root, std::vector<std::string>
     if (root.isMember("children"))
     {
         for (const auto &child : root["children"])
-            PreloadEntityData(child, outDeps);
+            GetEntityDependencies(child, outDeps);
     }
 }
 
-void EntityHolder::listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps)
+static bool IsSectionValid(uint32_t offset, size_t size, size_t fileSize)
 {
-    auto root = JsonUtils::fromFile(dataSource);
-    if (root.isNull())
-        return;
+    return offset % DFENTITY_ALIGNMENT == 0 && offset <= fileSize && size <= fileSize - offset;
+}
+
+static bool ValidateCompiledEntity(const uint8_t *binary, size_t fileSize)
+{
+    DFEntityHeader header;
+    memcpy(&header, binary, sizeof(header));
+
+    if (!IsSectionValid(header.entitiesOffset, header.entitiesCount * sizeof(DFEntityRecord), fileSize) ||
+        !IsSectionValid(header.componentsOffset, header.componentsCount * sizeof(DFEntityComponentRecord), fileSize) ||
+        !IsSectionValid(header.dependenciesOffset, header.dependenciesCount * sizeof(uint32_t), fileSize) ||
+        !IsSectionValid(header.stringsOffset, header.stringsSize, fileSize) ||
+        !IsSectionValid(header.settingsOffset, header.settingsSize, fileSize) ||
+        !IsSectionValid(header.dataOffset, header.dataSize, fileSize))
+        return false;
+
+    if (header.stringsSize > 0 && binary[header.stringsOffset + header.stringsSize - 1] != 0)
+        return false;
+
+    auto entities = reinterpret_cast<const DFEntityRecord *>(binary + header.entitiesOffset);
+    for (uint32_t i = 0; i < header.entitiesCount; i++)
+    {
+        const auto &entity = entities[i];
+        if (entity.parent != DFENTITY_NO_PARENT && entity.parent >= i)
+            return false;
+        if (entity.firstComponent > header.componentsCount || entity.componentsCount > header.componentsCount - entity.firstComponent)
+            return false;
+    }
+
+    auto components = reinterpret_cast<const DFEntityComponentRecord *>(binary + header.componentsOffset);
+    for (uint32_t i = 0; i < header.componentsCount; i++)
+    {
+        const auto &component = components[i];
+        if (component.dataOffset > header.dataSize || component.dataSize > header.dataSize - component.dataOffset)
+            return false;
+    }
+
+    auto dependencies = reinterpret_cast<const uint32_t *>(binary + header.dependenciesOffset);
+    for (uint32_t i = 0; i < header.dependenciesCount; i++)
+    {
+        if (dependencies[i] >= header.stringsSize)
+            return false;
+    }
 
-    PreloadEntityData(root, outDeps);
+    return true;
 }
 
-bool EntityHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
+static bool DecodeCompiledEntity(ResourceDataSource &dataSource, EntityResource &resource)
 {
-    auto root = JsonUtils::fromFile(dataSource);
-    if (root.isNull())
+    const size_t size = dataSource.getSize();
+
+    // Used in place when the source is in memory, e.g. an uncompressed archive entry.
+    auto view = dataSource.getContiguousView();
+    if (view && reinterpret_cast<uintptr_t>(view) % DFENTITY_ALIGNMENT == 0)
+    {
+        resource.binary = view;
+    }
+    else
+    {
+        resource.binaryStorage.resize(size);
+        if (!dataSource.seek(0, SeekDir::BEGIN) || dataSource.read(resource.binaryStorage.data(), size) != size)
+            return false;
+
+        resource.binary = resource.binaryStorage.data();
+    }
+
+    resource.binarySize = size;
+
+    if (!ValidateCompiledEntity(resource.binary, resource.binarySize))
         return false;
 
-    m_resource = MAKE_NEW(allocator, EntityResource)();
-    m_resource->root = std::move(root);
-    m_resource->isWorld = m_isWorldResource;
+    if (resource.binary == view)
+        resource.viewSource = &dataSource;
+
+    DFEntityHeader header;
+    memcpy(&header, resource.binary, sizeof(header));
+
+#ifdef _DEBUG
+    auto strings = reinterpret_cast<const char *>(resource.binary + header.stringsOffset);
+    for (auto str = strings; str < strings + header.stringsSize; str += strlen(str) + 1)
+        Id registered(str);
+#endif
+
+    if (header.settingsSize > 0)
+    {
+        auto settings = reinterpret_cast<const char *>(resource.binary + header.settingsOffset);
+        resource.root = JsonUtils::fromString(std::string(settings, header.settingsSize));
+        if (resource.root.isNull())
+            return false;
+    }
 
     return true;
 }
 
-void EntityHolder::decodeCleanup(Allocator &allocator)
+static void DestroyEntityResource(EntityResource *resource, Allocator &allocator)
+{
+    if (resource->viewSource)
+        svc().resourceManager().getFS().close(resource->viewSource);
+    MAKE_DELETE(allocator, resource);
+}
+
+bool EntityHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
+{
+    DFEntityHeader header;
+    bool compiled = dataSource.read(&header, sizeof(header)) == sizeof(header) &&
+        memcmp(&header.magic, DFENTITY_MAGIC, sizeof(header.magic)) == 0;
+
+    m_decoded = MAKE_NEW(allocator, EntityResource)();
+    m_decoded->isWorld = m_isWorldResource;
+    m_cpuMemoryUsage = sizeof(EntityResource) + dataSource.getSize();
+
+    bool result = false;
+    if (compiled)
+    {
+        if (header.version == DFENTITY_VERSION)
+            result = DecodeCompiledEntity(dataSource, *m_decoded);
+
+        if (!result)
+            DFLOG_WARN("Invalid compiled entity");
+    }
+    else if (dataSource.seek(0, SeekDir::BEGIN))
+    {
+        m_decoded->root = JsonUtils::fromFile(dataSource);
+        result = !m_decoded->root.isNull();
+    }
+
+    if (!result)
+    {
+        // The data source is closed by the caller on failure.
+        m_decoded->viewSource = nullptr;
+        MAKE_DELETE(allocator, m_decoded);
+        m_decoded = nullptr;
+    }
+
+    return result;
+}
+
+void EntityHolder::listDependencies(std::vector<std::string> &outDeps)
 {
+    auto binary = m_decoded->binary;
+    if (!binary)
+    {
+        GetEntityDependencies(m_decoded->root, outDeps);
+        return;
+    }
+
+    DFEntityHeader header;
+    memcpy(&header, binary, sizeof(header));
 
+    auto strings = reinterpret_cast<const char *>(binary + header.stringsOffset);
+    auto dependencies = reinterpret_cast<const uint32_t *>(binary + header.dependenciesOffset);
+    for (uint32_t i = 0; i < header.dependenciesCount; i++)
+        outDeps.push_back(strings + dependencies[i]);
+}
+
+void EntityHolder::decodeCleanup(Allocator &allocator)
+{
+    // Not created, all the users have been released while decoding.
+    if (m_decoded)
+    {
+        DestroyEntityResource(m_decoded, allocator);
+        m_decoded = nullptr;
+    }
 }
 
 bool EntityHolder::createResource(Allocator &allocator)
 {
+    // Resources are created under the resource manager lock.
+    static uint32_t generation = 0;
+
+    m_decoded->generation = ++generation;
+    m_resource = m_decoded;
+    m_decoded = nullptr;
     return true;
 }
 
 void EntityHolder::destroyResource(Allocator &allocator)
 {
-    MAKE_DELETE(allocator, m_resource);
+    DestroyEntityResource(m_resource, allocator);
     m_resource = nullptr;
 }
 
@@ -5,25 +5,117 @@
 
 namespace df3d {
 
+const char DFENTITY_MAGIC[4] = { 'D', 'F', 'E', 'N' };
+const uint16_t DFENTITY_VERSION = 1;
+//! Sections and component data are aligned to this value.
+const uint32_t DFENTITY_ALIGNMENT = 4;
+const uint32_t DFENTITY_NO_PARENT = 0xFFFFFFFF;
+
+// Compiled .entity or .world, see tools/entity_compiler.
+// File format:
+// |------------------------------------------------|
+// | DFEntityHeader                                 |
+// |------------------------------------------------|
+// | DFEntityRecord * entitiesCount, parents first  |
+// |------------------------------------------------|
+// | DFEntityComponentRecord * componentsCount      |
+// |------------------------------------------------|
+// | dependencies, offsets in the strings table     |
+// |------------------------------------------------|
+// | null terminated strings                        |
+// |------------------------------------------------|
+// | world settings json                            |
+// |------------------------------------------------|
+// | components data                                |
+// |------------------------------------------------|
+
+enum DFEntityComponentFlags
+{
+    //! Data is the component json, its loader doesn't support compiling.
+    DFENTITY_COMPONENT_JSON = 1 << 0
+};
+
+#pragma pack(push, 1)
+
+struct DFEntityHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+
+    uint32_t entitiesCount;
+    uint32_t entitiesOffset;
+    uint32_t componentsCount;
+    uint32_t componentsOffset;
+    uint32_t dependenciesCount;
+    uint32_t dependenciesOffset;
+    //! Strings the ids are made of, registered in debug builds to keep Id::toString working.
+    uint32_t stringsSize;
+    uint32_t stringsOffset;
+    //! World json without the entities.
+    uint32_t settingsSize;
+    uint32_t settingsOffset;
+    uint32_t dataSize;
+    uint32_t dataOffset;
+};
+
+struct DFEntityRecord
+{
+    //! Index of the parent entity, it always precedes its children.
+    uint32_t parent;
+    uint32_t firstComponent;
+    uint32_t componentsCount;
+};
+
+struct DFEntityComponentRecord
+{
+    //! Id of the component type.
+    uint32_t type;
+    uint32_t flags;
+    //! Offset in the components data.
+    uint32_t dataOffset;
+    uint32_t dataSize;
+};
+
+#pragma pack(pop)
+
 struct EntityResource
 {
+    //! World settings only when the resource is compiled.
     Json::Value root;
+    //! Compiled entity, nullptr for json ones. Points either to binaryStorage or in place to viewSource.
+    const uint8_t *binary = nullptr;
+    size_t binarySize = 0;
+    std::vector<uint8_t> binaryStorage;
+    //! Source the binary is used in place from when it's in memory, closed with the resource.
+    ResourceDataSource *viewSource = nullptr;
+    //! Unique for each created resource, tells a reloaded resource from the one it replaced.
+    uint32_t generation = 0;
     bool isWorld;
 };
 
+//! Lists the resources an entity json refers to.
+void GetEntityDependencies(const Json::Value &root, std::vector<std::string> &outDeps);
+
 class EntityHolder : public IResourceHolder
 {
+    //! Moved to m_resource on creation, dropped by decodeCleanup if never created.
+    EntityResource *m_decoded = nullptr;
     EntityResource *m_resource;
     bool m_isWorldResource;
+    size_t m_cpuMemoryUsage = 0;
 
 public:
     EntityHolder(bool isWorldResource) : m_resource(0), m_isWorldResource(isWorldResource) { }
 
-    void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps) override;
     bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) override;
+    bool keepsDataSource() override { return m_decoded && m_decoded->viewSource; }
+    void listDependencies(std::vector<std::string> &outDeps) override;
     void decodeCleanup(Allocator &allocator) override;
     bool createResource(Allocator &allocator) override;
     void destroyResource(Allocator &allocator) override;
+    //! Size of the source, the parsed json takes about as much.
+    size_t getCpuMemoryUsage() override { return m_cpuMemoryUsage; }
 
     void* getResource() override { return m_resource; }
 };
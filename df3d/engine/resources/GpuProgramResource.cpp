@@ -106,7 +106,7 @@ bool GpuProgramHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &
     }
 
     auto backendID = svc().renderManager().getBackendID();
-    if (backendID == RenderBackendID::GL)
+    if (backendID != RenderBackendID::METAL)
     {
         DF3D_ASSERT(root.isMember("vertex") && root.isMember("fragment"));
 
@@ -134,8 +134,9 @@ void GpuProgramHolder::decodeCleanup(Allocator &allocator)
 bool GpuProgramHolder::createResource(Allocator &allocator)
 {
     auto backendID = svc().renderManager().getBackendID();
-    if (backendID == RenderBackendID::GL)
+    if (backendID != RenderBackendID::METAL)
     {
+        // Null backend consumes GLSL programs as well.
         auto getShaderData = [](const std::string &filePath) {
             std::string result;
 
@@ -27,8 +27,8 @@ class GpuProgramHolder : public IResourceHolder
     std::vector<std::string> m_uniformNames;
 
 public:
-    void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps) override { }
     bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) override;
+    void listDependencies(std::vector<std::string> &outDeps) override { }
     void decodeCleanup(Allocator &allocator) override;
     bool createResource(Allocator &allocator) override;
     void destroyResource(Allocator &allocator) override;
@@ -11,11 +11,20 @@ public:
     IResourceHolder() = default;
     virtual ~IResourceHolder() = default;
 
-    virtual void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps) = 0;
     virtual bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) = 0;
+    //! Called after a successful decodeStartup. The holder may keep the data source to use its memory
+    //! in place, it's closed by the holder then rather than right after decoding.
+    virtual bool keepsDataSource() { return false; }
+    //! Called after a successful decodeStartup. Lists resources to be created before this one.
+    virtual void listDependencies(std::vector<std::string> &outDeps) = 0;
     virtual void decodeCleanup(Allocator &allocator) = 0;
+    //! Approximate size of the data createResource sends to the GPU.
+    virtual size_t getUploadSize() { return 0; }
     virtual bool createResource(Allocator &allocator) = 0;
     virtual void destroyResource(Allocator &allocator) = 0;
+    //! Approximate memory held by the created resource.
+    virtual size_t getCpuMemoryUsage() { return 0; }
+    virtual size_t getGpuMemoryUsage() { return 0; }
 
     virtual void* getResource() = 0;
 };
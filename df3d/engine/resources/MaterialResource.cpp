@@ -205,13 +205,20 @@ const Material* MaterialLibResource::getMaterial(Id name) const
     return nullptr;
 }
 
-void MaterialLibHolder::listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps)
+bool MaterialLibHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
 {
     auto root = JsonUtils::fromFile(dataSource);
     if (root.isNull())
-        return;
+        return false;
 
-    for (const auto &jsonMaterial : root["materials"])
+    m_root = MAKE_NEW(allocator, Json::Value)(std::move(root));
+
+    return true;
+}
+
+void MaterialLibHolder::listDependencies(std::vector<std::string> &outDeps)
+{
+    for (const auto &jsonMaterial : (*m_root)["materials"])
     {
         const auto &jsonTechniques = jsonMaterial["techniques"];
 
@@ -221,17 +228,6 @@ void MaterialLibHolder::listDependencies(ResourceDataSource &dataSource, std::ve
     }
 }
 
-bool MaterialLibHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
-{
-    auto root = JsonUtils::fromFile(dataSource);
-    if (root.isNull())
-        return false;
-
-    m_root = MAKE_NEW(allocator, Json::Value)(std::move(root));
-
-    return true;
-}
-
 void MaterialLibHolder::decodeCleanup(Allocator &allocator)
 {
     MAKE_DELETE(allocator, m_root);
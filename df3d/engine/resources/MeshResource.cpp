@@ -5,7 +5,6 @@
 #include "loaders/MeshLoader_assxml.h"
 #include "ResourceFileSystem.h"
 #include "ResourceDataSource.h"
-#include <df3d/engine/physics/PhysicsHelpers.h>
 #include <df3d/engine/EngineController.h>
 #include <df3d/engine/io/FileSystemHelpers.h>
 #include <df3d/engine/resources/ResourceManager.h>
@@ -13,57 +12,13 @@
 #include <df3d/engine/resources/ResourceDataSource.h>
 #include <df3d/engine/render/RenderManager.h>
 #include <df3d/engine/render/IRenderBackend.h>
+#include <df3d/lib/JobSystem.h>
 #include <df3d/lib/JsonUtils.h>
 
 #include <btBulletCollisionCommon.h>
-#include <btBulletDynamicsCommon.h>
 
 namespace df3d {
 
-static btTriangleMesh* CreateBulletTriangleMesh(MeshResourceData *resource, Allocator &allocator)
-{
-    auto bulletMesh = MAKE_NEW(allocator, btTriangleMesh)(true, false);
-
-    for (size_t smIdx = 0; smIdx < resource->parts.size(); smIdx++)
-    {
-        auto &submesh = resource->parts[smIdx];
-        auto &vdata = submesh->vertexData;
-
-        bulletMesh->preallocateVertices(vdata.getVerticesCount());
-
-        if (submesh->indexData.size() > 0)
-        {
-            bulletMesh->preallocateIndices(submesh->indexData.size());
-
-            for (size_t i = 0; i < submesh->indexData.size(); i += 3)
-            {
-                auto i1 = submesh->indexData[i + 0];
-                auto i2 = submesh->indexData[i + 1];
-                auto i3 = submesh->indexData[i + 2];
-
-                auto v1 = (glm::vec3*)vdata.getVertexAttribute(i1, VertexFormat::POSITION);
-                auto v2 = (glm::vec3*)vdata.getVertexAttribute(i2, VertexFormat::POSITION);
-                auto v3 = (glm::vec3*)vdata.getVertexAttribute(i3, VertexFormat::POSITION);
-
-                bulletMesh->addTriangle(PhysicsHelpers::glmTobt(*v1), PhysicsHelpers::glmTobt(*v2), PhysicsHelpers::glmTobt(*v3));
-            }
-        }
-        else
-        {
-            for (size_t i = 0; i < vdata.getVerticesCount(); i += 3)
-            {
-                auto v1 = (glm::vec3*)vdata.getVertexAttribute(i + 0, VertexFormat::POSITION);
-                auto v2 = (glm::vec3*)vdata.getVertexAttribute(i + 1, VertexFormat::POSITION);
-                auto v3 = (glm::vec3*)vdata.getVertexAttribute(i + 2, VertexFormat::POSITION);
-
-                bulletMesh->addTriangle(PhysicsHelpers::glmTobt(*v1), PhysicsHelpers::glmTobt(*v2), PhysicsHelpers::glmTobt(*v3));
-            }
-        }
-    }
-
-    return bulletMesh;
-}
-
 static MeshResourceData *LoadMeshDataFromFile(const char *path, Allocator &allocator)
 {
     auto meshDataSource = svc().resourceManager().getFS().open(path);
@@ -72,13 +27,21 @@ static MeshResourceData *LoadMeshDataFromFile(const char *path, Allocator &alloc
 
     MeshResourceData *result = nullptr;
     if (FileSystemHelpers::compareExtension(path, ".obj"))
-        result = MeshLoader_obj(*meshDataSource, allocator);
+        result = MeshLoader_obj(*meshDataSource, allocator, &svc().jobs());
     else if (FileSystemHelpers::compareExtension(path, ".dfmesh"))
         result = MeshLoader_dfmesh(*meshDataSource, allocator);
     else
         DF3D_ASSERT_MESS(false, "Unsupported mesh file format!");
 
-    svc().resourceManager().getFS().close(meshDataSource);
+    // The data may reference the source memory, keep it open until the data is released.
+    bool usesView = result && std::any_of(result->parts.begin(), result->parts.end(), [](const MeshResourceData::Part *part) {
+        return part->vertexData.isView() || part->indexView;
+    });
+
+    if (usesView)
+        result->viewSource = meshDataSource;
+    else
+        svc().resourceManager().getFS().close(meshDataSource);
 
     return result;
 }
@@ -96,34 +59,184 @@ static AnimatedMeshResourceData *LoadAnimMeshDataFromFile(const char *path, Allo
     return result;
 }
 
-static void BoundingVolumeFromGeometry(BoundingVolume *volume, const MeshResourceData &resource)
+template<typename Parts>
+static size_t GetPartsSize(const Parts &parts)
+{
+    size_t result = 0;
+    for (const auto &part : parts)
+        result += part->vertexData.getSizeInBytes() + part->getIndicesCount() * part->getIndexSize();
+    return result;
+}
+
+template<typename Parts>
+static bool CheckIndicesSupported(const Parts &parts)
 {
-    volume->reset();
+    if (svc().renderManager().getBackend().getCaps().indices32)
+        return true;
 
-    // Compute volume.
-    for (const auto &meshpart : resource.parts)
+    for (const auto &part : parts)
     {
-        const auto &vertexData = meshpart->vertexData;
+        if (part->getIndicesCount() > 0 && part->indicesType == INDICES_32_BIT)
+        {
+            DFLOG_WARN("Mesh part '%s' needs 32-bit indices which are not supported", part->materialName.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename T>
+static void AppendIndices(const T *indices, size_t count, uint32_t baseVertex, std::vector<uint32_t> &output)
+{
+    for (size_t i = 0; i < count - count % 3; i++)
+        output.push_back(baseVertex + indices[i]);
+}
+
+static size_t GetAnimationSize(const AnimatedMeshNode &node)
+{
+    size_t result = sizeof(node) + node.animation.size() * sizeof(AnimationFrameData);
+    for (const auto &child : node.children)
+        result += GetAnimationSize(*child);
+    return result;
+}
+
+static void DestroyBvh(btOptimizedBvh *bvh, Allocator &allocator)
+{
+    // Constructed in place by deSerializeInPlace.
+    bvh->~btOptimizedBvh();
+    allocator.dealloc(bvh);
+}
+
+void ProcessMeshGeometry(const MeshResourceData &resource, MeshCollisionData &collision, AABB &aabb, BoundingSphere &sphere)
+{
+    aabb.reset();
+    sphere.reset();
+
+    size_t verticesCount = 0, indicesCount = 0;
+    for (const auto part : resource.parts)
+    {
+        verticesCount += part->vertexData.getVerticesCount();
+        indicesCount += part->getIndicesCount() > 0 ? part->getIndicesCount() : part->vertexData.getVerticesCount();
+    }
+
+    collision.positions.reserve(verticesCount);
+    collision.indices.reserve(indicesCount);
+
+    for (const auto part : resource.parts)
+    {
+        const auto &vertexData = part->vertexData;
+        if (!vertexData.getFormat().hasAttribute(VertexFormat::POSITION))
+            continue;
+
+        auto baseVertex = (uint32_t)collision.positions.size();
 
         for (size_t i = 0; i < vertexData.getVerticesCount(); i++)
         {
-            auto &vdata = const_cast<VertexData&>(vertexData);
-            auto v = (glm::vec3*)vdata.getVertexAttribute(i, VertexFormat::POSITION);
+            auto v = *(const glm::vec3*)vertexData.getVertexAttribute(i, VertexFormat::POSITION);
+
+            collision.positions.push_back(v);
+            aabb.updateBounds(v);
+            sphere.updateBounds(v);
+        }
 
-            if (v)
-                volume->updateBounds(*v);
+        auto indices = part->getIndices();
+        auto partIndicesCount = part->getIndicesCount();
+        if (partIndicesCount > 0)
+        {
+            if (part->indicesType == INDICES_16_BIT)
+                AppendIndices((const uint16_t *)indices, partIndicesCount, baseVertex, collision.indices);
+            else
+                AppendIndices((const uint32_t *)indices, partIndicesCount, baseVertex, collision.indices);
+        }
+        else
+        {
+            auto count = vertexData.getVerticesCount();
+            for (size_t i = 0; i < count - count % 3; i++)
+                collision.indices.push_back(baseVertex + (uint32_t)i);
         }
     }
 }
 
-void MeshHolder::listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps)
+const ConvexHull& MeshCollisionData::getConvexHull() const
 {
-    auto root = JsonUtils::fromFile(dataSource);
-    if (root.isNull())
-        return;
+    if (!m_convexHullBuilt)
+    {
+        m_convexHull.constructFromPoints(positions.data(), positions.size(), MemoryManager::allocTagged(MEMORY_TAG_PHYSICS));
+        m_convexHullBuilt = true;
+    }
 
-    if (root.isMember("material_lib"))
-        outDeps.push_back(root["material_lib"].asString());
+    return m_convexHull;
+}
+
+void MeshCollisionData::setConvexHull(ConvexHull &&hull)
+{
+    m_convexHull = std::move(hull);
+    m_convexHullBuilt = true;
+}
+
+btStridingMeshInterface* MeshCollisionData::createMeshInterface(Allocator &allocator) const
+{
+    btIndexedMesh part;
+    part.m_numTriangles = (int)indices.size() / 3;
+    part.m_triangleIndexBase = (const unsigned char *)indices.data();
+    part.m_triangleIndexStride = 3 * sizeof(uint32_t);
+    part.m_numVertices = (int)positions.size();
+    part.m_vertexBase = (const unsigned char *)positions.data();
+    part.m_vertexStride = sizeof(glm::vec3);
+    part.m_indexType = PHY_INTEGER;
+    part.m_vertexType = PHY_FLOAT;
+
+    auto result = MAKE_NEW(allocator, btTriangleIndexVertexArray)();
+    result->addIndexedMesh(part, PHY_INTEGER);
+
+    return result;
+}
+
+const void* MeshResourceData::Part::getIndices() const
+{
+    if (indexView)
+        return indexView;
+    if (indicesType == INDICES_16_BIT)
+        return indexData16.data();
+    return indexData32.data();
+}
+
+size_t MeshResourceData::Part::getIndicesCount() const
+{
+    if (indexView)
+        return indexViewCount;
+    return indicesType == INDICES_16_BIT ? indexData16.size() : indexData32.size();
+}
+
+void MeshResourceData::Part::setIndices(const uint32_t *indices, size_t count)
+{
+    indexView = nullptr;
+    indexViewCount = 0;
+    indexData16.clear();
+    indexData32.clear();
+
+    // 0xFFFF is left out, it's the primitive restart index.
+    auto maxIndex = count > 0 ? *std::max_element(indices, indices + count) : 0;
+    if (maxIndex < 0xFFFF)
+    {
+        indicesType = INDICES_16_BIT;
+        indexData16.resize(count);
+        for (size_t i = 0; i < count; i++)
+            indexData16[i] = (uint16_t)indices[i];
+    }
+    else
+    {
+        indicesType = INDICES_32_BIT;
+        indexData32.resize(count);
+        memcpy(indexData32.data(), indices, count * sizeof(uint32_t));
+    }
+}
+
+MeshResourceData::~MeshResourceData()
+{
+    if (viewSource)
+        svc().resourceManager().getFS().close(viewSource);
 }
 
 bool MeshHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
@@ -133,30 +246,82 @@ bool MeshHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &alloca
         return false;
 
     if (root.isMember("material_lib"))
-        m_materialLib = Id(root["material_lib"].asCString());
+        m_materialLib = root["material_lib"].asString();
 
     DF3D_ASSERT(root.isMember("path"));
 
     m_resourceData = LoadMeshDataFromFile(root["path"].asCString(), allocator);
+    if (!m_resourceData)
+        return false;
 
-    return m_resourceData != nullptr;
+    ProcessMeshGeometry(*m_resourceData, m_collision, m_localAABB, m_localBoundingSphere);
+
+    // Use whatever was precomputed by the tools.
+    if (m_resourceData->aabb.isValid())
+        m_localAABB = m_resourceData->aabb;
+    if (m_resourceData->boundingSphere.isValid())
+        m_localBoundingSphere = m_resourceData->boundingSphere;
+
+    if (!m_resourceData->convexHull.empty())
+    {
+        ConvexHull hull;
+        for (const auto &p : m_resourceData->convexHull)
+            hull.m_vertices.push_back({ p.x, p.y, p.z });
+        m_collision.setConvexHull(std::move(hull));
+    }
+
+    if (m_resourceData->bvhData)
+    {
+        m_collision.bvh = btOptimizedBvh::deSerializeInPlace(m_resourceData->bvhData, (unsigned)m_resourceData->bvhDataSize, false);
+        if (!m_collision.bvh)
+        {
+            DFLOG_WARN("Failed to deserialize mesh BVH");
+            allocator.dealloc(m_resourceData->bvhData);
+        }
+        m_resourceData->bvhData = nullptr;
+    }
+
+    return true;
+}
+
+void MeshHolder::listDependencies(std::vector<std::string> &outDeps)
+{
+    if (!m_materialLib.empty())
+        outDeps.push_back(m_materialLib);
 }
 
 void MeshHolder::decodeCleanup(Allocator &allocator)
 {
+    if (m_resourceData->bvhData)
+        allocator.dealloc(m_resourceData->bvhData);
+    if (m_collision.bvh)
+        DestroyBvh(m_collision.bvh, allocator);
+
     for (auto part : m_resourceData->parts)
         MAKE_DELETE(allocator, part);
     MAKE_DELETE(allocator, m_resourceData);
 
     m_resourceData = nullptr;
+
+    m_collision = {};
+}
+
+size_t MeshHolder::getUploadSize()
+{
+    return GetPartsSize(m_resourceData->parts);
 }
 
 bool MeshHolder::createResource(Allocator &allocator)
 {
-    m_resource = MAKE_NEW(allocator, MeshResource)();
-    m_resource->materialLibResourceId = m_materialLib;
+    if (!CheckIndicesSupported(m_resourceData->parts))
+        return false;
 
-    m_resource->physicsMeshInterface = CreateBulletTriangleMesh(m_resourceData, allocator);
+    m_resource = MAKE_NEW(allocator, MeshResource)();
+    m_resource->materialLibResourceId = Id(m_materialLib.c_str());
+    m_resource->localAABB = m_localAABB;
+    m_resource->localBoundingSphere = m_localBoundingSphere;
+    m_resource->collision = std::move(m_collision);
+    m_collision = {};
 
     auto &backend = svc().renderManager().getBackend();
 
@@ -165,16 +330,16 @@ bool MeshHolder::createResource(Allocator &allocator)
         m_resource->materialNames.push_back(Id(part->materialName.c_str()));
         MeshPart hwPart;
 
-        auto &vData = part->vertexData;
+        const auto &vData = part->vertexData;
         hwPart.vertexBuffer = backend.createStaticVertexBuffer(vData.getFormat(), vData.getVerticesCount(), vData.getRawData());
 
-        if (part->indexData.size() > 0)
+        if (part->getIndicesCount() > 0)
         {
-            hwPart.indexBuffer = backend.createIndexBuffer(part->indexData.size(),
-                                                           part->indexData.data(),
-                                                           INDICES_16_BIT);
+            hwPart.indexBuffer = backend.createIndexBuffer(part->getIndicesCount(),
+                                                           part->getIndices(),
+                                                           part->indicesType);
 
-            hwPart.numberOfElements = part->indexData.size();
+            hwPart.numberOfElements = part->getIndicesCount();
         }
         else
         {
@@ -184,9 +349,12 @@ bool MeshHolder::createResource(Allocator &allocator)
         m_resource->meshParts.push_back(hwPart);
     }
 
-    BoundingVolumeFromGeometry(&m_resource->localAABB, *m_resourceData);
-    BoundingVolumeFromGeometry(&m_resource->localBoundingSphere, *m_resourceData);
-    m_resource->convexHull.constructFromGeometry(*m_resourceData, allocator);
+    const auto &collision = m_resource->collision;
+    m_cpuMemoryUsage = sizeof(MeshResource) + collision.positions.size() * sizeof(glm::vec3) +
+        collision.indices.size() * sizeof(uint32_t);
+    if (collision.bvh)
+        m_cpuMemoryUsage += collision.bvh->calculateSerializeBufferSize();
+    m_gpuMemoryUsage = getUploadSize();
 
     return true;
 }
@@ -200,21 +368,13 @@ void MeshHolder::destroyResource(Allocator &allocator)
             svc().renderManager().getBackend().destroyIndexBuffer(hwPart.indexBuffer);
     }
 
-    MAKE_DELETE(allocator, m_resource->physicsMeshInterface);
+    if (m_resource->collision.bvh)
+        DestroyBvh(m_resource->collision.bvh, allocator);
+
     MAKE_DELETE(allocator, m_resource);
     m_resource = nullptr;
 }
 
-void AnimatedMeshHolder::listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps)
-{
-    auto root = JsonUtils::fromFile(dataSource);
-    if (root.isNull())
-        return;
-
-    if (root.isMember("material_lib"))
-        outDeps.push_back(root["material_lib"].asString());
-}
-
 bool AnimatedMeshHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
 {
     auto root = JsonUtils::fromFile(dataSource);
@@ -222,7 +382,7 @@ bool AnimatedMeshHolder::decodeStartup(ResourceDataSource &dataSource, Allocator
         return false;
 
     if (root.isMember("material_lib"))
-        m_materialLib = Id(root["material_lib"].asCString());
+        m_materialLib = root["material_lib"].asString();
 
     DF3D_ASSERT(root.isMember("path"));
 
@@ -231,16 +391,30 @@ bool AnimatedMeshHolder::decodeStartup(ResourceDataSource &dataSource, Allocator
     return m_resourceData != nullptr;
 }
 
+void AnimatedMeshHolder::listDependencies(std::vector<std::string> &outDeps)
+{
+    if (!m_materialLib.empty())
+        outDeps.push_back(m_materialLib);
+}
+
 void AnimatedMeshHolder::decodeCleanup(Allocator &allocator)
 {
     MAKE_DELETE(allocator, m_resourceData);
     m_resourceData = nullptr;
 }
 
+size_t AnimatedMeshHolder::getUploadSize()
+{
+    return GetPartsSize(m_resourceData->parts);
+}
+
 bool AnimatedMeshHolder::createResource(Allocator &allocator)
 {
+    if (!CheckIndicesSupported(m_resourceData->parts))
+        return false;
+
     m_resource = MAKE_NEW(allocator, AnimatedMeshResource)();
-    m_resource->materialLibResourceId = m_materialLib;
+    m_resource->materialLibResourceId = Id(m_materialLib.c_str());
     m_resource->root = m_resourceData->root;
 
     auto &backend = svc().renderManager().getBackend();
@@ -250,16 +424,16 @@ bool AnimatedMeshHolder::createResource(Allocator &allocator)
         m_resource->materialNames.push_back(Id(part->materialName.c_str()));
         MeshPart hwPart;
 
-        auto &vData = part->vertexData;
+        const auto &vData = part->vertexData;
         hwPart.vertexBuffer = backend.createStaticVertexBuffer(vData.getFormat(), vData.getVerticesCount(), vData.getRawData());
 
-        if (part->indexData.size() > 0)
+        if (part->getIndicesCount() > 0)
         {
-            hwPart.indexBuffer = backend.createIndexBuffer(part->indexData.size(),
-                                                           part->indexData.data(),
-                                                           INDICES_16_BIT);
+            hwPart.indexBuffer = backend.createIndexBuffer(part->getIndicesCount(),
+                                                           part->getIndices(),
+                                                           part->indicesType);
 
-            hwPart.numberOfElements = part->indexData.size();
+            hwPart.numberOfElements = part->getIndicesCount();
         }
         else
         {
@@ -269,6 +443,11 @@ bool AnimatedMeshHolder::createResource(Allocator &allocator)
         m_resource->meshParts.push_back(hwPart);
     }
 
+    m_cpuMemoryUsage = sizeof(AnimatedMeshResource);
+    if (m_resource->root)
+        m_cpuMemoryUsage += GetAnimationSize(*m_resource->root);
+    m_gpuMemoryUsage = getUploadSize();
+
     return true;
 }
 
@@ -7,23 +7,51 @@
 #include <df3d/lib/math/ConvexHull.h>
 #include "IResourceHolder.h"
 
-class btTriangleIndexVertexArray;
+class btStridingMeshInterface;
+class btOptimizedBvh;
 
 namespace df3d {
 
-struct MeshResourceData
+class ResourceDataSource;
+
+struct MeshResourceData : private NonCopyable
 {
     struct Part
     {
         VertexData vertexData;
-        PodArray<uint16_t> indexData;
-        IndicesType indicesType;
+        //! Only the array matching indicesType is used.
+        PodArray<uint16_t> indexData16;
+        PodArray<uint32_t> indexData32;
+        //! Not owned indices of indicesType used instead of the arrays, see VertexData::setView.
+        const void *indexView = nullptr;
+        size_t indexViewCount = 0;
+        IndicesType indicesType = INDICES_16_BIT;
         std::string materialName;
 
-        Part(const VertexFormat &vf, Allocator &alloc) : vertexData(vf), indexData(alloc) { }
+        Part(const VertexFormat &vf, Allocator &alloc) : vertexData(vf), indexData16(alloc), indexData32(alloc) { }
+
+        const void* getIndices() const;
+        size_t getIndicesCount() const;
+        size_t getIndexSize() const { return indicesType == INDICES_16_BIT ? sizeof(uint16_t) : sizeof(uint32_t); }
+        //! Stores the indices as 16-bit ones when they fit.
+        void setIndices(const uint32_t *indices, size_t count);
     };
 
     std::vector<Part*> parts;
+    //! Source the parts views point to, closed with the data.
+    ResourceDataSource *viewSource = nullptr;
+
+    // Optional data precomputed by the tools, valid when not empty.
+    AABB aabb;
+    BoundingSphere boundingSphere;
+    std::vector<glm::vec3> convexHull;
+    //! Serialized btOptimizedBvh, allocated with the loader allocator and released by the holder.
+    static const size_t BVH_DATA_ALIGNMENT = 16;
+    void *bvhData = nullptr;
+    size_t bvhDataSize = 0;
+
+    MeshResourceData() = default;
+    ~MeshResourceData();
 };
 
 struct MeshPart
@@ -33,30 +61,61 @@ struct MeshPart
     size_t numberOfElements = 0;
 };
 
-struct MeshResource
+//! CPU copy of the geometry for the collision shapes, made while decoding.
+struct MeshCollisionData
 {
-    btTriangleIndexVertexArray *physicsMeshInterface = nullptr;
+    std::vector<glm::vec3> positions;
+    //! Triangles of all the mesh parts.
+    std::vector<uint32_t> indices;
+    //! Quantized BVH of the triangles if it was precomputed. Lives in the memory it was deserialized from.
+    btOptimizedBvh *bvh = nullptr;
+
+    //! Built on first use unless set, main thread only.
+    const ConvexHull& getConvexHull() const;
+    void setConvexHull(ConvexHull &&hull);
+
+    //! Bullet view of the triangles, doesn't copy the data.
+    btStridingMeshInterface* createMeshInterface(Allocator &allocator) const;
+
+private:
+    mutable ConvexHull m_convexHull;
+    mutable bool m_convexHullBuilt = false;
+};
 
+struct MeshResource
+{
     std::vector<MeshPart> meshParts;
     std::vector<Id> materialNames;
     Id materialLibResourceId;
     AABB localAABB;
     BoundingSphere localBoundingSphere;
-    ConvexHull convexHull;
+    MeshCollisionData collision;
 };
 
+//! Fills the collision data and computes the bounding volumes in a single pass over the vertices.
+void ProcessMeshGeometry(const MeshResourceData &resource, MeshCollisionData &collision, AABB &aabb, BoundingSphere &sphere);
+
 class MeshHolder : public IResourceHolder
 {
     MeshResourceData *m_resourceData = nullptr;
     MeshResource *m_resource = nullptr;
-    Id m_materialLib;
+    std::string m_materialLib;
+    // Derived from the geometry by decodeStartup.
+    AABB m_localAABB;
+    BoundingSphere m_localBoundingSphere;
+    MeshCollisionData m_collision;
+    size_t m_cpuMemoryUsage = 0;
+    size_t m_gpuMemoryUsage = 0;
 
 public:
-    void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps);
     bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) override;
+    void listDependencies(std::vector<std::string> &outDeps) override;
     void decodeCleanup(Allocator &allocator) override;
+    size_t getUploadSize() override;
     bool createResource(Allocator &allocator) override;
     void destroyResource(Allocator &allocator) override;
+    size_t getCpuMemoryUsage() override { return m_cpuMemoryUsage; }
+    size_t getGpuMemoryUsage() override { return m_gpuMemoryUsage; }
 
     void* getResource() override { return m_resource; }
 };
@@ -96,14 +155,19 @@ class AnimatedMeshHolder : public IResourceHolder
 {
     AnimatedMeshResource *m_resource = nullptr;
     AnimatedMeshResourceData *m_resourceData = nullptr;
-    Id m_materialLib;
+    std::string m_materialLib;
+    size_t m_cpuMemoryUsage = 0;
+    size_t m_gpuMemoryUsage = 0;
 
 public:
-    void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps);
     bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) override;
+    void listDependencies(std::vector<std::string> &outDeps) override;
     void decodeCleanup(Allocator &allocator) override;
+    size_t getUploadSize() override;
     bool createResource(Allocator &allocator) override;
     void destroyResource(Allocator &allocator) override;
+    size_t getCpuMemoryUsage() override { return m_cpuMemoryUsage; }
+    size_t getGpuMemoryUsage() override { return m_gpuMemoryUsage; }
 
     void* getResource() override { return m_resource; }
 };
@@ -0,0 +1,158 @@
+#include "PackedArchiveFileSystem.h"
+
+#include "ResourceFileSystem.h"
+#include "ResourceDataSource.h"
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/os/PlatformFile.h>
+#include <df3d/lib/Utils.h>
+
+namespace df3d {
+
+class PackedArchiveFileSystem : public ResourceFileSystem
+{
+    unique_ptr<PlatformMappedFile> m_file;
+    const PackedArchiveEntry *m_entries;
+    size_t m_entriesCount;
+    const char *m_paths;
+    size_t m_pathsSize;
+
+    const PackedArchiveEntry* findEntry(const char *path) const
+    {
+        auto hash = Id(path).m_id;
+
+        auto entriesEnd = m_entries + m_entriesCount;
+        auto found = std::lower_bound(m_entries, entriesEnd, hash, [](const PackedArchiveEntry &entry, uint32_t h) {
+            return entry.pathHash < h;
+        });
+
+        // Different paths may have the same hash.
+        for (; found != entriesEnd && found->pathHash == hash; found++)
+        {
+            if (strcmp(m_paths + found->pathOffset, path) == 0)
+                return found;
+        }
+
+        return nullptr;
+    }
+
+public:
+    PackedArchiveFileSystem(unique_ptr<PlatformMappedFile> file, const PackedArchiveHeader &header)
+        : m_file(std::move(file))
+    {
+        auto data = m_file->getData();
+
+        m_entries = reinterpret_cast<const PackedArchiveEntry *>(data + header.entriesOffset);
+        m_entriesCount = header.entriesCount;
+        m_paths = reinterpret_cast<const char *>(data + header.pathsOffset);
+        m_pathsSize = m_file->getSize() - header.pathsOffset;
+    }
+
+    ~PackedArchiveFileSystem()
+    {
+
+    }
+
+    bool validate() const
+    {
+        const uint64_t fileSize = m_file->getSize();
+
+        for (size_t i = 0; i < m_entriesCount; i++)
+        {
+            const auto &entry = m_entries[i];
+
+            if (i > 0 && m_entries[i - 1].pathHash > entry.pathHash)
+                return false;
+            if (entry.pathOffset >= m_pathsSize)
+                return false;
+            if (entry.dataOffset > fileSize || entry.packedSize > fileSize - entry.dataOffset)
+                return false;
+            if (entry.compression != PACKED_ARCHIVE_COMPRESSION_NONE && entry.compression != PACKED_ARCHIVE_COMPRESSION_ZLIB)
+                return false;
+            // Uncompressed entries are served in place, their size must be the stored one.
+            if (entry.compression == PACKED_ARCHIVE_COMPRESSION_NONE && entry.size != entry.packedSize)
+                return false;
+            // Data sources keep a 32 bit signed size.
+            if (entry.size > INT32_MAX || entry.packedSize > INT32_MAX)
+                return false;
+        }
+
+        return m_pathsSize > 0 && m_paths[m_pathsSize - 1] == 0;
+    }
+
+    ResourceDataSource* open(const char *path) override
+    {
+        auto entry = findEntry(path);
+        if (!entry)
+            return nullptr;
+
+        auto &alloc = MemoryManager::allocDefault();
+        auto packedData = m_file->getData() + entry->dataOffset;
+
+        if (entry->compression == PACKED_ARCHIVE_COMPRESSION_NONE)
+            return MAKE_NEW(alloc, MemoryDataSource)(packedData, entry->size);
+
+        auto buffer = MEMORY_ALLOC(alloc, uint8_t, entry->size);
+        if (!utils::inflateUncompress(buffer, entry->size, packedData, entry->packedSize))
+        {
+            DFLOG_WARN("Failed to decompress '%s' from the archive", path);
+            MEMORY_FREE(alloc, buffer);
+            return nullptr;
+        }
+
+        return MAKE_NEW(alloc, MemoryDataSource)(buffer, entry->size, &alloc);
+    }
+
+    void close(ResourceDataSource *dataSource) override
+    {
+        MAKE_DELETE(MemoryManager::allocDefault(), dataSource);
+    }
+};
+
+unique_ptr<ResourceFileSystem> CreatePackedArchiveFileSystem(const char *archivePath)
+{
+    auto file = PlatformMapFile(archivePath);
+    if (!file)
+    {
+        DFLOG_WARN("Failed to map resource archive '%s'", archivePath);
+        return nullptr;
+    }
+
+    PackedArchiveHeader header;
+    if (file->getSize() < sizeof(header))
+    {
+        DFLOG_WARN("Invalid resource archive '%s'", archivePath);
+        return nullptr;
+    }
+
+    memcpy(&header, file->getData(), sizeof(header));
+
+    if (memcmp(&header.magic, PACKED_ARCHIVE_MAGIC, sizeof(header.magic)) != 0 || header.version != PACKED_ARCHIVE_VERSION)
+    {
+        DFLOG_WARN("Invalid resource archive '%s'", archivePath);
+        return nullptr;
+    }
+
+    // The entries table is read straight from the mapping, it must lie within the file before the paths.
+    // Compared without adding to the untrusted offsets, so they can't wrap around.
+    const uint64_t fileSize = file->getSize();
+    const uint64_t entriesSize = uint64_t(header.entriesCount) * sizeof(PackedArchiveEntry);
+    if (header.entriesOffset < sizeof(header) ||
+        header.pathsOffset > fileSize ||
+        header.entriesOffset > header.pathsOffset ||
+        entriesSize > header.pathsOffset - header.entriesOffset)
+    {
+        DFLOG_WARN("Invalid resource archive '%s'", archivePath);
+        return nullptr;
+    }
+
+    auto fs = make_unique<PackedArchiveFileSystem>(std::move(file), header);
+    if (!fs->validate())
+    {
+        DFLOG_WARN("Resource archive '%s' is corrupted", archivePath);
+        return nullptr;
+    }
+
+    return fs;
+}
+
+}
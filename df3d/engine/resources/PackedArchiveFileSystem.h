@@ -0,0 +1,64 @@
+#pragma once
+
+namespace df3d {
+
+class ResourceFileSystem;
+
+const char PACKED_ARCHIVE_MAGIC[4] = { 'D', 'F', 'P', 'K' };
+const uint16_t PACKED_ARCHIVE_VERSION = 1;
+//! Entries data offsets are aligned to this value.
+const uint32_t PACKED_ARCHIVE_DATA_ALIGNMENT = 16;
+
+// File format:
+// |--------------------------------------------------|
+// | PackedArchiveHeader                              |
+// |--------------------------------------------------|
+// | entries data                                     |
+// |--------------------------------------------------|
+// | PackedArchiveEntry * entriesCount, by path hash  |
+// |--------------------------------------------------|
+// | null terminated entries paths                    |
+// |--------------------------------------------------|
+
+enum PackedArchiveCompression
+{
+    PACKED_ARCHIVE_COMPRESSION_NONE,
+    PACKED_ARCHIVE_COMPRESSION_ZLIB
+};
+
+#pragma pack(push, 1)
+
+struct PackedArchiveHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+
+    uint32_t entriesCount;
+    //! Offset to the entries table relative to the start.
+    uint64_t entriesOffset;
+    //! Offset to the paths table relative to the start.
+    uint64_t pathsOffset;
+};
+
+struct PackedArchiveEntry
+{
+    //! Id of the path the resource is opened with.
+    uint32_t pathHash;
+    //! Offset of the path in the paths table.
+    uint32_t pathOffset;
+    //! Offset to the data relative to the start.
+    uint64_t dataOffset;
+    uint32_t packedSize;
+    uint32_t size;
+    uint16_t compression;
+    uint16_t reserved;
+};
+
+#pragma pack(pop)
+
+//! File system over a single memory mapped archive, see tools/res_packer.
+//! Uncompressed entries are read straight from the mapping.
+unique_ptr<ResourceFileSystem> CreatePackedArchiveFileSystem(const char *archivePath);
+
+}
@@ -566,12 +566,20 @@ static SPK::Ref<SPK::System> CreateSpkSystem(const Json::Value &root)
     return result;
 }
 
-void ParticleSystemHolder::listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps)
+bool ParticleSystemHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
 {
     auto root = JsonUtils::fromFile(dataSource);
     if (root.isNull())
-        return;
+        return false;
+
+    m_root = MAKE_NEW(allocator, Json::Value)(std::move(root));
 
+    return true;
+}
+
+void ParticleSystemHolder::listDependencies(std::vector<std::string> &outDeps)
+{
+    const auto &root = *m_root;
     if (!root.isMember("groups"))
         return;
 
@@ -589,17 +597,6 @@ void ParticleSystemHolder::listDependencies(ResourceDataSource &dataSource, std:
     }
 }
 
-bool ParticleSystemHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
-{
-    auto root = JsonUtils::fromFile(dataSource);
-    if (root.isNull())
-        return false;
-
-    m_root = MAKE_NEW(allocator, Json::Value)(std::move(root));
-
-    return true;
-}
-
 void ParticleSystemHolder::decodeCleanup(Allocator &allocator)
 {
     MAKE_DELETE(allocator, m_root);
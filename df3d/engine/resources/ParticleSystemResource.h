@@ -16,8 +16,8 @@ class ParticleSystemHolder : public IResourceHolder
     Json::Value *m_root = nullptr;
 
 public:
-    void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps) override;
     bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) override;
+    void listDependencies(std::vector<std::string> &outDeps) override;
     void decodeCleanup(Allocator &allocator) override;
     bool createResource(Allocator &allocator) override;
     void destroyResource(Allocator &allocator) override;
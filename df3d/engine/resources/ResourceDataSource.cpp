@@ -40,61 +40,55 @@ public:
     }
 };
 
-class MemoryDataSource : public ResourceDataSource
+MemoryDataSource::MemoryDataSource(const uint8_t *buffer, int32_t size, Allocator *owner)
+    : m_buffer(buffer),
+    m_size(size),
+    m_owner(owner)
 {
-    const uint8_t *m_buffer;
-    const uint8_t *m_current;
-    int32_t m_size;
-
-public:
-    MemoryDataSource(const uint8_t *buffer, int32_t size)
-        : m_buffer(std::move(buffer)),
-        m_size(size)
-    {
-        m_current = m_buffer;
-    }
-
-    ~MemoryDataSource()
-    {
+    m_current = m_buffer;
+}
 
-    }
+MemoryDataSource::~MemoryDataSource()
+{
+    if (m_owner)
+        MEMORY_FREE(*m_owner, const_cast<uint8_t*>(m_buffer));
+}
 
-    size_t read(void *buffer, size_t sizeInBytes) override
-    {
-        if (m_current + sizeInBytes > m_buffer + m_size)
-            sizeInBytes = m_buffer + m_size - m_current;
+size_t MemoryDataSource::read(void *buffer, size_t sizeInBytes)
+{
+    if (m_current + sizeInBytes > m_buffer + m_size)
+        sizeInBytes = m_buffer + m_size - m_current;
 
-        memcpy(buffer, m_current, sizeInBytes);
+    memcpy(buffer, m_current, sizeInBytes);
 
-        m_current += sizeInBytes;
+    m_current += sizeInBytes;
 
-        return sizeInBytes;
-    }
+    return sizeInBytes;
+}
 
-    size_t getSize() override
-    {
-        return m_size;
-    }
+size_t MemoryDataSource::getSize()
+{
+    return m_size;
+}
 
-    int32_t tell() override
-    {
-        return m_current - m_buffer;
-    }
+int32_t MemoryDataSource::tell()
+{
+    return m_current - m_buffer;
+}
 
-    bool seek(int32_t offset, SeekDir origin) override
-    {
-        if (origin == SeekDir::CURRENT)
-            m_current += offset;
-        else if (origin == SeekDir::BEGIN)
-            m_current = m_buffer + offset;
-        else if (origin == SeekDir::END)
-            m_current = m_buffer + m_size + offset;
-        else
-            return false;
-
-        return (m_current - m_buffer) <= m_size;
-    }
-};
+bool MemoryDataSource::seek(int32_t offset, SeekDir origin)
+{
+    if (origin == SeekDir::CURRENT)
+        m_current += offset;
+    else if (origin == SeekDir::BEGIN)
+        m_current = m_buffer + offset;
+    else if (origin == SeekDir::END)
+        m_current = m_buffer + m_size + offset;
+    else
+        return false;
+
+    return (m_current - m_buffer) <= m_size;
+}
 
 ResourceDataSource* CreateFileDataSource(const char *path, Allocator &allocator)
 {
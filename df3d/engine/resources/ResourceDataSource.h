@@ -14,6 +14,10 @@ public:
     virtual int32_t tell() = 0;
     virtual bool seek(int32_t offset, SeekDir origin) = 0;
 
+    //! Returns the whole content (getSize() bytes) if it's already in memory, nullptr otherwise.
+    //! The pointer is valid until the data source is closed.
+    virtual const uint8_t* getContiguousView() { return nullptr; }
+
     template<typename T>
     bool getObjects(T *output, size_t numElements)
     {
@@ -24,6 +28,28 @@ public:
     }
 };
 
+//! Reads from a memory buffer without copying it. The buffer is freed with the owner allocator
+//! (if any) when the data source is destroyed.
+class MemoryDataSource : public ResourceDataSource
+{
+    const uint8_t *m_buffer;
+    const uint8_t *m_current;
+    int32_t m_size;
+    Allocator *m_owner;
+
+public:
+    MemoryDataSource(const uint8_t *buffer, int32_t size, Allocator *owner = nullptr);
+    ~MemoryDataSource();
+
+    size_t read(void *buffer, size_t sizeInBytes) override;
+    size_t getSize() override;
+
+    int32_t tell() override;
+    bool seek(int32_t offset, SeekDir origin) override;
+
+    const uint8_t* getContiguousView() override { return m_buffer; }
+};
+
 ResourceDataSource* CreateFileDataSource(const char *path, Allocator &allocator);
 ResourceDataSource* CreateMemoryDataSource(const uint8_t *buffer, int32_t size, Allocator &allocator);
 
@@ -2,7 +2,7 @@
 
 #include <df3d/engine/EngineController.h>
 #include <df3d/engine/io/FileSystemHelpers.h>
-#include <df3d/lib/ThreadPool.h>
+#include <df3d/lib/JobSystem.h>
 #include <df3d/lib/Utils.h>
 #include <df3d/lib/JsonUtils.h>
 #include "ResourceFileSystem.h"
@@ -14,6 +14,8 @@
 #include "EntityResource.h"
 #include "IResourceHolder.h"
 
+#include <chrono>
+
 namespace df3d {
 
 static shared_ptr<IResourceHolder> CreateResourceHolder(const char *resourcePath)
@@ -44,12 +46,37 @@ static shared_ptr<IResourceHolder> CreateResourceHolder(const char *resourcePath
 
 struct LoadingState
 {
-    ThreadPool pool;
+    struct DecodeTask
+    {
+        Id resourceId;
+        std::string resourcePath;
+        shared_ptr<IResourceHolder> holder;
+        bool listDependencies;
+        int priority;
+        uint64_t order;
+    };
+
+    struct PackageRequest
+    {
+        ResourcePackageHandle handle;
+        std::vector<Id> resources;
+        ResourcePackageCallback onLoaded;
+    };
+
+    JobCounter decodeJobs;
+    //! Decoding starts from the most urgent resource, limited by the number of workers.
+    std::vector<DecodeTask> decodeQueue;
+    uint64_t decodeOrder = 0;
+    size_t decodesInFlight = 0;
+    bool schedulingDecodes = false;
+
     std::unordered_map<Id, shared_ptr<IResourceHolder>> decoded;
-    std::unordered_map<Id, std::unordered_set<std::string>> dependencies;
 
-    LoadingState(size_t workers) : pool(workers) { }
-    ~LoadingState() { DF3D_ASSERT(decoded.empty()); }
+    std::vector<PackageRequest> requests;
+    HandleType lastRequestHandle = 0;
+
+    LoadingState() : decodeJobs(0) { }
+    ~LoadingState() { DF3D_ASSERT(decoded.empty() && decodeQueue.empty()); }
 };
 
 const void* ResourceManager::getResourceData(Id resourceID)
@@ -68,29 +95,225 @@ const void* ResourceManager::getResourceData(Id resourceID)
     return nullptr;
 }
 
-void ResourceManager::listDependencies(const ResourcePackage &input, ResourcePackage &output, LoadingState *loadingState)
+void ResourceManager::loadResource(const std::string &resourcePath, int priority)
 {
-    for (const auto &resourcePath : input)
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    Id resourceId(resourcePath.c_str());
+
+    auto found = m_cache.find(resourceId);
+    if (found != m_cache.end())
     {
-        if (auto holder = CreateResourceHolder(resourcePath.c_str()))
+        auto &entry = found->second;
+        if (entry.refCount++ == 0 && entry.valid)
         {
-            if (auto dataSource = getFS().open(resourcePath.c_str()))
-            {
-                output.push_back(resourcePath);
+            m_warmResources.erase(entry.warmIt);
+            m_memoryStats.warmResources--;
+            m_memoryStats.warmCpuBytes -= entry.cpuBytes;
+            m_memoryStats.warmGpuBytes -= entry.gpuBytes;
+        }
 
-                ResourcePackage tmp;
-                holder->listDependencies(*dataSource, tmp);
-                getFS().close(dataSource);
+        raisePriority(resourceId, priority);
+        return;
+    }
 
-                if (loadingState)
-                {
-                    Id resourceId(resourcePath.c_str());
-                    loadingState->dependencies[resourceId].insert(tmp.begin(), tmp.end());
-                }
+    auto holder = CreateResourceHolder(resourcePath.c_str());
+    if (!holder)
+        return;
 
-                listDependencies(tmp, output, loadingState);
-            }
+    Entry entry;
+    entry.refCount = 1;
+    entry.valid = false;
+    entry.holder = holder;
+    entry.priority = priority;
+
+#ifdef _DEBUG
+    entry.resourcePath = resourcePath;
+#endif
+
+    auto knownDeps = m_dependencyGraph.find(resourcePath);
+    bool dependenciesKnown = knownDeps != m_dependencyGraph.end();
+    std::vector<std::string> deps;
+    if (dependenciesKnown)
+    {
+        deps = knownDeps->second;
+        for (const auto &depPath : deps)
+            entry.dependencies.push_back(Id(depPath.c_str()));
+    }
+
+    m_cache[resourceId] = std::move(entry);
+
+    // Don't wait for the resource to be parsed when the dependencies are known already.
+    for (const auto &depPath : deps)
+        loadResource(depPath, priority);
+
+    auto &state = *m_loadingState;
+    state.decodeQueue.push_back({ resourceId, resourcePath, holder, !dependenciesKnown, priority, state.decodeOrder++ });
+}
+
+void ResourceManager::raisePriority(Id resourceId, int priority)
+{
+    auto found = m_cache.find(resourceId);
+    if (found == m_cache.end() || found->second.valid || found->second.priority >= priority)
+        return;
+
+    found->second.priority = priority;
+    for (auto &task : m_loadingState->decodeQueue)
+    {
+        if (task.resourceId == resourceId)
+            task.priority = priority;
+    }
+
+    for (auto dep : found->second.dependencies)
+        raisePriority(dep, priority);
+}
+
+void ResourceManager::scheduleDecodes()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    auto &state = *m_loadingState;
+
+    // Jobs run inline when there are no workers and come back here.
+    if (state.schedulingDecodes)
+        return;
+    state.schedulingDecodes = true;
+
+    const size_t maxInFlight = std::max<size_t>(1, svc().jobs().getWorkersCount());
+
+    while (state.decodesInFlight < maxInFlight && !state.decodeQueue.empty())
+    {
+        auto best = std::max_element(state.decodeQueue.begin(), state.decodeQueue.end(),
+                                     [](const LoadingState::DecodeTask &a, const LoadingState::DecodeTask &b) {
+            if (a.priority != b.priority)
+                return a.priority < b.priority;
+            return a.order > b.order;
+        });
+
+        std::iter_swap(best, state.decodeQueue.end() - 1);
+        auto task = std::move(state.decodeQueue.back());
+        state.decodeQueue.pop_back();
+
+        // All the users have been released.
+        if (m_cache[task.resourceId].refCount == 0)
+        {
+            releaseResource(task.resourceId);
+            continue;
+        }
+
+        state.decodesInFlight++;
+
+        svc().jobs().runBackground([this, task]()
+        {
+            decodeResource(task.resourcePath, task.holder, task.listDependencies);
+        }, &state.decodeJobs);
+    }
+
+    state.schedulingDecodes = false;
+}
+
+void ResourceManager::decodeResource(const std::string &resourcePath, shared_ptr<IResourceHolder> holder, bool listDependencies)
+{
+    Id resourceId(resourcePath.c_str());
+    auto &fs = getFS();
+
+    bool decodeResult = false;
+    std::vector<std::string> deps;
+    if (auto dataSource = fs.open(resourcePath.c_str()))
+    {
+        decodeResult = holder->decodeStartup(*dataSource, m_allocator);
+        if (decodeResult && listDependencies)
+            holder->listDependencies(deps);
+
+        if (!decodeResult || !holder->keepsDataSource())
+            fs.close(dataSource);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    m_loadingState->decodesInFlight--;
+
+    auto &entry = m_cache[resourceId];
+
+    if (!decodeResult)
+    {
+        DFLOG_WARN("Resource '%s' decode failed!", resourcePath.c_str());
+        releaseResource(resourceId);
+    }
+    else if (entry.refCount == 0)
+    {
+        holder->decodeCleanup(m_allocator);
+        releaseResource(resourceId);
+    }
+    else
+    {
+        if (listDependencies)
+        {
+            for (const auto &depPath : deps)
+                entry.dependencies.push_back(Id(depPath.c_str()));
+
+            m_dependencyGraph[resourcePath] = deps;
+
+            auto priority = entry.priority;
+            for (const auto &depPath : deps)
+                loadResource(depPath, priority);
         }
+
+        DF3D_ASSERT(!utils::contains_key(m_loadingState->decoded, resourceId));
+        m_loadingState->decoded[resourceId] = holder;
+    }
+
+    scheduleDecodes();
+}
+
+bool ResourceManager::canCreate(const Entry &entry) const
+{
+    for (auto dep : entry.dependencies)
+    {
+        auto found = m_cache.find(dep);
+        if (found != m_cache.end() && !found->second.valid)
+            return false;
+    }
+
+    return true;
+}
+
+void ResourceManager::createDecodedResource(Id resourceId, shared_ptr<IResourceHolder> holder)
+{
+    auto &entry = m_cache[resourceId];
+
+    m_loadingState->decoded.erase(resourceId);
+
+    // All the users have been released while decoding.
+    if (entry.refCount == 0)
+    {
+        holder->decodeCleanup(m_allocator);
+        releaseResource(resourceId);
+        return;
+    }
+
+    // Failed dependencies are gone from the cache already.
+    auto &deps = entry.dependencies;
+    deps.erase(std::remove_if(deps.begin(), deps.end(), [this](Id dep) {
+        return !utils::contains_key(m_cache, dep);
+    }), deps.end());
+
+    bool created = holder->createResource(m_allocator);
+    holder->decodeCleanup(m_allocator);
+
+    if (created)
+    {
+        entry.valid = true;
+        entry.cpuBytes = holder->getCpuMemoryUsage();
+        entry.gpuBytes = holder->getGpuMemoryUsage();
+
+        m_memoryStats.cpuBytes += entry.cpuBytes;
+        m_memoryStats.gpuBytes += entry.gpuBytes;
+    }
+    else
+    {
+        DFLOG_WARN("Resource '%s' creation failed!", resourceId.toString().c_str());
+        releaseResource(resourceId);
     }
 }
 
@@ -101,19 +324,78 @@ void ResourceManager::unloadResource(Id resource)
     {
         if (--found->second.refCount == 0)
         {
-            found->second.holder->destroyResource(m_allocator);
-            m_cache.erase(found);
+            // Still loading, dropped by the loader.
+            if (!found->second.valid)
+                return;
+
+            // Keep it until it doesn't fit the budget, the dependencies stay referenced by it.
+            auto &entry = found->second;
+            entry.warmIt = m_warmResources.insert(m_warmResources.end(), resource);
+            m_memoryStats.warmResources++;
+            m_memoryStats.warmCpuBytes += entry.cpuBytes;
+            m_memoryStats.warmGpuBytes += entry.gpuBytes;
         }
     }
     else
         DF3D_ASSERT_MESS(false, "Failed to unload resoure. Resource '%s' not found", resource.toString().c_str());
 }
 
+void ResourceManager::destroyResource(Id resource)
+{
+    auto found = m_cache.find(resource);
+    DF3D_ASSERT(found != m_cache.end() && found->second.valid && found->second.refCount == 0);
+
+    auto &entry = found->second;
+    auto deps = std::move(entry.dependencies);
+
+    m_warmResources.erase(entry.warmIt);
+    m_memoryStats.warmResources--;
+    m_memoryStats.warmCpuBytes -= entry.cpuBytes;
+    m_memoryStats.warmGpuBytes -= entry.gpuBytes;
+    m_memoryStats.cpuBytes -= entry.cpuBytes;
+    m_memoryStats.gpuBytes -= entry.gpuBytes;
+
+    entry.holder->destroyResource(m_allocator);
+    m_cache.erase(found);
+
+    for (auto dep : deps)
+        unloadResource(dep);
+}
+
+void ResourceManager::evictWarmResources(bool all)
+{
+    // Released dependencies become warm too and are evicted if still over the budget.
+    while (!m_warmResources.empty())
+    {
+        if (!all && m_memoryStats.cpuBytes <= m_cpuMemoryBudget && m_memoryStats.gpuBytes <= m_gpuMemoryBudget)
+            break;
+
+        destroyResource(m_warmResources.front());
+    }
+}
+
+void ResourceManager::releaseResource(Id resource)
+{
+    // The resource failed to load or isn't needed anymore, its users skip it as a missing dependency.
+    auto found = m_cache.find(resource);
+    DF3D_ASSERT(found != m_cache.end() && !found->second.valid);
+
+    auto deps = std::move(found->second.dependencies);
+    m_cache.erase(found);
+    // Won't be created, so it's never dropped by createDecodedResources.
+    m_uploadPriorities.erase(resource);
+
+    for (auto dep : deps)
+    {
+        if (utils::contains_key(m_cache, dep))
+            unloadResource(dep);
+    }
+}
+
 ResourceManager::ResourceManager()
-    : m_allocator(MemoryManager::allocDefault())
+    : m_allocator(MemoryManager::allocTagged(MEMORY_TAG_RESOURCES))
 {
-    int thr = std::thread::hardware_concurrency();
-    m_maxThreadPoolWorkers = df3d::utils::clamp(thr, 1, 2);
+
 }
 
 ResourceManager::~ResourceManager()
@@ -123,77 +405,195 @@ ResourceManager::~ResourceManager()
 
 void ResourceManager::initialize()
 {
+    m_loadingState = make_unique<LoadingState>();
+
     setDefaultFileSystem();
 }
 
 void ResourceManager::shutdown()
 {
+    if (m_loadingState)
+    {
+        auto &state = *m_loadingState;
+
+        // Pending resources are dropped, including the ones the running jobs have queued.
+        auto dropPending = [this, &state]()
+        {
+            std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+            state.requests.clear();
+
+            auto queue = std::move(state.decodeQueue);
+            state.decodeQueue.clear();
+            for (const auto &task : queue)
+                m_cache.erase(task.resourceId);
+
+            for (const auto &kv : state.decoded)
+            {
+                kv.second->decodeCleanup(m_allocator);
+                m_cache.erase(kv.first);
+            }
+            state.decoded.clear();
+        };
+
+        dropPending();
+        svc().jobs().wait(state.decodeJobs);
+        dropPending();
+    }
+
     m_loadingState.reset();
     m_fs.reset();
-    DF3D_ASSERT(m_cache.empty());
+    DF3D_ASSERT(m_cache.empty() && m_warmResources.empty());
 }
 
 void ResourceManager::poll()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_lock);
+    std::vector<std::pair<ResourcePackageCallback, ResourcePackageHandle>> callbacks;
 
-    if (m_loadingState)
     {
-        for (auto it = m_loadingState->decoded.begin(); it != m_loadingState->decoded.end(); )
-        {
-            auto holder = it->second;
-            auto resourceId = it->first;
+        std::lock_guard<std::recursive_mutex> lock(m_lock);
 
-            auto &deps = m_loadingState->dependencies[resourceId];
-            bool canCreate = true;
-            for (const auto &depPath : deps)
+        m_uploadStats = {};
+
+        auto &state = *m_loadingState;
+
+        // Drop resources all the users of which have been released while decoding.
+        // Releasing one may release its dependencies, so repeat until nothing is dropped.
+        bool dropped = true;
+        while (dropped)
+        {
+            dropped = false;
+            for (auto it = state.decoded.begin(); it != state.decoded.end(); )
             {
-                auto found = m_cache.find(Id(depPath.c_str()));
-                if (!(found != m_cache.end() && found->second.valid))
+                if (m_cache[it->first].refCount == 0)
                 {
-                    canCreate = false;
-                    break;
+                    auto resourceId = it->first;
+                    it->second->decodeCleanup(m_allocator);
+                    it = state.decoded.erase(it);
+                    releaseResource(resourceId);
+                    dropped = true;
                 }
+                else
+                    ++it;
             }
+        }
 
-            if (!canCreate)
-            {
-                ++it;
-                continue;
-            }
+        createDecodedResources();
+        evictWarmResources(false);
 
-            if (holder->createResource(m_allocator))
+        for (const auto &kv : state.decoded)
+        {
+            m_uploadStats.queuedResources++;
+            m_uploadStats.queuedBytes += kv.second->getUploadSize();
+        }
+
+        // A package is loaded when its resources are created, their dependencies are created before them.
+        auto &requests = state.requests;
+        for (auto it = requests.begin(); it != requests.end(); )
+        {
+            bool loaded = std::all_of(it->resources.begin(), it->resources.end(), [this](Id resourceId) {
+                auto found = m_cache.find(resourceId);
+                return found == m_cache.end() || found->second.valid;
+            });
+
+            if (loaded)
             {
-                m_cache[resourceId].valid = true;
+                if (it->onLoaded)
+                    callbacks.push_back({ std::move(it->onLoaded), it->handle });
+                it = requests.erase(it);
             }
             else
-            {
-                DFLOG_WARN("Resource '%s' creation failed!", resourceId.toString().c_str());
-                m_cache.erase(resourceId);
-            }
-            holder->decodeCleanup(m_allocator);
-            it = m_loadingState->decoded.erase(it);
+                ++it;
         }
-
-        if (m_loadingState->pool.getCurrentJobsCount() == 0 && m_loadingState->decoded.empty())
-            m_loadingState.reset();
     }
+
+    for (auto &callback : callbacks)
+        callback.first(callback.second);
 }
 
-void ResourceManager::suspend()
+void ResourceManager::createDecodedResources()
 {
-    DFLOG_DEBUG("ResourceManager start suspend");
-    if (m_loadingState)
-        m_loadingState->pool.suspend();
+    struct Candidate
+    {
+        Id resourceId;
+        shared_ptr<IResourceHolder> holder;
+        size_t size;
+        int priority;
+    };
+
+    // Priorities are inherited by dependencies as they have to be created first.
+    std::unordered_map<Id, int> priorities;
+    std::function<void(Id, int)> raiseUploadPriority = [&](Id resourceId, int priority)
+    {
+        auto found = priorities.find(resourceId);
+        if (found != priorities.end() && found->second >= priority)
+            return;
+        priorities[resourceId] = priority;
 
-    DFLOG_DEBUG("ResourceManager SUSPENDED");
-}
+        auto entry = m_cache.find(resourceId);
+        if (entry != m_cache.end())
+        {
+            for (auto dep : entry->second.dependencies)
+                raiseUploadPriority(dep, priority);
+        }
+    };
+    for (const auto &kv : m_uploadPriorities)
+        raiseUploadPriority(kv.first, kv.second);
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    auto elapsedUs = [startTime]() {
+        auto now = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(now - startTime).count();
+    };
+
+    std::vector<Candidate> candidates;
+    bool budgetLeft = true;
+    while (budgetLeft)
+    {
+        // Creation of a resource may let its users be created in the same poll.
+        candidates.clear();
+        for (const auto &kv : m_loadingState->decoded)
+        {
+            const auto &entry = m_cache[kv.first];
+            if (canCreate(entry))
+            {
+                auto priority = entry.priority;
+                auto found = priorities.find(kv.first);
+                if (found != priorities.end())
+                    priority = std::max(priority, found->second);
 
-void ResourceManager::resume()
-{
-    DFLOG_DEBUG("ResourceManager::resume");
-    if (m_loadingState)
-        m_loadingState->pool.resume();
+                candidates.push_back({ kv.first, kv.second, kv.second->getUploadSize(), priority });
+            }
+        }
+
+        if (candidates.empty())
+            break;
+
+        // Higher priority first, then smaller ones to create more per frame.
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+            if (a.priority != b.priority)
+                return a.priority > b.priority;
+            return a.size < b.size;
+        });
+
+        for (const auto &candidate : candidates)
+        {
+            if (m_uploadStats.uploadedResources > 0 &&
+                (m_uploadStats.uploadedBytes + candidate.size > m_uploadBudgetBytes || elapsedUs() >= m_uploadBudgetMicroseconds))
+            {
+                budgetLeft = false;
+                break;
+            }
+
+            createDecodedResource(candidate.resourceId, candidate.holder);
+            m_uploadPriorities.erase(candidate.resourceId);
+
+            m_uploadStats.uploadedResources++;
+            m_uploadStats.uploadedBytes += candidate.size;
+        }
+    }
+
+    m_uploadStats.uploadTimeMs = elapsedUs() / 1000.0f;
 }
 
 void ResourceManager::setDefaultFileSystem()
@@ -206,98 +606,175 @@ void ResourceManager::setFileSystem(unique_ptr<ResourceFileSystem> fs)
     m_fs = std::move(fs);
 }
 
-void ResourceManager::loadPackageAsync(const ResourcePackage &resources)
+ResourcePackageHandle ResourceManager::loadPackageAsync(const ResourcePackage &resources, int priority, ResourcePackageCallback onLoaded)
 {
-    if (resources.empty())
-        return;
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
 
-    if (isLoading())
+    auto &state = *m_loadingState;
+
+    LoadingState::PackageRequest request;
+    request.handle = ResourcePackageHandle(++state.lastRequestHandle);
+    request.onLoaded = std::move(onLoaded);
+
+    for (const auto &resourcePath : resources)
     {
-        DF3D_ASSERT_MESS(false, "Can not load packages simultaneously!");
+        Id resourceId(resourcePath.c_str());
+
+        loadResource(resourcePath, priority);
+        if (utils::contains_key(m_cache, resourceId))
+            request.resources.push_back(resourceId);
+    }
+
+    state.requests.push_back(std::move(request));
+
+    scheduleDecodes();
+
+    return state.requests.back().handle;
+}
+
+void ResourceManager::cancelPackage(ResourcePackageHandle handle)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    auto &requests = m_loadingState->requests;
+    auto found = std::find_if(requests.begin(), requests.end(), [handle](const LoadingState::PackageRequest &request) {
+        return request.handle == handle;
+    });
+
+    if (found == requests.end())
         return;
+
+    for (auto resourceId : found->resources)
+    {
+        if (utils::contains_key(m_cache, resourceId))
+            unloadResource(resourceId);
     }
 
-    m_loadingState = make_unique<LoadingState>(m_maxThreadPoolWorkers);
+    requests.erase(found);
+
+    // Already created resources of the package may have become warm.
+    evictWarmResources(false);
+}
 
-    ResourcePackage resourcesToLoad;
-    listDependencies(resources, resourcesToLoad, m_loadingState.get());
+void ResourceManager::unloadPackage(const ResourcePackage &resources)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
 
-    for (const auto &resourcePath : resourcesToLoad)
+    for (const auto &resourcePath : resources)
     {
-        auto holder = CreateResourceHolder(resourcePath.c_str());
-        if (!holder)
-            continue;
+        Id resourceId(resourcePath.c_str());
 
-        m_loadingState->pool.enqueue([this, resourcePath, holder]()
-        {
-            Id resourceId(resourcePath.c_str());
+        // Resources which failed to load are not in the cache.
+        if (utils::contains_key(m_cache, resourceId))
+            unloadResource(resourceId);
+    }
 
-            {
-                std::lock_guard<std::recursive_mutex> lock(m_lock);
+    evictWarmResources(false);
+}
 
-                auto found = m_cache.find(resourceId);
-                if (found == m_cache.end())
-                {
-                    Entry entry;
-                    entry.refCount = 1;
-                    entry.valid = false;
-                    entry.holder = holder;
+bool ResourceManager::loadDependencyManifest(const char *path)
+{
+    auto root = JsonUtils::fromFile(path);
+    if (!root.isObject())
+        return false;
 
-#ifdef _DEBUG
-                    entry.resourcePath = resourcePath;
-#endif
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
 
-                    m_cache[resourceId] = entry;
-                }
-                else
-                {
-                    found->second.refCount++;
-                    return;
-                }
-            }
+    for (auto it = root.begin(); it != root.end(); ++it)
+    {
+        auto &deps = m_dependencyGraph[it.key().asString()];
 
-            auto &fs = getFS();
+        deps.clear();
+        for (const auto &dep : *it)
+            deps.push_back(dep.asString());
+    }
 
-            auto dataSource = fs.open(resourcePath.c_str());
-            bool decodeResult = holder->decodeStartup(*dataSource, m_allocator);
+    return true;
+}
 
-            {
-                std::lock_guard<std::recursive_mutex> lock(m_lock);
-                if (decodeResult)
-                {
-                    DF3D_ASSERT(!utils::contains_key(m_loadingState->decoded, resourceId));
-                    m_loadingState->decoded[resourceId] = holder;
-                }
-                else
-                {
-                    DFLOG_WARN("Resource '%s' decode failed!", resourcePath.c_str());
-                    DF3D_VERIFY(m_cache.erase(resourceId) == 1);
-                }
-            }
+Json::Value ResourceManager::getDependencyManifest() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
 
-            fs.close(dataSource);
-        });
+    Json::Value result(Json::objectValue);
+    for (const auto &kv : m_dependencyGraph)
+    {
+        auto &deps = result[kv.first];
+        deps = Json::Value(Json::arrayValue);
+        for (const auto &dep : kv.second)
+            deps.append(dep);
     }
+
+    return result;
 }
 
-void ResourceManager::unloadPackage(const ResourcePackage &resources)
+void ResourceManager::setUploadBudget(size_t bytes, uint32_t microseconds)
 {
-    if (resources.empty())
-        return;
-    flush();
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
 
-    std::vector<std::string> resourcesToUnLoad;
-    listDependencies(resources, resourcesToUnLoad, nullptr);
+    m_uploadBudgetBytes = bytes;
+    m_uploadBudgetMicroseconds = microseconds;
+}
 
-    for (const auto &resourcePath : resourcesToUnLoad)
-        unloadResource(Id(resourcePath.c_str()));
+void ResourceManager::setUploadPriority(Id resourceId, int priority)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    if (priority == 0)
+        m_uploadPriorities.erase(resourceId);
+    else
+        m_uploadPriorities[resourceId] = priority;
+}
+
+ResourceUploadStats ResourceManager::getUploadStats() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    return m_uploadStats;
+}
+
+void ResourceManager::setMemoryBudget(size_t cpuBytes, size_t gpuBytes)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    m_cpuMemoryBudget = cpuBytes;
+    m_gpuMemoryBudget = gpuBytes;
+
+    evictWarmResources(false);
+}
+
+ResourceMemoryStats ResourceManager::getMemoryStats() const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    return m_memoryStats;
+}
+
+void ResourceManager::purgeUnused()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    evictWarmResources(true);
 }
 
 bool ResourceManager::isLoading() const
 {
-    return m_loadingState && 
-        ((m_loadingState->pool.getCurrentJobsCount() > 0) ||
-        (!m_loadingState->decoded.empty()));
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    return m_loadingState->decodeJobs > 0 ||
+        !m_loadingState->decodeQueue.empty() ||
+        !m_loadingState->decoded.empty() ||
+        !m_loadingState->requests.empty();
+}
+
+bool ResourceManager::isLoading(ResourcePackageHandle handle) const
+{
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
+    const auto &requests = m_loadingState->requests;
+    return std::any_of(requests.begin(), requests.end(), [handle](const LoadingState::PackageRequest &request) {
+        return request.handle == handle;
+    });
 }
 
 void ResourceManager::flush()
@@ -307,12 +784,14 @@ void ResourceManager::flush()
 
 void ResourceManager::printUnused()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_lock);
+
     DFLOG_DEBUG("Unused resources:");
-    //for (const auto &entry : m_cache)
-    //{
-    //    if (!entry.second.used)
-    //        DFLOG_DEBUG("%s", entry.first.c_str());
-    //}
+    for (auto resourceId : m_warmResources)
+    {
+        const auto &entry = m_cache[resourceId];
+        DFLOG_DEBUG("%s, cpu: %d KB, gpu: %d KB", resourceId.toString().c_str(), int(entry.cpuBytes / 1024), int(entry.gpuBytes / 1024));
+    }
 
     DFLOG_DEBUG("---");
 }
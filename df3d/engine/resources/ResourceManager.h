@@ -1,8 +1,9 @@
 #pragma once
 
+#include <df3d/lib/Handles.h>
+
 namespace df3d {
 
-class ThreadPool;
 class ResourceFileSystem;
 class IResourceHolder;
 struct LoadingState;
@@ -11,6 +12,34 @@ struct LoadingState;
 
 using ResourcePackage = std::vector<std::string>;
 
+DF3D_DECLARE_HANDLE(ResourcePackageHandle)
+
+using ResourcePackageCallback = std::function<void(ResourcePackageHandle)>;
+
+struct ResourceUploadStats
+{
+    //! Decoded resources waiting to be created.
+    size_t queuedResources = 0;
+    size_t queuedBytes = 0;
+
+    //! Created during the last poll.
+    size_t uploadedResources = 0;
+    size_t uploadedBytes = 0;
+    float uploadTimeMs = 0.0f;
+};
+
+struct ResourceMemoryStats
+{
+    //! All the created resources, including the unreferenced ones.
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+
+    //! Unreferenced resources kept until the budget is exceeded.
+    size_t warmResources = 0;
+    size_t warmCpuBytes = 0;
+    size_t warmGpuBytes = 0;
+};
+
 class ResourceManager : NonCopyable
 {
     friend struct LoadingState;
@@ -26,19 +55,49 @@ class ResourceManager : NonCopyable
         std::string resourcePath;
 #endif
         shared_ptr<IResourceHolder> holder;
+        //! Resources referenced by this one, released with it.
+        std::vector<Id> dependencies;
+        //! Decoding order of the pending resources, the highest of the requests.
+        int priority = 0;
         int refCount = 0;
         bool valid = false;
         bool used = false;
+
+        size_t cpuBytes = 0;
+        size_t gpuBytes = 0;
+        //! Position in m_warmResources when not referenced.
+        std::list<Id>::iterator warmIt;
     };
 
     std::unordered_map<Id, Entry> m_cache;
+    //! Unreferenced created resources, least recently released first.
+    std::list<Id> m_warmResources;
+    //! Dependencies of every resource seen so far or read from a manifest, kept after unloading.
+    std::unordered_map<std::string, std::vector<std::string>> m_dependencyGraph;
 
-    size_t m_maxThreadPoolWorkers;
     bool m_lowEndDevice = false;
 
+    size_t m_uploadBudgetBytes = 4 * 1024 * 1024;
+    uint32_t m_uploadBudgetMicroseconds = 4000;
+    std::unordered_map<Id, int> m_uploadPriorities;
+    ResourceUploadStats m_uploadStats;
+
+    size_t m_cpuMemoryBudget = 128 * 1024 * 1024;
+    size_t m_gpuMemoryBudget = 256 * 1024 * 1024;
+    ResourceMemoryStats m_memoryStats;
+
     const void* getResourceData(Id resourceID);
-    void listDependencies(const ResourcePackage &input, ResourcePackage &output, LoadingState *loadingState);
+    bool canCreate(const Entry &entry) const;
+    void createDecodedResource(Id resourceId, shared_ptr<IResourceHolder> holder);
+    void createDecodedResources();
+    void loadResource(const std::string &resourcePath, int priority);
+    void raisePriority(Id resourceId, int priority);
+    void scheduleDecodes();
+    void decodeResource(const std::string &resourcePath, shared_ptr<IResourceHolder> holder, bool listDependencies);
     void unloadResource(Id resource);
+    void releaseResource(Id resource);
+    void destroyResource(Id resource);
+    void evictWarmResources(bool all);
 
 public:
     ResourceManager();
@@ -48,20 +107,42 @@ public:
     void shutdown();
     void poll();
 
-    void suspend();
-    void resume();
-
     void setDefaultFileSystem();
     void setFileSystem(unique_ptr<ResourceFileSystem> fs);
 
-    void setMaxThreadPoolWorkers(size_t num) { m_maxThreadPoolWorkers = num; }
     void setIsLowEndDevice(bool lowend) { m_lowEndDevice = lowend; }
     bool getIsLowEndDevice() const { return m_lowEndDevice; }
 
-    // Can load only 1 package at a time.
-    void loadPackageAsync(const ResourcePackage &resources);
+    //! Limits resources creation per poll, the rest is created in the next frames.
+    //! At least one resource is created per poll, whatever its size is.
+    void setUploadBudget(size_t bytes, uint32_t microseconds);
+    //! Resources with a higher priority and their dependencies are created first. Default is 0.
+    void setUploadPriority(Id resourceId, int priority);
+    ResourceUploadStats getUploadStats() const;
+
+    //! Unreferenced resources stay loaded until the memory they take exceeds the budget,
+    //! then the least recently released ones are destroyed. Zero budget disables keeping them.
+    void setMemoryBudget(size_t cpuBytes, size_t gpuBytes);
+    ResourceMemoryStats getMemoryStats() const;
+    //! Destroys all the unreferenced resources.
+    void purgeUnused();
+
+    //! Packages may be loaded concurrently, the ones with a higher priority are decoded first.
+    //! Dependencies are discovered by the decoding jobs, or taken from the dependency graph if known.
+    //! onLoaded is called from poll() when all the resources of the package are created or failed.
+    ResourcePackageHandle loadPackageAsync(const ResourcePackage &resources, int priority = 0, ResourcePackageCallback onLoaded = {});
+    //! Releases a package which is still loading, its callback is not called.
+    //! Resources are dropped when decoded unless another package uses them. Does nothing for loaded packages.
+    void cancelPackage(ResourcePackageHandle handle);
+    //! Releases the resources and their dependencies without reading any files.
+    //! Resources are kept while they fit the memory budget, so loading them again is cheap.
     void unloadPackage(const ResourcePackage &resources);
+    //! Merges a manifest made by getDependencyManifest, so the dependencies start decoding
+    //! along with the resources instead of after them. Format: { "path": ["dependency path", ...] }.
+    bool loadDependencyManifest(const char *path);
+    Json::Value getDependencyManifest() const;
     bool isLoading() const;
+    bool isLoading(ResourcePackageHandle handle) const;
     void flush();
     void printUnused();
 
@@ -33,7 +33,15 @@ df3d::TextureResourceData* LoadTextureDataFromFile(const char *path, Allocator &
     else
         result = TextureLoader_stbi(*textureSource, allocator, forceRgba);
 
-    fs.close(textureSource);
+    // The data may reference the source memory, keep it open until the data is released.
+    bool usesView = result && std::any_of(result->mipLevels.begin(), result->mipLevels.end(), [](const TextureResourceData::MipLevel &mip) {
+        return mip.pixelsView != nullptr;
+    });
+
+    if (usesView)
+        result->viewSource = textureSource;
+    else
+        fs.close(textureSource);
 
     return result;
 }
@@ -81,6 +89,12 @@ uint32_t GetTextureFlags(const Json::Value &root)
 
 }
 
+TextureResourceData::~TextureResourceData()
+{
+    if (viewSource)
+        svc().resourceManager().getFS().close(viewSource);
+}
+
 bool TextureHolder::decodeStartup(ResourceDataSource &dataSource, Allocator &allocator)
 {
     auto root = JsonUtils::fromFile(dataSource);
@@ -116,6 +130,14 @@ void TextureHolder::decodeCleanup(Allocator &allocator)
     m_resourceData = nullptr;
 }
 
+size_t TextureHolder::getUploadSize()
+{
+    size_t result = 0;
+    for (const auto &mipLevel : m_resourceData->mipLevels)
+        result += mipLevel.getPixelsSize();
+    return result;
+}
+
 bool TextureHolder::createResource(Allocator &allocator)
 {
     TextureHandle handle = svc().renderManager().getBackend().createTexture(*m_resourceData, m_flags);
@@ -126,6 +148,7 @@ bool TextureHolder::createResource(Allocator &allocator)
     m_resource->handle = handle;
     m_resource->width = m_resourceData->mipLevels[0].width;
     m_resource->height = m_resourceData->mipLevels[0].height;
+    m_gpuMemoryUsage = getUploadSize();
     return true;
 }
 
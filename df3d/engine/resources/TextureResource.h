@@ -5,13 +5,21 @@
 
 namespace df3d {
 
+class ResourceDataSource;
+
 struct TextureResourceData : private NonCopyable
 {
     struct MipLevel
     {
         std::vector<uint8_t> pixels;
+        //! Not owned pixels used instead of the own ones, e.g. in a memory mapped file.
+        const uint8_t *pixelsView = nullptr;
+        size_t pixelsViewSize = 0;
         size_t width = 0;
         size_t height = 0;
+
+        const uint8_t* getPixels() const { return pixelsView ? pixelsView : pixels.data(); }
+        size_t getPixelsSize() const { return pixelsView ? pixelsViewSize : pixels.size(); }
     };
 
     std::vector<MipLevel> mipLevels;
@@ -20,6 +28,12 @@ struct TextureResourceData : private NonCopyable
     // KTX data.
     uint32_t glInternalFormat = 0;
     uint32_t glBaseInternalFormat = 0;
+
+    //! Source the mip levels views point to, closed with the data.
+    ResourceDataSource *viewSource = nullptr;
+
+    TextureResourceData() = default;
+    ~TextureResourceData();
 };
 
 struct TextureResource
@@ -34,13 +48,16 @@ class TextureHolder : public IResourceHolder
     TextureResourceData *m_resourceData = nullptr;
     TextureResource *m_resource = nullptr;
     uint32_t m_flags = 0;
+    size_t m_gpuMemoryUsage = 0;
 
 public:
-    void listDependencies(ResourceDataSource &dataSource, std::vector<std::string> &outDeps) override { }
     bool decodeStartup(ResourceDataSource &dataSource, Allocator &allocator) override;
+    void listDependencies(std::vector<std::string> &outDeps) override { }
     void decodeCleanup(Allocator &allocator) override;
+    size_t getUploadSize() override;
     bool createResource(Allocator &allocator) override;
     void destroyResource(Allocator &allocator) override;
+    size_t getGpuMemoryUsage() override { return m_gpuMemoryUsage; }
 
     void* getResource() override { return m_resource; }
 };
@@ -80,9 +80,9 @@ std::vector<glm::vec2> ReadArrayVec2_UV(pugi::xml_node n)
     return result;
 }
 
-df3d::PodArray<uint16_t> ReadFaceList(pugi::xml_node n, Allocator &alloc)
+df3d::PodArray<uint32_t> ReadFaceList(pugi::xml_node n, Allocator &alloc)
 {
-    df3d::PodArray<uint16_t> result(alloc);
+    df3d::PodArray<uint32_t> result(alloc);
 
     for (pugi::xml_node faceNode = n.child("Face"); faceNode; faceNode = faceNode.next_sibling("Face"))
     {
@@ -95,8 +95,6 @@ df3d::PodArray<uint16_t> ReadFaceList(pugi::xml_node n, Allocator &alloc)
 
         sscanf(data, "%d %d %d", &idx.x, &idx.y, &idx.z);
 
-        DF3D_ASSERT(idx.x < 0xFFFF && idx.y < 0xFFFF && idx.z < 0xFFFF);
-
         result.push_back(idx.x);
         result.push_back(idx.y);
         result.push_back(idx.z);
@@ -134,9 +132,10 @@ std::vector<shared_ptr<MeshResourceData::Part>> ParseMeshes(pugi::xml_node meshL
         auto vf = Vertex_p_n_tx_tan_bitan::getFormat();
 
         auto meshPart = make_shared<MeshResourceData::Part>(vf, alloc);
-        meshPart->indicesType = INDICES_16_BIT;
         meshPart->materialName = "02___Default";
-        meshPart->indexData = ReadFaceList(meshNode.child("FaceList"), alloc);
+
+        auto faces = ReadFaceList(meshNode.child("FaceList"), alloc);
+        meshPart->setIndices(faces.data(), faces.size());
 
         for (int i = 0; i < positions.size(); i++)
         {
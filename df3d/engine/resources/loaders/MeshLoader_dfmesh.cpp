@@ -4,8 +4,81 @@
 #include <df3d/engine/resources/MeshResource.h>
 #include <df3d/engine/render/Vertex.h>
 
+#include <BulletCollision/BroadphaseCollision/btQuantizedBvh.h>
+
 namespace df3d {
 
+static bool IsAligned(const void *ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+static bool IsValidIndexSize(uint32_t indexSize)
+{
+    return indexSize == sizeof(uint16_t) || indexSize == sizeof(uint32_t);
+}
+
+static void ReadDataChunk(const DFMeshDataChunk &chunk, ResourceDataSource &dataSource, MeshResourceData &result, Allocator &alloc)
+{
+    switch (chunk.type)
+    {
+    case DFMESH_CHUNK_AABB:
+    {
+        glm::vec3 bounds[2];
+        if (chunk.dataSizeInBytes != sizeof(bounds) || !dataSource.getObjects(bounds, 2))
+            break;
+
+        result.aabb.reset();
+        result.aabb.updateBounds(bounds[0]);
+        result.aabb.updateBounds(bounds[1]);
+    }
+        break;
+    case DFMESH_CHUNK_BOUNDING_SPHERE:
+    {
+        glm::vec4 sphere;
+        if (chunk.dataSizeInBytes != sizeof(sphere) || !dataSource.getObjects(&sphere, 1))
+            break;
+
+        result.boundingSphere.setPosition(glm::vec3(sphere));
+        result.boundingSphere.setRadius(sphere.w);
+    }
+        break;
+    case DFMESH_CHUNK_CONVEX_HULL:
+        result.convexHull.resize(chunk.dataSizeInBytes / sizeof(glm::vec3));
+        if (!dataSource.getObjects(result.convexHull.data(), result.convexHull.size()))
+            result.convexHull.clear();
+        break;
+    case DFMESH_CHUNK_BVH:
+    {
+        DF3D_ASSERT(result.bvhData == nullptr);
+
+        uint32_t writerBvhSize;
+        if (chunk.dataSizeInBytes <= sizeof(writerBvhSize) || !dataSource.getObjects(&writerBvhSize, 1))
+            break;
+
+        if (writerBvhSize != sizeof(btQuantizedBvh))
+        {
+            DFLOG_DEBUG("dfmesh BVH was built for another platform, skipping");
+            break;
+        }
+
+        // Deserialized in place later, so it needs its own aligned copy.
+        const size_t size = chunk.dataSizeInBytes - sizeof(writerBvhSize);
+        result.bvhData = alloc.alloc(size, MeshResourceData::BVH_DATA_ALIGNMENT);
+        result.bvhDataSize = size;
+        if (!dataSource.getObjects((uint8_t*)result.bvhData, size))
+        {
+            alloc.dealloc(result.bvhData);
+            result.bvhData = nullptr;
+            result.bvhDataSize = 0;
+        }
+    }
+        break;
+    default:
+        break;
+    }
+}
+
 VertexFormat VertexFormat_dfmesh(uint16_t id)
 {
     // TODO:
@@ -26,41 +99,117 @@ MeshResourceData* MeshLoader_dfmesh(ResourceDataSource &dataSource, Allocator &a
         return nullptr;
     }
 
-    if (header.version != DFMESH_VERSION)
+    if (header.version == 0 || header.version > DFMESH_VERSION)
     {
         DFLOG_WARN("Unsupported dfmesh version %d", header.version);
         return nullptr;
     }
 
-    // FIXME: quad.mesh HACK
-    if (header.vertexFormat == 0)
-        DF3D_ASSERT(header.indexSize == sizeof(uint16_t));
+    if (header.version < 3 && !IsValidIndexSize(header.indexSize))
+    {
+        DFLOG_WARN("Unsupported dfmesh index size %d", header.indexSize);
+        return nullptr;
+    }
 
     // TODO: vertex format is hardcoded.
     auto vf = VertexFormat_dfmesh(header.vertexFormat);
 
     auto result = MAKE_NEW(alloc, MeshResourceData)();
 
+    // Vertices and indices are used in place when the source is in memory and they are aligned.
+    auto view = dataSource.getContiguousView();
+    const size_t sourceSize = dataSource.getSize();
+
     dataSource.seek(header.submeshesOffset, SeekDir::BEGIN);
 
     for (int i = 0; i < header.submeshesCount; i++)
     {
+        const size_t chunkOffset = dataSource.tell();
+
         DFMeshSubmeshHeader smHeader;
-        dataSource.getObjects(&smHeader, 1);
+        if (header.version >= 3)
+        {
+            dataSource.getObjects(&smHeader, 1);
+        }
+        else
+        {
+            dataSource.read(&smHeader, offsetof(DFMeshSubmeshHeader, indexSize));
+            smHeader.indexSize = header.indexSize;
+        }
+
+        if (!IsValidIndexSize(smHeader.indexSize))
+        {
+            DFLOG_WARN("Unsupported dfmesh submesh index size %d", smHeader.indexSize);
+            for (auto part : result->parts)
+                MAKE_DELETE(alloc, part);
+            MAKE_DELETE(alloc, result);
+            return nullptr;
+        }
 
         const size_t verticesCount = smHeader.vertexDataSizeInBytes / vf.getVertexSize();
-        const size_t indicesCount = smHeader.indexDataSizeInBytes / header.indexSize;
+        const size_t indicesCount = smHeader.indexDataSizeInBytes / smHeader.indexSize;
 
         auto meshPart = MAKE_NEW(alloc, MeshResourceData::Part)(vf, alloc);
-        meshPart->vertexData.addVertices(verticesCount);
-        dataSource.getObjects((uint8_t*)meshPart->vertexData.getRawData(), meshPart->vertexData.getSizeInBytes());
-
-        meshPart->indexData.resize(indicesCount);
-        dataSource.getObjects(meshPart->indexData.data(), indicesCount);
+        meshPart->indicesType = smHeader.indexSize == sizeof(uint16_t) ? INDICES_16_BIT : INDICES_32_BIT;
+
+        const size_t verticesOffset = dataSource.tell();
+        const size_t verticesSize = verticesCount * vf.getVertexSize();
+        const size_t indicesOffset = verticesOffset + verticesSize;
+
+        const size_t indicesSize = indicesCount * smHeader.indexSize;
+
+        bool inPlace = view != nullptr && indicesOffset + indicesSize <= sourceSize &&
+            IsAligned(view + verticesOffset, alignof(float)) &&
+            IsAligned(view + indicesOffset, smHeader.indexSize);
+
+        if (inPlace)
+        {
+            meshPart->vertexData.setView(view + verticesOffset, verticesSize);
+            meshPart->indexView = view + indicesOffset;
+            meshPart->indexViewCount = indicesCount;
+        }
+        else
+        {
+            meshPart->vertexData.addVertices(verticesCount);
+            dataSource.getObjects((uint8_t*)meshPart->vertexData.getRawData(), meshPart->vertexData.getSizeInBytes());
+
+            if (meshPart->indicesType == INDICES_16_BIT)
+            {
+                meshPart->indexData16.resize(indicesCount);
+                dataSource.getObjects(meshPart->indexData16.data(), indicesCount);
+            }
+            else
+            {
+                meshPart->indexData32.resize(indicesCount);
+                dataSource.getObjects(meshPart->indexData32.data(), indicesCount);
+            }
+        }
 
         meshPart->materialName = smHeader.materialId;
 
         result->parts.push_back(meshPart);
+
+        // Chunks may be padded to keep the data aligned.
+        dataSource.seek(std::max(chunkOffset + smHeader.chunkSize, indicesOffset + indicesSize), SeekDir::BEGIN);
+    }
+
+    // Precomputed data follows the submeshes.
+    while (header.version >= 2 && dataSource.tell() + sizeof(DFMeshDataChunk) <= sourceSize)
+    {
+        const size_t chunkOffset = dataSource.tell();
+
+        DFMeshDataChunk chunk;
+        dataSource.getObjects(&chunk, 1);
+
+        if (chunk.chunkSize < sizeof(chunk) + chunk.dataSizeInBytes || chunkOffset + chunk.chunkSize > sourceSize)
+        {
+            DFLOG_WARN("Invalid dfmesh data chunk");
+            break;
+        }
+
+        ReadDataChunk(chunk, dataSource, *result, alloc);
+
+        dataSource.seek(chunkOffset + chunk.chunkSize, SeekDir::BEGIN);
     }
 
     return result;
@@ -6,7 +6,9 @@ namespace df3d {
 
 const int DFMESH_MAX_MATERIAL_ID = 128;
 const char DFMESH_MAGIC[4] = { 'D', 'F', 'M', 'E' };
-const uint16_t DFMESH_VERSION = 1;
+const uint16_t DFMESH_VERSION = 3;
+//! Submesh chunks are aligned to this value, so is the vertex data as the chunk header size is a multiple of it.
+const uint32_t DFMESH_CHUNK_ALIGNMENT = 4;
 
 // File format:
 // |----------------------|
@@ -19,10 +21,11 @@ const uint16_t DFMESH_VERSION = 1;
 // | DFMeshSubmeshChunk   |
 // | etc ...              |
 // |----------------------|
-// | DFMeshMaterialHeader |
-// | material data        |
-// | ---------------------|
-// TODO: bounding volumes.
+// | DFMeshDataChunk      |
+// | etc ...              |
+// |----------------------|
+// Data chunks (version 2) are optional, the loader computes whatever is missing.
+// Index size is per submesh since version 3.
 
 #pragma pack(push, 1)
 
@@ -31,6 +34,7 @@ struct DFMeshHeader
     uint32_t magic;
     uint16_t version;
     uint16_t vertexFormat;
+    //! 2 or 4 bytes. Index size of all the submeshes before version 3, the largest one since.
     uint32_t indexSize;
 
     // ! Number of submesh chunks.
@@ -41,18 +45,49 @@ struct DFMeshHeader
 
 struct DFMeshSubmeshHeader
 {
+    //! Size of the chunk including this header and the padding.
     uint32_t chunkSize;
     uint32_t vertexDataSizeInBytes;
     uint32_t indexDataSizeInBytes;
 
     char materialId[DFMESH_MAX_MATERIAL_ID];
 
+    //! 2 or 4 bytes, version 3. Not in the older files, the header one is used.
+    uint32_t indexSize;
+
     // Vertex data.
     // Index data.
 };
 
+//! Precomputed data, skipped by the loader if unknown.
+enum DFMeshDataChunkType : uint32_t
+{
+    //! 6 floats: min, max.
+    DFMESH_CHUNK_AABB = 1,
+    //! 4 floats: center, radius.
+    DFMESH_CHUNK_BOUNDING_SPHERE,
+    //! Hull points, 3 floats each.
+    DFMESH_CHUNK_CONVEX_HULL,
+    //! uint32 sizeof(btQuantizedBvh) of the writer as the layout is platform dependent,
+    //! then btOptimizedBvh::serializeInPlace output over the triangles of MeshCollisionData.
+    DFMESH_CHUNK_BVH
+};
+
+struct DFMeshDataChunk
+{
+    uint32_t type;
+    //! Size of the chunk including this header and the padding.
+    uint32_t chunkSize;
+    uint32_t dataSizeInBytes;
+
+    // Data.
+};
+
 #pragma pack(pop)
 
+static_assert(sizeof(DFMeshSubmeshHeader) % DFMESH_CHUNK_ALIGNMENT == 0, "dfmesh: vertex data should stay aligned");
+static_assert(sizeof(DFMeshDataChunk) % DFMESH_CHUNK_ALIGNMENT == 0, "dfmesh: chunk data should stay aligned");
+
 // TODO: refactor.
 VertexFormat VertexFormat_dfmesh(uint16_t id);
 
@@ -478,7 +478,6 @@ FBXGeometry ParseGeometry(const FBXNode &node, Allocator &alloc)
     auto vf = Vertex_p_n_tx_tan_bitan::getFormat();
 
     auto meshPart = MAKE_NEW(alloc, MeshResourceData::Part)(vf, alloc);
-    meshPart->indicesType = INDICES_16_BIT;
 
     int i = 0;
     for (auto index : indices)
@@ -4,163 +4,594 @@
 #include <df3d/engine/EngineCVars.h>
 #include <df3d/engine/resources/MeshResource.h>
 #include <df3d/engine/resources/ResourceDataSource.h>
+#include <df3d/lib/JobSystem.h>
 #include <df3d/lib/Utils.h>
 
 namespace df3d {
 
+namespace {
+
+// Smaller files are parsed by the calling thread only.
+const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+const double POWERS_OF_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+const char* SkipSpaces(const char *p, const char *end)
+{
+    while (p < end && IsSpace(*p))
+        p++;
+    return p;
+}
+
+// Locale independent, handles the decimal and exponent forms only. The digits
+// past the 19th are dropped, that's well beyond the float precision.
+const char* ParseFloat(const char *p, const char *end, float &out)
+{
+    p = SkipSpaces(p, end);
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    for (; p < end && IsDigit(*p); p++)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && IsDigit(*p); p++)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExp = *p++ == '-';
+
+        int exp = 0;
+        for (; p < end && IsDigit(*p); p++)
+            exp = std::min(exp * 10 + (*p - '0'), 1000);
+
+        exponent += negativeExp ? -exp : exp;
+    }
+
+    double value = (double)mantissa;
+    if (exponent != 0 && mantissa != 0)
+    {
+        const int absExponent = std::abs(exponent);
+        auto power = absExponent <= 22 ? POWERS_OF_10[absExponent] : std::pow(10.0, absExponent);
+        value = exponent < 0 ? value / power : value * power;
+    }
+
+    out = (float)(negative ? -value : value);
+
+    return p;
+}
+
+const char* ParseInt(const char *p, const char *end, int32_t &out)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    // Numbers over 9 digits are clamped, such an index is out of range anyway.
+    int32_t value = 0;
+    for (; p < end && IsDigit(*p); p++)
+        value = value < 100000000 ? value * 10 + (*p - '0') : std::numeric_limits<int32_t>::max();
+
+    out = negative ? -value : value;
+
+    return p;
+}
+
+template<typename T>
+void Append(PodArray<T> &dst, PodArray<T> &src)
+{
+    auto offset = dst.size();
+    dst.resize(offset + src.size());
+    if (src.size() > 0)
+        memcpy(dst.data() + offset, src.data(), src.size() * sizeof(T));
+
+    src.clear();
+    src.shrink_to_fit();
+}
+
+bool IsKeyword(const char *p, const char *end, const char *keyword, size_t len)
+{
+    return (size_t)(end - p) == len && memcmp(p, keyword, len) == 0;
+}
+
+//! Face vertex as written in the file: 1-based indices, 0 if missing, negative ones are relative.
+struct FaceVertex
+{
+    int32_t v;
+    int32_t vt;
+    int32_t vn;
+};
+
+enum RelativeIndexFlags
+{
+    RELATIVE_V = 1 << 0,
+    RELATIVE_VT = 1 << 1,
+    RELATIVE_VN = 1 << 2
+};
+
+//! Negative indices count back from the last attribute read. The chunk doesn't know how many
+//! the previous chunks have, so they are made relative to the chunk start here.
+uint32_t MakeChunkLocal(int32_t &index, size_t chunkCount, uint32_t flag)
+{
+    if (index >= 0)
+        return 0;
+
+    index = (int32_t)chunkCount + index + 1;
+    return flag;
+}
+
+//! Chunk local index to the file one, -1 if it's before the first attribute.
+int32_t ResolveChunkLocal(int32_t index, size_t chunkFirst)
+{
+    auto result = (int64_t)index + (int64_t)chunkFirst;
+    return result >= 1 ? (int32_t)result : -1;
+}
+
+//! Part of the file parsed by a single job.
+struct ObjChunk
+{
+    struct MaterialRun
+    {
+        std::string name;
+        size_t firstFaceVertex;
+    };
+
+    //! Face vertex with chunk local indices, see MakeChunkLocal.
+    struct RelativeFaceVertex
+    {
+        size_t faceVertex;
+        uint32_t flags;
+    };
+
+    //! Segment of the face vertices going to a mesh part.
+    struct Segment
+    {
+        size_t part;
+        size_t firstFaceVertex;
+        size_t lastFaceVertex;
+        size_t firstPartVertex;
+    };
+
+    const char *begin;
+    const char *end;
+
+    PodArray<glm::vec3> positions;
+    PodArray<glm::vec3> normals;
+    PodArray<glm::vec2> txCoords;
+    PodArray<FaceVertex> faceVertices;
+    std::vector<RelativeFaceVertex> relativeFaceVertices;
+
+    //! Counts of the attributes in the previous chunks.
+    size_t firstPosition = 0;
+    size_t firstNormal = 0;
+    size_t firstTxCoord = 0;
+    //! Faces referring to missing attributes.
+    size_t droppedFaces = 0;
+
+    //! usemtl lines of the chunk. Faces before the first one continue the material of the previous chunk.
+    std::vector<MaterialRun> materials;
+    std::vector<Segment> segments;
+
+    ObjChunk(Allocator &alloc)
+        : positions(alloc),
+        normals(alloc),
+        txCoords(alloc),
+        faceVertices(alloc)
+    {
+
+    }
+};
+
+}
+
 class MeshLoader_obj_state
 {
     Allocator &m_alloc;
 
+    // Whole file attributes.
     PodArray<glm::vec3> m_vertices;
     PodArray<glm::vec3> m_normals;
     PodArray<glm::vec2> m_txCoords;
 
-    // Merged (by material) submeshes.
-    std::unordered_map<std::string, MeshResourceData::Part*> m_meshParts;
-    MeshResourceData::Part *m_currentMeshPart = nullptr;
+    // Merged (by material) submeshes, in order of first use.
+    std::vector<MeshResourceData::Part*> m_meshParts;
+    std::unordered_map<std::string, size_t> m_materialLookup;
+
     MeshResourceData::Part* createMeshPart()
     {
         const auto &vertexFormat = Vertex_p_n_tx_tan_bitan::getFormat();
         return MAKE_NEW(m_alloc, MeshResourceData::Part)(vertexFormat, m_alloc);
     }
 
+    size_t getMeshPart(const std::string &material)
+    {
+        // Create new vertex cache if not found.
+        auto found = m_materialLookup.find(material);
+        if (found != m_materialLookup.end())
+            return found->second;
+
+        auto meshPart = createMeshPart();
+        meshPart->materialName = material;
+
+        m_meshParts.push_back(meshPart);
+        m_materialLookup[material] = m_meshParts.size() - 1;
+
+        return m_meshParts.size() - 1;
+    }
+
     bool hasNormals() const { return m_normals.size() > 0; }
-    bool hasTxCoords() const { return m_txCoords.size() > 0; }
 
-    void processLine_v(std::istream &is)
+    static void processLine_v(const char *p, const char *end, ObjChunk &chunk)
     {
         glm::vec3 v;
-        is >> v.x >> v.y >> v.z;
+        p = ParseFloat(p, end, v.x);
+        p = ParseFloat(p, end, v.y);
+        ParseFloat(p, end, v.z);
 
-        m_vertices.push_back(v);
+        chunk.positions.push_back(v);
     }
 
-    void processLine_vt(std::istream &is)
+    static void processLine_vt(const char *p, const char *end, ObjChunk &chunk)
     {
         glm::vec2 uv;
-        is >> uv.x >> uv.y;
+        p = ParseFloat(p, end, uv.x);
+        ParseFloat(p, end, uv.y);
 
         // NOTE:
         // Invert for OpenGL
         // FIXME: if DirectX???
         uv.y = 1.0f - uv.y;
 
-        m_txCoords.push_back(uv);
+        chunk.txCoords.push_back(uv);
     }
 
-    void processLine_vn(std::istream &is)
+    static void processLine_vn(const char *p, const char *end, ObjChunk &chunk)
     {
         glm::vec3 vertexNormal;
-        is >> vertexNormal.x >> vertexNormal.y >> vertexNormal.z;
+        p = ParseFloat(p, end, vertexNormal.x);
+        p = ParseFloat(p, end, vertexNormal.y);
+        ParseFloat(p, end, vertexNormal.z);
 
-        m_normals.push_back(vertexNormal);
-    }
-
-    void processLine_vp(std::istream &is)
-    {
-        utils::skip_line(is);
+        chunk.normals.push_back(vertexNormal);
     }
 
-    void processLine_f(std::istream &is)
+    static void processLine_f(const char *p, const char *end, ObjChunk &chunk)
     {
-        DF3D_ASSERT(m_currentMeshPart != nullptr);
-
         size_t verticesCount = 0;
+        uint32_t relative = 0;
         // FIXME:
         // Only triangles.
         while (verticesCount < 3)
         {
-            char temp;
-
-            verticesCount++;
-            int vertexidx = 0;
-            int normalidx = 0;
-            int uvidx = 0;
+            p = SkipSpaces(p, end);
+            if (p == end)
+                break;
 
-            // vertex
-            if (!hasNormals() && !hasTxCoords())
-            {
-                is >> vertexidx;
-                DF3D_ASSERT(vertexidx >= 1);
-            }
-            // vertex//normal
-            else if (!hasTxCoords())
+            // vertex[/texture][/normal] or vertex//normal
+            FaceVertex fv = { 0, 0, 0 };
+            p = ParseInt(p, end, fv.v);
+            if (p < end && *p == '/')
             {
-                is >> vertexidx >> temp >> temp >> normalidx;
-                DF3D_ASSERT(vertexidx >= 1 && normalidx >= 1);
+                p++;
+                if (p < end && *p != '/')
+                    p = ParseInt(p, end, fv.vt);
+                if (p < end && *p == '/')
+                    p = ParseInt(p + 1, end, fv.vn);
             }
-            // vertex/texture
-            else if (!hasNormals())
-            {
-                is >> vertexidx >> temp >> uvidx;
-                DF3D_ASSERT(vertexidx >= 1 && uvidx >= 1);
-            }
-            // vertex/texture/normal
-            else
+
+            relative = MakeChunkLocal(fv.v, chunk.positions.size(), RELATIVE_V) |
+                MakeChunkLocal(fv.vt, chunk.txCoords.size(), RELATIVE_VT) |
+                MakeChunkLocal(fv.vn, chunk.normals.size(), RELATIVE_VN);
+            if (relative)
+                chunk.relativeFaceVertices.push_back({ chunk.faceVertices.size(), relative });
+
+            chunk.faceVertices.push_back(fv);
+            verticesCount++;
+
+            // Skip the rest of a malformed token.
+            while (p < end && !IsSpace(*p))
+                p++;
+        }
+
+        DF3D_ASSERT_MESS(verticesCount == 3, "Only triangles supported in obj loader");
+
+        // Keep the face vertices in triples.
+        if (verticesCount > 0)
+        {
+            auto last = chunk.faceVertices.back();
+            for (; verticesCount < 3; verticesCount++)
             {
-                is >> vertexidx >> temp >> uvidx >> temp >> normalidx;
-                DF3D_ASSERT(vertexidx >= 1 && uvidx >= 1 && normalidx >= 1);
+                if (relative)
+                    chunk.relativeFaceVertices.push_back({ chunk.faceVertices.size(), relative });
+                chunk.faceVertices.push_back(last);
             }
+        }
+    }
 
-            auto &vdata = m_currentMeshPart->vertexData;
-            vdata.addVertex();
+    static void processLine_mtl(const char *p, const char *end, ObjChunk &chunk)
+    {
+        p = SkipSpaces(p, end);
 
-            auto v = (Vertex_p_n_tx_tan_bitan *)vdata.getVertex(vdata.getVerticesCount() - 1);
+        auto nameEnd = p;
+        while (nameEnd < end && !IsSpace(*nameEnd))
+            nameEnd++;
 
-            v->pos = m_vertices[vertexidx - 1];
-            if (normalidx > 0)
-                v->normal = m_normals[normalidx - 1];
-            else
-                v->normal = { 0.0f, 0.0f, 0.0f };
-            if (uvidx > 0)
-                v->uv = m_txCoords[uvidx - 1];
-            else
-                v->uv = { 0.0f, 0.0f };
+        chunk.materials.push_back({ std::string(p, nameEnd), chunk.faceVertices.size() });
+    }
 
-            v->tangent = {};
-            v->bitangent = {};
+    static void parseChunk(ObjChunk &chunk)
+    {
+        auto p = chunk.begin;
 
-            if (!is.good())
-                break;
+        while (p < chunk.end)
+        {
+            auto lineEnd = (const char *)memchr(p, '\n', chunk.end - p);
+            if (!lineEnd)
+                lineEnd = chunk.end;
+
+            auto tok = SkipSpaces(p, lineEnd);
+            auto tokEnd = tok;
+            while (tokEnd < lineEnd && !IsSpace(*tokEnd))
+                tokEnd++;
+
+            // Comments, o, g, s, vp, mtllib and empty lines are skipped.
+            if (IsKeyword(tok, tokEnd, "f", 1))
+                processLine_f(tokEnd, lineEnd, chunk);
+            else if (IsKeyword(tok, tokEnd, "v", 1))
+                processLine_v(tokEnd, lineEnd, chunk);
+            else if (IsKeyword(tok, tokEnd, "vt", 2))
+                processLine_vt(tokEnd, lineEnd, chunk);
+            else if (IsKeyword(tok, tokEnd, "vn", 2))
+                processLine_vn(tokEnd, lineEnd, chunk);
+            else if (IsKeyword(tok, tokEnd, "usemtl", 6))
+                processLine_mtl(tokEnd, lineEnd, chunk);
+
+            p = lineEnd + 1;
         }
+    }
 
-        DF3D_ASSERT_MESS(verticesCount == 3, "Only triangles supported in obj loader");
+    void mergeAttributes(std::vector<unique_ptr<ObjChunk>> &chunks)
+    {
+        size_t verticesCount = 0, normalsCount = 0, txCoordsCount = 0;
+        for (const auto &chunk : chunks)
+        {
+            chunk->firstPosition = verticesCount;
+            chunk->firstNormal = normalsCount;
+            chunk->firstTxCoord = txCoordsCount;
+
+            verticesCount += chunk->positions.size();
+            normalsCount += chunk->normals.size();
+            txCoordsCount += chunk->txCoords.size();
+        }
+
+        m_vertices.reserve(verticesCount);
+        m_normals.reserve(normalsCount);
+        m_txCoords.reserve(txCoordsCount);
+
+        for (auto &chunk : chunks)
+        {
+            Append(m_vertices, chunk->positions);
+            Append(m_normals, chunk->normals);
+            Append(m_txCoords, chunk->txCoords);
+        }
     }
 
-    void processLine_mtl(std::istream &is)
+    //! Resolves the relative indices and drops the faces referring to missing attributes.
+    void resolveFaces(ObjChunk &chunk) const
     {
-        std::string material;
-        is >> material;
+        for (const auto &relative : chunk.relativeFaceVertices)
+        {
+            auto &fv = chunk.faceVertices[relative.faceVertex];
+            if (relative.flags & RELATIVE_V)
+                fv.v = ResolveChunkLocal(fv.v, chunk.firstPosition);
+            if (relative.flags & RELATIVE_VT)
+                fv.vt = ResolveChunkLocal(fv.vt, chunk.firstTxCoord);
+            if (relative.flags & RELATIVE_VN)
+                fv.vn = ResolveChunkLocal(fv.vn, chunk.firstNormal);
+        }
+        chunk.relativeFaceVertices.clear();
+
+        const auto verticesCount = (int32_t)m_vertices.size();
+        const auto normalsCount = (int32_t)m_normals.size();
+        const auto txCoordsCount = (int32_t)m_txCoords.size();
+        auto isValid = [=](const FaceVertex &fv) {
+            return fv.v >= 1 && fv.v <= verticesCount && fv.vt >= 0 && fv.vt <= txCoordsCount && fv.vn >= 0 && fv.vn <= normalsCount;
+        };
+
+        // Face vertices are in triples, the material runs start at a face.
+        size_t kept = 0, material = 0;
+        for (size_t i = 0; i < chunk.faceVertices.size(); i += 3)
+        {
+            for (; material < chunk.materials.size() && chunk.materials[material].firstFaceVertex <= i; material++)
+                chunk.materials[material].firstFaceVertex = kept;
+
+            if (!isValid(chunk.faceVertices[i]) || !isValid(chunk.faceVertices[i + 1]) || !isValid(chunk.faceVertices[i + 2]))
+            {
+                chunk.droppedFaces++;
+                continue;
+            }
+
+            if (kept != i)
+            {
+                for (size_t j = 0; j < 3; j++)
+                    chunk.faceVertices[kept + j] = chunk.faceVertices[i + j];
+            }
+            kept += 3;
+        }
+
+        for (; material < chunk.materials.size(); material++)
+            chunk.materials[material].firstFaceVertex = kept;
 
-        // Create new vertex cache if not found, set as current.
-        auto found = m_meshParts.find(material);
-        if (found == m_meshParts.end())
+        chunk.faceVertices.resize(kept);
+    }
+
+    void assignParts(std::vector<unique_ptr<ObjChunk>> &chunks)
+    {
+        size_t droppedFaces = 0;
+        for (const auto &chunk : chunks)
+            droppedFaces += chunk->droppedFaces;
+        if (droppedFaces > 0)
+            DFLOG_WARN("Obj faces referring to missing vertex attributes are skipped: %d", (int)droppedFaces);
+
+        // Assign the faces to the parts and find where they go in the part vertex data.
+        const size_t NO_PART = (size_t)-1;
+        size_t currentPart = NO_PART;
+        std::vector<size_t> partVerticesCount;
+
+        for (auto &chunk : chunks)
         {
-            auto meshPart = createMeshPart();
+            size_t faceVertex = 0;
+            for (size_t i = 0; i <= chunk->materials.size(); i++)
+            {
+                auto last = i < chunk->materials.size() ? chunk->materials[i].firstFaceVertex : chunk->faceVertices.size();
+                if (last > faceVertex)
+                {
+                    if (currentPart != NO_PART)
+                    {
+                        chunk->segments.push_back({ currentPart, faceVertex, last, partVerticesCount[currentPart] });
+                        partVerticesCount[currentPart] += last - faceVertex;
+                    }
+                    else
+                    {
+                        DFLOG_WARN("Obj faces without a material are skipped");
+                    }
+                }
+
+                if (i < chunk->materials.size())
+                {
+                    currentPart = getMeshPart(chunk->materials[i].name);
+                    partVerticesCount.resize(m_meshParts.size(), 0);
+                    faceVertex = last;
+                }
+            }
 
-            m_meshParts[material] = meshPart;
-            m_currentMeshPart = meshPart;
+            chunk->materials.clear();
         }
-        else
+
+        for (size_t i = 0; i < m_meshParts.size(); i++)
+            m_meshParts[i]->vertexData.addVertices(partVerticesCount[i]);
+    }
+
+    void fillVertices(const ObjChunk &chunk)
+    {
+        // The indices are checked by resolveFaces.
+        for (const auto &segment : chunk.segments)
         {
-            m_currentMeshPart = found->second;
+            auto v = (Vertex_p_n_tx_tan_bitan *)m_meshParts[segment.part]->vertexData.getVertex(segment.firstPartVertex);
+
+            for (size_t i = segment.firstFaceVertex; i < segment.lastFaceVertex; i++, v++)
+            {
+                const auto &fv = chunk.faceVertices[i];
+
+                v->pos = m_vertices[fv.v - 1];
+                if (fv.vn > 0)
+                    v->normal = m_normals[fv.vn - 1];
+                else
+                    v->normal = { 0.0f, 0.0f, 0.0f };
+                if (fv.vt > 0)
+                    v->uv = m_txCoords[fv.vt - 1];
+                else
+                    v->uv = { 0.0f, 0.0f };
+
+                v->tangent = {};
+                v->bitangent = {};
+            }
         }
     }
 
-    void processLine_o(std::istream &is)
+    void indexize(MeshResourceData::Part &meshPart)
     {
-        utils::skip_line(is);
+        const auto vData = (Vertex_p_n_tx_tan_bitan*)meshPart.vertexData.getRawData();
+        const auto vCount = meshPart.vertexData.getVerticesCount();
+
+        PodArray<Vertex_p_n_tx_tan_bitan> indexedVertices(m_alloc);
+        PodArray<uint32_t> indices(m_alloc);
+
+        MeshUtils::indexize(vData, vCount, indexedVertices, indices, EngineCVars::objWeldEpsilon);
+
+        MeshUtils::optimizeVertexCache(indices.data(), indices.size(), indexedVertices.size());
+
+        /*
+        DFLOG_DEBUG("Vertices before: %d, AFTER indexed: %d. Indices %d", vCount, indexedVertices.size(), indices.size());
+        DFLOG_DEBUG("Size before %d KB, size after %d KB", utils::sizeKB(sizeof(Vertex_p_n_tx_tan_bitan) * vCount),
+        utils::sizeKB(sizeof(Vertex_p_n_tx_tan_bitan) * indexedVertices.size() + indices.size() * sizeof(uint32_t)));
+        */
+
+        VertexData newData(meshPart.vertexData.getFormat());
+        newData.addVertices(indexedVertices.size());
+        memcpy(newData.getRawData(), indexedVertices.data(), newData.getSizeInBytes());
+
+        meshPart.vertexData = std::move(newData);
+        meshPart.setIndices(indices.data(), indices.size());
     }
 
-    void processLine_g(std::istream &is)
+    void processPart(MeshResourceData::Part &meshPart)
     {
-        utils::skip_line(is);
+        const auto vData = (Vertex_p_n_tx_tan_bitan*)meshPart.vertexData.getRawData();
+        const auto vCount = meshPart.vertexData.getVerticesCount();
+        MeshUtils::computeTangentBasis(vData, vCount);
+
+        if (EngineCVars::objIndexize)
+            indexize(meshPart);
     }
 
-    void processLine_s(std::istream &is)
+    template<typename F>
+    static void parallelFor(JobSystem *jobs, size_t count, F &&fn)
     {
-        utils::skip_line(is);
+        if (!jobs)
+        {
+            for (size_t i = 0; i < count; i++)
+                fn(i);
+            return;
+        }
+
+        jobs->parallelFor(0, count, 1, [&fn](size_t from, size_t to) {
+            for (auto i = from; i < to; i++)
+                fn(i);
+        });
     }
 
 public:
@@ -178,97 +609,79 @@ public:
 
     }
 
-    MeshResourceData* load(ResourceDataSource &dataSource)
+    MeshResourceData* load(ResourceDataSource &dataSource, JobSystem *jobs)
     {
-        // Parse obj. TODO: can use stream directly.
-        std::string buffer(dataSource.getSize(), 0);
-        dataSource.read(&buffer[0], buffer.size());
+        // Parse the source in place when possible.
+        const size_t size = dataSource.getSize();
+        PodArray<char> buffer(m_alloc);
 
-        std::istringstream input(std::move(buffer));
-        std::string tok;
-        while (input >> tok)
+        auto text = (const char *)dataSource.getContiguousView();
+        if (!text)
         {
-            utils::trim_left(tok);
-
-            if (tok.empty() || tok[0] == '#')
-            {
-                utils::skip_line(input);
-                continue;
-            }
-
-            if (tok == "f")
-                processLine_f(input);
-            else if (tok == "v")
-                processLine_v(input);
-            else if (tok == "vt")
-                processLine_vt(input);
-            else if (tok == "vn")
-                processLine_vn(input);
-            else if (tok == "vp")
-                processLine_vp(input);
-            else if (tok == "usemtl")
-                processLine_mtl(input);
-            else if (tok == "o")
-                processLine_o(input);
-            else if (tok == "g")
-                processLine_g(input);
-            else if (tok == "s")
-                processLine_s(input);
-            //else if (tok == "mtllib") {}
+            buffer.resize(size);
+            dataSource.read(buffer.data(), size);
+            text = buffer.data();
         }
 
-        bool computeNormals = !hasNormals();
-
-        auto result = MAKE_NEW(m_alloc, MeshResourceData)();
+        // Chunks end at line boundaries.
+        const size_t threadsCount = jobs ? jobs->getWorkersCount() + 1 : 1;
+        const size_t chunksCount = std::max<size_t>(1, std::min(size / MIN_CHUNK_SIZE, threadsCount * 4));
 
-        for (auto &kv : m_meshParts)
+        std::vector<unique_ptr<ObjChunk>> chunks;
+        auto chunkBegin = text;
+        for (size_t i = 1; i <= chunksCount; i++)
         {
-            if (computeNormals)
+            auto chunkEnd = text + size * i / chunksCount;
+            if (chunkEnd < chunkBegin)
+                chunkEnd = chunkBegin;
+            if (i < chunksCount)
             {
-                //DFLOG_DEBUG("Computing normals in %s", dataSource.getResourceId().c_str());
-                DF3D_ASSERT(false);
-                //MeshUtils::computeNormals(*s.second);
+                auto lineEnd = (const char *)memchr(chunkEnd, '\n', text + size - chunkEnd);
+                chunkEnd = lineEnd ? lineEnd + 1 : text + size;
+            }
+            else
+            {
+                chunkEnd = text + size;
             }
 
-            auto meshPart = kv.second;
-
-            const auto vData = (Vertex_p_n_tx_tan_bitan*)meshPart->vertexData.getRawData();
-            const auto vCount = meshPart->vertexData.getVerticesCount();
-            MeshUtils::computeTangentBasis(vData, vCount);
+            chunks.push_back(make_unique<ObjChunk>(m_alloc));
+            chunks.back()->begin = chunkBegin;
+            chunks.back()->end = chunkEnd;
 
-            if (EngineCVars::objIndexize)
-            {
-                PodArray<Vertex_p_n_tx_tan_bitan> indexedVertices(m_alloc);
-                PodArray<uint16_t> indices(m_alloc);
+            chunkBegin = chunkEnd;
+        }
 
-                MeshUtils::indexize(vData, vCount, indexedVertices, indices);
+        parallelFor(jobs, chunks.size(), [&chunks](size_t i) { parseChunk(*chunks[i]); });
 
-                /*
-                DFLOG_DEBUG("Vertices before: %d, AFTER indexed: %d. Indices %d", vCount, indexedVertices.size(), indices.size());
-                DFLOG_DEBUG("Size before %d KB, size after %d KB", utils::sizeKB(sizeof(Vertex_p_n_tx_tan_bitan) * vCount),
-                utils::sizeKB(sizeof(Vertex_p_n_tx_tan_bitan) * indexedVertices.size() + indices.size() * sizeof(uint32_t)));
-                */
+        mergeAttributes(chunks);
 
-                VertexData newData(meshPart->vertexData.getFormat());
-                newData.addVertices(indexedVertices.size());
-                memcpy(newData.getRawData(), indexedVertices.data(), newData.getSizeInBytes());
+        parallelFor(jobs, chunks.size(), [this, &chunks](size_t i) { resolveFaces(*chunks[i]); });
 
-                meshPart->vertexData = std::move(newData);
-                meshPart->indexData = std::move(indices);
-            }
+        assignParts(chunks);
 
-            meshPart->materialName = kv.first;
-            result->parts.push_back(meshPart);
+        if (!hasNormals())
+        {
+            // TODO: compute normals.
+            DF3D_ASSERT_MESS(false, "Obj mesh without normals isn't supported");
         }
 
+        parallelFor(jobs, chunks.size(), [this, &chunks](size_t i) { fillVertices(*chunks[i]); });
+
+        chunks.clear();
+
+        parallelFor(jobs, m_meshParts.size(), [this](size_t i) { processPart(*m_meshParts[i]); });
+
+        auto result = MAKE_NEW(m_alloc, MeshResourceData)();
+        result->parts = m_meshParts;
+
         return result;
     }
 };
 
-MeshResourceData* MeshLoader_obj(ResourceDataSource &dataSource, Allocator &alloc)
+MeshResourceData* MeshLoader_obj(ResourceDataSource &dataSource, Allocator &alloc, JobSystem *jobs)
 {
     auto loader = MAKE_NEW(alloc, MeshLoader_obj_state)(alloc);
-    auto result = loader->load(dataSource);
+    auto result = loader->load(dataSource, jobs);
     MAKE_DELETE(alloc, loader);
     return result;
 }
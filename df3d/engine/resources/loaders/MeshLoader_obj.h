@@ -4,7 +4,9 @@ namespace df3d {
 
 struct MeshResourceData;
 class ResourceDataSource;
+class JobSystem;
 
-MeshResourceData* MeshLoader_obj(ResourceDataSource &dataSource, Allocator &alloc);
+//! Big files are parsed in chunks on the job system if given.
+MeshResourceData* MeshLoader_obj(ResourceDataSource &dataSource, Allocator &alloc, JobSystem *jobs = nullptr);
 
 }
@@ -111,11 +111,13 @@ TextureResourceData* TextureLoader_ktx(ResourceDataSource &dataSource, Allocator
     }
     resource->glInternalFormat = header.glInternalFormat;
 
-    void *buffer = nullptr;
-    uint32_t bufferSize = 0;
+    // Compressed blocks are used in place when the source is in memory.
+    auto view = dataSource.getContiguousView();
+    const size_t sourceSize = dataSource.getSize();
 
     resource->mipLevels.resize(header.numberOfMipmapLevels);
 
+    uint32_t prevFaceLodSize = 0;
     for (uint32_t level = 0; level < header.numberOfMipmapLevels; ++level)
     {
         uint32_t pixelWidth = std::max(1u, header.pixelWidth >> level);
@@ -126,28 +128,46 @@ TextureResourceData* TextureLoader_ktx(ResourceDataSource &dataSource, Allocator
 
         uint32_t faceLodSizeRounded = (faceLodSize + 3) & ~(uint32_t)3;
 
-        if (!buffer)
-        {
-            buffer = malloc(faceLodSizeRounded);
-            bufferSize = faceLodSizeRounded;
-        }
-        else if (bufferSize < faceLodSizeRounded)
+        if (level > 0 && prevFaceLodSize < faceLodSizeRounded)
         {
             DFLOG_WARN("Subsequent levels cannot be larger than the first level");
+            resource->mipLevels.resize(level);
             break;
         }
+        prevFaceLodSize = faceLodSizeRounded;
 
-        dataSource.read(buffer, faceLodSizeRounded);
+        const size_t offset = dataSource.tell();
+        if (offset + faceLodSize > sourceSize)
+        {
+            DFLOG_WARN("Unexpected end of KTX data");
+            resource->mipLevels.resize(level);
+            break;
+        }
 
         auto &mipLevel = resource->mipLevels[level];
 
         mipLevel.width = pixelWidth;
         mipLevel.height = pixelHeight;
-        mipLevel.pixels.resize(faceLodSize);
-        memcpy(mipLevel.pixels.data(), buffer, faceLodSize);
+
+        if (view)
+        {
+            mipLevel.pixelsView = view + offset;
+            mipLevel.pixelsViewSize = faceLodSize;
+        }
+        else
+        {
+            mipLevel.pixels.resize(faceLodSize);
+            dataSource.read(mipLevel.pixels.data(), faceLodSize);
+        }
+
+        dataSource.seek(offset + faceLodSizeRounded, SeekDir::BEGIN);
     }
 
-    free(buffer);
+    if (resource->mipLevels.empty())
+    {
+        MAKE_DELETE(alloc, resource);
+        return nullptr;
+    }
 
     return resource;
 }
@@ -8,12 +8,19 @@ namespace df3d {
 
 TextureResourceData* TextureLoader_webp(ResourceDataSource &dataSource, Allocator &alloc, bool forceRGBA)
 {
-    PodArray<uint8_t> webpData(alloc);
-    webpData.resize(dataSource.getSize());
-    dataSource.read(&webpData[0], webpData.size());
+    // Decode in place when the data is in memory already.
+    PodArray<uint8_t> webpBuffer(alloc);
+    const uint8_t *webpData = dataSource.getContiguousView();
+    const size_t webpDataSize = dataSource.getSize();
+    if (!webpData)
+    {
+        webpBuffer.resize(webpDataSize);
+        dataSource.read(webpBuffer.data(), webpDataSize);
+        webpData = webpBuffer.data();
+    }
 
     WebPBitstreamFeatures features;
-    if (WebPGetFeatures(webpData.data(), webpData.size(), &features) != VP8_STATUS_OK)
+    if (WebPGetFeatures(webpData, webpDataSize, &features) != VP8_STATUS_OK)
     {
         DFLOG_WARN("Failed to load a texture: WebPGetInfo failed");
         return nullptr;
@@ -33,7 +40,7 @@ TextureResourceData* TextureLoader_webp(ResourceDataSource &dataSource, Allocato
 
         pixels.resize(features.width * features.height * 4);
 
-        result = WebPDecodeRGBAInto(webpData.data(), webpData.size(), &pixels[0], pixels.size(), features.width * 4) != nullptr;
+        result = WebPDecodeRGBAInto(webpData, webpDataSize, &pixels[0], pixels.size(), features.width * 4) != nullptr;
     }
     else
     {
@@ -41,7 +48,7 @@ TextureResourceData* TextureLoader_webp(ResourceDataSource &dataSource, Allocato
 
         pixels.resize(features.width * features.height * 3);
 
-        result = WebPDecodeRGBInto(webpData.data(), webpData.size(), &pixels[0], pixels.size(), features.width * 3) != nullptr;
+        result = WebPDecodeRGBInto(webpData, webpDataSize, &pixels[0], pixels.size(), features.width * 3) != nullptr;
     }
 
     if (!result)
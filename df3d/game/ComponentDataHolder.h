@@ -1,6 +1,7 @@
 #pragma once
 
 #include <df3d/game/Entity.h>
+#include <df3d/lib/Utils.h>
 
 namespace df3d {
 
@@ -55,6 +56,19 @@ public:
         m_holdersLookup.push_back(ent);
     }
 
+    //! Reserves the pools and the lookup for the entities about to be added.
+    void reserve(const Entity *entities, size_t count)
+    {
+        utils::reserve_more(m_data, count);
+        utils::reserve_more(m_holdersLookup, count);
+
+        size_t maxIndex = 0;
+        for (size_t i = 0; i < count; i++)
+            maxIndex = std::max(maxIndex, (size_t)entities[i].getIndex());
+        if (count > 0 && m_lookup.size() <= maxIndex)
+            m_lookup.resize(maxIndex + 1, InvalidComponentInstance);
+    }
+
     void remove(Entity ent)
     {
         DF3D_ASSERT(m_data.size() > 0 && contains(ent));
@@ -80,6 +94,13 @@ public:
         }
     }
 
+    //! Index of the entity data in rawData.
+    size_t getIndex(Entity ent) const
+    {
+        DF3D_ASSERT(contains(ent));
+        return m_lookup[ent.getIndex()];
+    }
+
     bool contains(Entity ent) const
     {
         DF3D_ASSERT(ent.isValid());
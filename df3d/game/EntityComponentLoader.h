@@ -8,10 +8,54 @@ class World;
 
 class EntityComponentLoader
 {
+protected:
+    //! Helpers for the flat compiled component records.
+    template<typename T>
+    static void writeCompiled(const T &value, std::vector<uint8_t> &output)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "compiled component data should be a POD");
+
+        auto bytes = reinterpret_cast<const uint8_t *>(&value);
+        output.insert(output.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    static bool readCompiled(const uint8_t *&data, const uint8_t *end, T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "compiled component data should be a POD");
+
+        if (size_t(end - data) < sizeof(T))
+        {
+            DFLOG_WARN("Invalid compiled component data");
+            return false;
+        }
+
+        memcpy(&value, data, sizeof(T));
+        data += sizeof(T);
+        return true;
+    }
+
+    static Id compiledId(uint32_t hash)
+    {
+        Id result;
+        result.m_id = hash;
+        return result;
+    }
+
 public:
     virtual ~EntityComponentLoader() = default;
 
     virtual void loadComponent(const Json::Value &root, Entity e, World &w) const = 0;
+
+    //! Compiled entities support. Components of the loaders returning false are compiled as json.
+    virtual bool compileComponent(const Json::Value &root, std::vector<uint8_t> &output) const { return false; }
+    virtual void loadCompiledComponent(const uint8_t *data, size_t size, Entity e, World &w) const { }
+    //! Loads the same component to several entities, overridden by loaders that can do it in bulk.
+    virtual void loadCompiledComponentBatch(const uint8_t *data, size_t size, const Entity *entities, size_t count, World &w) const
+    {
+        for (size_t i = 0; i < count; i++)
+            loadCompiledComponent(data, size, entities[i], w);
+    }
 };
 
 }
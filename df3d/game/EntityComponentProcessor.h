@@ -14,6 +14,9 @@ public:
 
     virtual void update() = 0;
     virtual void draw(RenderQueue *ops) { }
+    //! Whether draw may run on a worker thread concurrently with other processors.
+    //! It must not touch the render backend then.
+    virtual bool supportsParallelDraw() const { return false; }
     virtual bool has(Entity e) = 0;
     virtual void remove(Entity e) = 0;
 };
@@ -0,0 +1,28 @@
+#pragma once
+
+namespace df3d {
+
+namespace game_impl { class EntityLoader; }
+
+//! An entity resource resolved once for spawning many instances, see World::spawnBatch.
+//! Keeps its own compiled copy of the resource, but the resources it depends on
+//! (meshes, materials, etc) should stay loaded.
+class EntityPrototype : NonCopyable
+{
+    friend class game_impl::EntityLoader;
+
+    Id m_resourceId;
+    std::vector<uint8_t> m_binary;
+    // Components compiled as json, parsed up front. Keyed by component record index.
+    std::unordered_map<uint32_t, Json::Value> m_jsonComponents;
+    size_t m_entitiesCount = 0;
+
+public:
+    EntityPrototype(Id resourceId) : m_resourceId(resourceId) { }
+
+    Id getResourceId() const { return m_resourceId; }
+    //! Entities spawned per instance, the root and its children.
+    size_t getEntitiesCount() const { return m_entitiesCount; }
+};
+
+}
@@ -48,6 +48,19 @@ void TagComponentProcessor::add(Entity e, Id tag)
     m_entities[tag].insert(e);
 }
 
+void TagComponentProcessor::add(const Entity *entities, size_t count, Id tag)
+{
+    auto &tagged = m_entities[tag];
+    tagged.reserve(tagged.size() + count);
+    m_tagLookup.reserve(m_tagLookup.size() + count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        m_tagLookup[entities[i]].insert(tag);
+        tagged.insert(entities[i]);
+    }
+}
+
 void TagComponentProcessor::remove(Entity e)
 {
     auto tags = m_tagLookup.find(e);
@@ -27,6 +27,7 @@ public:
     void removeTag(Entity e, Id tag);
 
     void add(Entity e, Id tag);
+    void add(const Entity *entities, size_t count, Id tag);
     void remove(Entity e) override;
     bool has(Entity e) override;
 };
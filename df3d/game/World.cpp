@@ -1,8 +1,10 @@
 #include "World.h"
 
 #include "impl/EntityLoader.h"
+#include "EntityPrototype.h"
 #include <df3d/engine/TimeManager.h>
 #include <df3d/engine/EngineController.h>
+#include <df3d/lib/memory/FrameAllocator.h>
 #include <df3d/engine/2d/Sprite2DComponentProcessor.h>
 #include <df3d/engine/3d/StaticMeshComponentProcessor.h>
 #include <df3d/engine/3d/SceneGraphComponentProcessor.h>
@@ -12,6 +14,9 @@
 #include <df3d/game/EntityComponentLoader.h>
 #include <df3d/engine/physics/PhysicsComponentProcessor.h>
 #include <df3d/engine/render/RenderQueue.h>
+#include <df3d/lib/JobSystem.h>
+#include <df3d/engine/resources/ResourceManager.h>
+#include <df3d/engine/resources/EntityResource.h>
 
 namespace df3d {
 
@@ -48,11 +53,45 @@ void World::collectRenderOperations(RenderQueue *ops)
         ops->lights[i] = lights[i];
     }
 
-    // TODO: can do in parallel.
+    PodArray<EntityComponentProcessor*> processors(MemoryManager::allocFrame());
+    processors.reserve(m_engineProcessors.size() + m_userProcessors.size());
     for (auto engineProcessor : m_engineProcessors)
-        engineProcessor->draw(ops);
+        processors.push_back(engineProcessor);
     for (auto &userProcessor : m_userProcessors)
-        userProcessor->draw(ops);
+        processors.push_back(userProcessor.get());
+
+    while (m_renderShards.size() < processors.size())
+        m_renderShards.push_back(make_unique<RenderQueue>());
+
+    auto &jobs = svc().jobs();
+    JobCounter counter(0);
+
+    // Kick off thread safe processors first, others are drawn on this thread meanwhile.
+    for (size_t i = 0; i < processors.size(); i++)
+    {
+        if (!processors[i]->supportsParallelDraw())
+            continue;
+
+        auto processor = processors[i];
+        auto shard = m_renderShards[i].get();
+
+        shard->clear();
+        jobs.run([processor, shard]() { processor->draw(shard); }, &counter);
+    }
+
+    for (size_t i = 0; i < processors.size(); i++)
+    {
+        if (processors[i]->supportsParallelDraw())
+            continue;
+
+        m_renderShards[i]->clear();
+        processors[i]->draw(m_renderShards[i].get());
+    }
+
+    jobs.wait(counter);
+
+    for (size_t i = 0; i < processors.size(); i++)
+        ops->append(*m_renderShards[i]);
 }
 
 void World::cleanStep()
@@ -88,6 +127,9 @@ void World::destroyWorld()
     m_userProcessors.clear();
     m_userProcessorsLookup.clear();
     m_engineProcessors.clear();
+    m_renderShards.clear();
+
+    m_prototypes.clear();
 
     m_tags.reset();
     m_staticMeshes.reset();
@@ -117,6 +159,65 @@ Entity World::spawn()
     return entity;
 }
 
+void World::spawn(size_t count, Entity *outEntities)
+{
+    for (size_t i = 0; i < count; i++)
+        outEntities[i] = Entity(m_entitiesMgr.getNew());
+
+    sceneGraph().add(outEntities, count);
+}
+
+std::vector<Entity> World::spawnBatch(const EntityPrototype &prototype, size_t count, const Transform *transforms)
+{
+    std::vector<Entity> roots;
+    roots.reserve(count);
+
+    m_entityLoader->spawnBatch(prototype, count, *this, roots);
+
+    if (transforms)
+    {
+        for (size_t i = 0; i < roots.size(); i++)
+            sceneGraph().setLocalTransform(roots[i], transforms[i].position, transforms[i].orientation, transforms[i].scaling);
+    }
+
+    return roots;
+}
+
+const EntityPrototype* World::getPrototype(const char *entityResource)
+{
+    Id resourceId(entityResource);
+
+    auto resource = svc().resourceManager().getResource<EntityResource>(resourceId);
+    if (!resource)
+    {
+        // Forget the prototype, the resource may come back changed.
+        m_prototypes.erase(resourceId);
+        DFLOG_WARN("Failed to get entity prototype. Resource '%s' is not loaded", entityResource);
+        return nullptr;
+    }
+
+    // The resource may have been unloaded and loaded again since the prototype was made.
+    auto found = m_prototypes.find(resourceId);
+    if (found != m_prototypes.end() && found->second.generation == resource->generation)
+        return found->second.prototype.get();
+
+    auto prototype = m_entityLoader->createPrototype(*resource, resourceId);
+    if (!prototype)
+    {
+        m_prototypes.erase(resourceId);
+        return nullptr;
+    }
+
+    auto result = prototype.get();
+    m_prototypes[resourceId] = { resource->generation, std::move(prototype) };
+    return result;
+}
+
+void World::clearPrototypes()
+{
+    m_prototypes.clear();
+}
+
 Entity World::spawnFromFile(const char *entityResource)
 {
     return m_entityLoader->createEntityFromFile(entityResource, *this);
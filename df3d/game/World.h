@@ -6,7 +6,7 @@
 
 namespace df3d {
 
-namespace game_impl { class EntityLoader; }
+namespace game_impl { class EntityLoader; class WorldLoader; }
 
 class StaticMeshComponentProcessor;
 class ParticleSystemComponentProcessor;
@@ -19,11 +19,14 @@ class EntityComponentProcessor;
 class Camera;
 class TimeManager;
 class EntityComponentLoader;
+class EntityPrototype;
+struct Transform;
 
 class World : NonCopyable
 {
     friend class EngineController;
     friend class RenderManager;
+    friend class game_impl::WorldLoader;
 
     HandleBag m_entitiesMgr;
     unique_ptr<game_impl::EntityLoader> m_entityLoader;
@@ -49,6 +52,17 @@ class World : NonCopyable
 
     PodArray<EntityComponentProcessor*> m_engineProcessors;
 
+    struct CachedPrototype
+    {
+        //! Generation of the entity resource the prototype was made of.
+        uint32_t generation;
+        unique_ptr<EntityPrototype> prototype;
+    };
+    std::unordered_map<Id, CachedPrototype> m_prototypes;
+
+    // Render operations of each processor, merged in processors order.
+    std::vector<unique_ptr<RenderQueue>> m_renderShards;
+
     void update();
     void collectRenderOperations(RenderQueue *ops);
     void cleanStep();
@@ -60,8 +74,16 @@ public:
     ~World();
 
     Entity spawn();
+    //! Spawns count empty entities at once.
+    void spawn(size_t count, Entity *outEntities);
     Entity spawnFromFile(const char *entityResource);
     Entity spawnFromJson(const Json::Value &entityResource);
+    //! Spawns count instances of a prototype, returns their roots. Root local transforms are
+    //! replaced by transforms[i] when given (position, orientation and scaling only).
+    std::vector<Entity> spawnBatch(const EntityPrototype &prototype, size_t count, const Transform *transforms = nullptr);
+    //! Cached prototype of a loaded entity resource, nullptr if it's not loaded.
+    const EntityPrototype* getPrototype(const char *entityResource);
+    void clearPrototypes();
     bool alive(Entity e);
     void destroy(Entity e);
     void destroyWithChildren(Entity e);
@@ -1,6 +1,7 @@
 #include "EntityLoader.h"
 
 #include <df3d/game/World.h>
+#include <df3d/game/EntityPrototype.h>
 #include <df3d/engine/3d/SceneGraphComponentProcessor.h>
 #include <df3d/engine/EngineController.h>
 #include <df3d/engine/resources/ResourceManager.h>
@@ -37,7 +38,14 @@ Entity EntityLoader::createEntityFromFile(const char *resourceFile, World &w)
     if (!resource)
         return {};
 
-    return createEntityFromJson(resource->root, w);
+    if (!resource->binary)
+        return createEntityFromJson(resource->root, w);
+
+    std::vector<Entity> roots;
+    createEntitiesFromBinary(*resource, w, roots);
+    DF3D_ASSERT(roots.size() == 1);
+
+    return roots.empty() ? Entity() : roots.front();
 }
 
 Entity EntityLoader::createEntityFromJson(const Json::Value &root, World &w)
@@ -62,12 +70,7 @@ Entity EntityLoader::createEntityFromJson(const Json::Value &root, World &w)
                 return{};
             }
 
-            auto componentType = it["type"].asCString();
-            auto foundLoader = m_loaders.find(Id(componentType));
-            if (foundLoader != m_loaders.end())
-                foundLoader->second->loadComponent(dataJson, res, w);
-            else
-                DFLOG_WARN("Failed to parse entity description, unknown component %s", componentType);
+            loadComponent(Id(it["type"].asCString()), dataJson, res, w);
         }
     }
 
@@ -80,6 +83,313 @@ Entity EntityLoader::createEntityFromJson(const Json::Value &root, World &w)
     return res;
 }
 
+void EntityLoader::loadComponent(Id type, const Json::Value &dataJson, Entity e, World &w)
+{
+    auto foundLoader = m_loaders.find(type);
+    if (foundLoader != m_loaders.end())
+        foundLoader->second->loadComponent(dataJson, e, w);
+    else
+        DFLOG_WARN("Failed to parse entity description, unknown component %s", type.toString().c_str());
+}
+
+void EntityLoader::createEntitiesFromBinary(const EntityResource &resource, World &w, std::vector<Entity> &outRoots)
+{
+    spawnCompiled(resource.binary, nullptr, 1, w, outRoots);
+}
+
+unique_ptr<EntityPrototype> EntityLoader::createPrototype(const EntityResource &resource, Id resourceId) const
+{
+    auto prototype = make_unique<EntityPrototype>(resourceId);
+
+    if (resource.binary)
+        prototype->m_binary.assign(resource.binary, resource.binary + resource.binarySize);
+    else if (!compileEntity(resource.root, false, prototype->m_binary))
+        return nullptr;
+
+    const auto &binary = prototype->m_binary;
+
+    DFEntityHeader header;
+    memcpy(&header, binary.data(), sizeof(header));
+
+    auto entities = reinterpret_cast<const DFEntityRecord *>(binary.data() + header.entitiesOffset);
+    auto components = reinterpret_cast<const DFEntityComponentRecord *>(binary.data() + header.componentsOffset);
+    auto data = binary.data() + header.dataOffset;
+
+    size_t rootsCount = 0;
+    for (uint32_t i = 0; i < header.entitiesCount; i++)
+    {
+        if (entities[i].parent == DFENTITY_NO_PARENT)
+            rootsCount++;
+    }
+
+    if (rootsCount != 1)
+    {
+        DFLOG_WARN("Failed to create a prototype of '%s', it should have a single root entity", resourceId.toString().c_str());
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < header.componentsCount; i++)
+    {
+        const auto &component = components[i];
+        if (component.flags & DFENTITY_COMPONENT_JSON)
+        {
+            auto componentData = (const char *)data + component.dataOffset;
+            prototype->m_jsonComponents[i] = JsonUtils::fromString(std::string(componentData, component.dataSize));
+        }
+    }
+
+    prototype->m_entitiesCount = header.entitiesCount;
+
+    return prototype;
+}
+
+void EntityLoader::spawnBatch(const EntityPrototype &prototype, size_t count, World &w, std::vector<Entity> &outRoots)
+{
+    spawnCompiled(prototype.m_binary.data(), &prototype.m_jsonComponents, count, w, outRoots);
+}
+
+void EntityLoader::spawnCompiled(const uint8_t *binary, const std::unordered_map<uint32_t, Json::Value> *jsonComponents,
+                                 size_t count, World &w, std::vector<Entity> &outRoots)
+{
+    DFEntityHeader header;
+    memcpy(&header, binary, sizeof(header));
+
+    // The resource is validated by EntityHolder.
+    auto entities = reinterpret_cast<const DFEntityRecord *>(binary + header.entitiesOffset);
+    auto components = reinterpret_cast<const DFEntityComponentRecord *>(binary + header.componentsOffset);
+    auto data = binary + header.dataOffset;
+
+    // Node major: all the instances of an entity record are spawned and filled together.
+    std::vector<Entity> spawned(header.entitiesCount * count);
+    for (uint32_t i = 0; i < header.entitiesCount; i++)
+    {
+        const auto &entity = entities[i];
+
+        auto instances = spawned.data() + i * count;
+        w.spawn(count, instances);
+
+        for (uint32_t j = entity.firstComponent; j < entity.firstComponent + entity.componentsCount; j++)
+        {
+            const auto &component = components[j];
+            Id type;
+            type.m_id = component.type;
+
+            auto componentData = data + component.dataOffset;
+
+            if (component.flags & DFENTITY_COMPONENT_JSON)
+            {
+                const Json::Value *dataJson = nullptr;
+                if (jsonComponents)
+                {
+                    auto found = jsonComponents->find(j);
+                    if (found != jsonComponents->end())
+                        dataJson = &found->second;
+                }
+
+                Json::Value parsed;
+                if (!dataJson)
+                {
+                    parsed = JsonUtils::fromString(std::string((const char *)componentData, component.dataSize));
+                    dataJson = &parsed;
+                }
+
+                for (size_t k = 0; k < count; k++)
+                    loadComponent(type, *dataJson, instances[k], w);
+                continue;
+            }
+
+            auto foundLoader = m_loaders.find(type);
+            if (foundLoader != m_loaders.end())
+                foundLoader->second->loadCompiledComponentBatch(componentData, component.dataSize, instances, count, w);
+            else
+                DFLOG_WARN("Failed to load compiled entity, unknown component %s", type.toString().c_str());
+        }
+
+        if (entity.parent == DFENTITY_NO_PARENT)
+        {
+            outRoots.insert(outRoots.end(), instances, instances + count);
+        }
+        else
+        {
+            auto parents = spawned.data() + entity.parent * count;
+            for (size_t k = 0; k < count; k++)
+                w.sceneGraph().attachChild(parents[k], instances[k]);
+        }
+    }
+}
+
+namespace {
+
+struct EntityCompilerOutput
+{
+    std::vector<DFEntityRecord> entities;
+    std::vector<DFEntityComponentRecord> components;
+    std::vector<uint8_t> data;
+    std::vector<std::string> strings;
+};
+
+void CollectStrings(const Json::Value &value, std::vector<std::string> &strings)
+{
+    if (value.isString())
+        strings.push_back(value.asString());
+    else if (value.isArray() || value.isObject())
+    {
+        for (const auto &child : value)
+            CollectStrings(child, strings);
+    }
+}
+
+template<typename T>
+void Append(std::vector<uint8_t> &output, const T *values, size_t count)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(values);
+    output.insert(output.end(), bytes, bytes + count * sizeof(T));
+}
+
+uint32_t AppendSection(std::vector<uint8_t> &output, const void *data, size_t size)
+{
+    output.resize((output.size() + DFENTITY_ALIGNMENT - 1) / DFENTITY_ALIGNMENT * DFENTITY_ALIGNMENT, 0);
+
+    auto offset = (uint32_t)output.size();
+    Append(output, (const uint8_t *)data, size);
+    return offset;
+}
+
+}
+
+bool EntityLoader::compileEntity(const Json::Value &root, bool isWorld, std::vector<uint8_t> &output) const
+{
+    EntityCompilerOutput result;
+
+    std::function<bool(const Json::Value &, uint32_t)> compileNode = [&](const Json::Value &node, uint32_t parent)
+    {
+        auto index = (uint32_t)result.entities.size();
+
+        DFEntityRecord entity;
+        entity.parent = parent;
+        entity.firstComponent = (uint32_t)result.components.size();
+        entity.componentsCount = 0;
+
+        for (const auto &it : node["components"])
+        {
+            const auto &dataJson = it["data"];
+            if (dataJson.isNull())
+            {
+                DFLOG_WARN("Failed to compile a component. Empty \"data\" field");
+                return false;
+            }
+
+            auto componentType = it["type"].asString();
+            result.strings.push_back(componentType);
+            CollectStrings(dataJson, result.strings);
+
+            // Keep the data aligned for the loaders.
+            result.data.resize((result.data.size() + DFENTITY_ALIGNMENT - 1) / DFENTITY_ALIGNMENT * DFENTITY_ALIGNMENT, 0);
+
+            DFEntityComponentRecord component;
+            component.type = Id(componentType.c_str()).m_id;
+            component.flags = 0;
+            component.dataOffset = (uint32_t)result.data.size();
+
+            auto foundLoader = m_loaders.find(Id(componentType.c_str()));
+            if (foundLoader == m_loaders.end() || !foundLoader->second->compileComponent(dataJson, result.data))
+            {
+                result.data.resize(component.dataOffset);
+
+                Json::StreamWriterBuilder builder;
+                builder["indentation"] = "";
+                auto str = Json::writeString(builder, dataJson);
+
+                Append(result.data, str.data(), str.size());
+                component.flags |= DFENTITY_COMPONENT_JSON;
+            }
+
+            component.dataSize = (uint32_t)result.data.size() - component.dataOffset;
+
+            result.components.push_back(component);
+            entity.componentsCount++;
+        }
+
+        result.entities.push_back(entity);
+
+        for (const auto &child : node["children"])
+        {
+            if (!compileNode(child, index))
+                return false;
+        }
+
+        return true;
+    };
+
+    Json::Value settings;
+    if (isWorld)
+    {
+        for (const auto &child : root["children"])
+        {
+            if (!compileNode(child, DFENTITY_NO_PARENT))
+                return false;
+        }
+
+        settings = root;
+        settings.removeMember("children");
+    }
+    else if (!compileNode(root, DFENTITY_NO_PARENT))
+        return false;
+
+    std::vector<std::string> dependencies;
+    GetEntityDependencies(root, dependencies);
+
+    // Strings table, dependencies point to it.
+    auto &strings = result.strings;
+    strings.insert(strings.end(), dependencies.begin(), dependencies.end());
+    std::sort(strings.begin(), strings.end());
+    strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+
+    std::vector<uint8_t> stringsData;
+    std::unordered_map<std::string, uint32_t> stringOffsets;
+    for (const auto &str : strings)
+    {
+        stringOffsets[str] = (uint32_t)stringsData.size();
+        Append(stringsData, str.c_str(), str.size() + 1);
+    }
+
+    std::vector<uint32_t> dependencyOffsets;
+    for (const auto &dep : dependencies)
+        dependencyOffsets.push_back(stringOffsets[dep]);
+
+    std::string settingsStr;
+    if (!settings.isNull())
+    {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        settingsStr = Json::writeString(builder, settings);
+    }
+
+    DFEntityHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header.magic, DFENTITY_MAGIC, sizeof(DFENTITY_MAGIC));
+    header.version = DFENTITY_VERSION;
+    header.entitiesCount = (uint32_t)result.entities.size();
+    header.componentsCount = (uint32_t)result.components.size();
+    header.dependenciesCount = (uint32_t)dependencyOffsets.size();
+    header.stringsSize = (uint32_t)stringsData.size();
+    header.settingsSize = (uint32_t)settingsStr.size();
+    header.dataSize = (uint32_t)result.data.size();
+
+    output.clear();
+    Append(output, &header, 1);
+    header.entitiesOffset = AppendSection(output, result.entities.data(), result.entities.size() * sizeof(DFEntityRecord));
+    header.componentsOffset = AppendSection(output, result.components.data(), result.components.size() * sizeof(DFEntityComponentRecord));
+    header.dependenciesOffset = AppendSection(output, dependencyOffsets.data(), dependencyOffsets.size() * sizeof(uint32_t));
+    header.stringsOffset = AppendSection(output, stringsData.data(), stringsData.size());
+    header.settingsOffset = AppendSection(output, settingsStr.data(), settingsStr.size());
+    header.dataOffset = AppendSection(output, result.data.data(), result.data.size());
+
+    memcpy(output.data(), &header, sizeof(header));
+
+    return true;
+}
+
 void EntityLoader::registerEntityComponentLoader(Id name, unique_ptr<EntityComponentLoader> loader)
 {
     DF3D_ASSERT(!utils::contains_key(m_loaders, name));
@@ -6,6 +6,8 @@ namespace df3d {
 
 class World;
 class EntityComponentLoader;
+struct EntityResource;
+class EntityPrototype;
 
 namespace game_impl {
 
@@ -13,12 +15,26 @@ class EntityLoader
 {
     std::unordered_map<Id, unique_ptr<EntityComponentLoader>> m_loaders;
 
+    void loadComponent(Id type, const Json::Value &dataJson, Entity e, World &w);
+    void spawnCompiled(const uint8_t *binary, const std::unordered_map<uint32_t, Json::Value> *jsonComponents,
+                       size_t count, World &w, std::vector<Entity> &outRoots);
+
 public:
     EntityLoader();
     ~EntityLoader();
 
     Entity createEntityFromFile(const char *resourceFile, World &w);
     Entity createEntityFromJson(const Json::Value &root, World &w);
+    //! Spawns all the entities of a compiled resource, outRoots gets the ones without a parent.
+    void createEntitiesFromBinary(const EntityResource &resource, World &w, std::vector<Entity> &outRoots);
+
+    //! Resolves an entity resource into a prototype, compiling it if it's json.
+    unique_ptr<EntityPrototype> createPrototype(const EntityResource &resource, Id resourceId) const;
+    //! Spawns count instances of a prototype, outRoots gets the root of each instance.
+    void spawnBatch(const EntityPrototype &prototype, size_t count, World &w, std::vector<Entity> &outRoots);
+
+    //! Compiles an .entity or .world json, components of unknown types are kept as json.
+    bool compileEntity(const Json::Value &root, bool isWorld, std::vector<uint8_t> &output) const;
 
     void registerEntityComponentLoader(Id name, unique_ptr<EntityComponentLoader> loader);
 };
@@ -19,6 +19,34 @@ public:
         Id resourceId(root["path"].asCString());
         w.staticMesh().add(e, resourceId);
     }
+
+    bool compileComponent(const Json::Value &root, std::vector<uint8_t> &output) const override
+    {
+        if (!root.isMember("path"))
+            return false;
+
+        writeCompiled(Id(root["path"].asCString()).m_id, output);
+        return true;
+    }
+
+    void loadCompiledComponent(const uint8_t *data, size_t size, Entity e, World &w) const override
+    {
+        uint32_t path;
+        if (!readCompiled(data, data + size, path))
+            return;
+
+        auto resourceId = compiledId(path);
+        w.staticMesh().add(e, resourceId);
+    }
+
+    void loadCompiledComponentBatch(const uint8_t *data, size_t size, const Entity *entities, size_t count, World &w) const override
+    {
+        uint32_t path;
+        if (!readCompiled(data, data + size, path))
+            return;
+
+        w.staticMesh().add(entities, count, compiledId(path));
+    }
 };
 
 }
@@ -8,6 +8,22 @@ namespace df3d {
 
 class PhysicsComponentLoader : public EntityComponentLoader
 {
+#pragma pack(push, 1)
+    struct CompiledData
+    {
+        uint32_t mesh;
+        uint32_t group;
+        uint32_t shape;
+        float mass;
+        float friction;
+        float restitution;
+        float linearDamping;
+        float angularDamping;
+        uint8_t disableDeactivation;
+        uint8_t noContactResponse;
+    };
+#pragma pack(pop)
+
 public:
     void loadComponent(const Json::Value &root, Entity e, World &w) const override
     {
@@ -21,6 +37,49 @@ public:
 
         w.physics().add(e, params, df3d::Id(root["mesh"].asCString()));
     }
+
+    bool compileComponent(const Json::Value &root, std::vector<uint8_t> &output) const override
+    {
+        if (!root.isMember("mesh") || !root.isMember("shape"))
+            return false;
+
+        auto params = PhysicsComponentCreationParams(root);
+
+        CompiledData data;
+        data.mesh = df3d::Id(root["mesh"].asCString()).m_id;
+        data.group = params.groupId.m_id;
+        data.shape = (uint32_t)params.shape;
+        data.mass = params.mass;
+        data.friction = params.friction;
+        data.restitution = params.restitution;
+        data.linearDamping = params.linearDamping;
+        data.angularDamping = params.angularDamping;
+        data.disableDeactivation = params.disableDeactivation;
+        data.noContactResponse = params.noContactResponse;
+
+        writeCompiled(data, output);
+        return true;
+    }
+
+    void loadCompiledComponent(const uint8_t *data, size_t size, Entity e, World &w) const override
+    {
+        CompiledData compiled;
+        if (!readCompiled(data, data + size, compiled))
+            return;
+
+        PhysicsComponentCreationParams params;
+        params.groupId = compiledId(compiled.group);
+        params.shape = (CollisionShapeType)compiled.shape;
+        params.mass = compiled.mass;
+        params.friction = compiled.friction;
+        params.restitution = compiled.restitution;
+        params.linearDamping = compiled.linearDamping;
+        params.angularDamping = compiled.angularDamping;
+        params.disableDeactivation = compiled.disableDeactivation != 0;
+        params.noContactResponse = compiled.noContactResponse != 0;
+
+        w.physics().add(e, params, compiledId(compiled.mesh));
+    }
 };
 
 }
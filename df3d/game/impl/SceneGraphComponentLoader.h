@@ -7,6 +7,27 @@ namespace df3d {
 
 class SceneGraphComponentLoader : public EntityComponentLoader
 {
+#pragma pack(push, 1)
+    struct CompiledData
+    {
+        float position[3];
+        float rotation[3];
+        float scale[3];
+        uint32_t name;
+    };
+#pragma pack(pop)
+
+    static glm::vec3 ToVec3(const float *v) { return { v[0], v[1], v[2] }; }
+
+    static void setup(Entity e, World &w, const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale, Id name)
+    {
+        // NOTE: assuming it's already added.
+        w.sceneGraph().setPosition(e, position);
+        w.sceneGraph().setOrientation(e, rotation);
+        w.sceneGraph().setScale(e, scale);
+        w.sceneGraph().setName(e, name);
+    }
+
 public:
     void loadComponent(const Json::Value &root, Entity e, World &w) const override
     {
@@ -18,11 +39,48 @@ public:
         if (root.isMember("name"))
             name = Id(root["name"].asCString());
 
-        // NOTE: assuming it's already added.
-        w.sceneGraph().setPosition(e, position);
-        w.sceneGraph().setOrientation(e, rotation);
-        w.sceneGraph().setScale(e, scale);
-        w.sceneGraph().setName(e, name);
+        setup(e, w, position, rotation, scale, name);
+    }
+
+    bool compileComponent(const Json::Value &root, std::vector<uint8_t> &output) const override
+    {
+        auto position = JsonUtils::get(root, "position", glm::vec3());
+        auto rotation = JsonUtils::get(root, "rotation", glm::vec3());
+        auto scale = JsonUtils::get(root, "scale", glm::vec3(1.0f, 1.0f, 1.0f));
+
+        CompiledData data;
+        memcpy(data.position, &position.x, sizeof(data.position));
+        memcpy(data.rotation, &rotation.x, sizeof(data.rotation));
+        memcpy(data.scale, &scale.x, sizeof(data.scale));
+        data.name = root.isMember("name") ? Id(root["name"].asCString()).m_id : Id().m_id;
+
+        writeCompiled(data, output);
+        return true;
+    }
+
+    void loadCompiledComponent(const uint8_t *data, size_t size, Entity e, World &w) const override
+    {
+        CompiledData compiled;
+        if (!readCompiled(data, data + size, compiled))
+            return;
+
+        setup(e, w, ToVec3(compiled.position), ToVec3(compiled.rotation), ToVec3(compiled.scale),
+              compiledId(compiled.name));
+    }
+
+    void loadCompiledComponentBatch(const uint8_t *data, size_t size, const Entity *entities, size_t count, World &w) const override
+    {
+        CompiledData compiled;
+        if (!readCompiled(data, data + size, compiled))
+            return;
+
+        auto &sceneGraph = w.sceneGraph();
+        auto orientation = glm::quat(glm::radians(ToVec3(compiled.rotation)));
+        sceneGraph.setLocalTransform(entities, count, ToVec3(compiled.position), orientation, ToVec3(compiled.scale));
+
+        auto name = compiledId(compiled.name);
+        for (size_t i = 0; i < count; i++)
+            sceneGraph.setName(entities[i], name);
     }
 };
 
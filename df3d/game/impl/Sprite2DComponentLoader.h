@@ -19,6 +19,25 @@ public:
         Id resourceId(root["path"].asCString());
         w.sprite2d().add(e, resourceId);
     }
+
+    bool compileComponent(const Json::Value &root, std::vector<uint8_t> &output) const override
+    {
+        if (!root.isMember("path"))
+            return false;
+
+        writeCompiled(Id(root["path"].asCString()).m_id, output);
+        return true;
+    }
+
+    void loadCompiledComponent(const uint8_t *data, size_t size, Entity e, World &w) const override
+    {
+        uint32_t path;
+        if (!readCompiled(data, data + size, path))
+            return;
+
+        auto resourceId = compiledId(path);
+        w.sprite2d().add(e, resourceId);
+    }
 };
 
 }
@@ -22,6 +22,41 @@ public:
             w.tags().add(e, tag);
         }
     }
+
+    bool compileComponent(const Json::Value &root, std::vector<uint8_t> &output) const override
+    {
+        if (!root.isMember("tags"))
+            return false;
+
+        writeCompiled(uint32_t(root["tags"].size()), output);
+        for (const auto &tagJson : root["tags"])
+            writeCompiled(df3d::Id(tagJson.asCString()).m_id, output);
+        return true;
+    }
+
+    void loadCompiledComponent(const uint8_t *data, size_t size, Entity e, World &w) const override
+    {
+        auto end = data + size;
+
+        uint32_t count, tag;
+        if (!readCompiled(data, end, count))
+            return;
+
+        for (uint32_t i = 0; i < count && readCompiled(data, end, tag); i++)
+            w.tags().add(e, compiledId(tag));
+    }
+
+    void loadCompiledComponentBatch(const uint8_t *data, size_t size, const Entity *entities, size_t count, World &w) const override
+    {
+        auto end = data + size;
+
+        uint32_t tagsCount, tag;
+        if (!readCompiled(data, end, tagsCount))
+            return;
+
+        for (uint32_t i = 0; i < tagsCount && readCompiled(data, end, tag); i++)
+            w.tags().add(entities, count, compiledId(tag));
+    }
 };
 
 }
@@ -7,6 +7,7 @@
 #include <df3d/lib/JsonUtils.h>
 #include <df3d/engine/resources/ResourceManager.h>
 #include <df3d/engine/resources/EntityResource.h>
+#include "EntityLoader.h"
 
 namespace df3d { namespace game_impl {
 
@@ -81,7 +82,13 @@ void WorldLoader::initWorld(const char *resourceFile, World &w)
 
     DF3D_ASSERT(resource->isWorld);
 
-    auto root = resource->root;
+    if (resource->binary)
+    {
+        std::vector<Entity> roots;
+        w.m_entityLoader->createEntitiesFromBinary(*resource, w, roots);
+    }
+
+    const auto &root = resource->root;
     if (root.isNull())
         return;
 
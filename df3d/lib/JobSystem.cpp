@@ -0,0 +1,438 @@
+#include "JobSystem.h"
+
+namespace df3d {
+
+enum { MAX_JOB_WORKERS = 15 };
+
+// Chase-Lev deque with a fixed capacity. The owner pushes and pops at the bottom,
+// other threads steal from the top.
+class WorkStealingQueue : NonCopyable
+{
+public:
+    enum { CAPACITY = 4096 };
+
+private:
+    std::atomic<int64_t> m_top;
+    std::atomic<int64_t> m_bottom;
+    std::atomic<void*> m_buffer[CAPACITY];
+
+public:
+    WorkStealingQueue()
+        : m_top(0),
+        m_bottom(0)
+    {
+        for (auto &item : m_buffer)
+            item.store(nullptr, std::memory_order_relaxed);
+    }
+
+    bool push(void *item)
+    {
+        auto b = m_bottom.load(std::memory_order_relaxed);
+        auto t = m_top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY)
+            return false;
+
+        m_buffer[b & (CAPACITY - 1)].store(item, std::memory_order_relaxed);
+        m_bottom.store(b + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    void* pop()
+    {
+        auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // Empty.
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        void *item = m_buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // The last one, race with the thieves.
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    void* steal()
+    {
+        auto t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = m_bottom.load(std::memory_order_acquire);
+
+        if (t >= b)
+            return nullptr;
+
+        void *item = m_buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return item;
+    }
+};
+
+namespace {
+
+thread_local const JobSystem *t_jobSystem = nullptr;
+thread_local WorkStealingQueue *t_queue = nullptr;
+
+}
+
+struct JobSystemWorker
+{
+    JobSystem &jobs;
+    WorkStealingQueue *queue;
+
+    JobSystemWorker(JobSystem &j, WorkStealingQueue *q)
+        : jobs(j), queue(q) { }
+
+    void operator()()
+    {
+        t_jobSystem = &jobs;
+        t_queue = queue;
+
+        while (!jobs.m_stop)
+        {
+            if (auto job = jobs.findJob(true))
+            {
+                jobs.execute(job);
+                continue;
+            }
+
+            // Jobs waiting for dependencies are not queued, so sleep until something is submitted.
+            std::unique_lock<std::mutex> lock(jobs.m_sleepLock);
+            jobs.m_sleepingWorkers++;
+            while (!jobs.m_stop && jobs.m_queuedJobs == 0)
+                jobs.m_wakeCondition.wait(lock);
+            jobs.m_sleepingWorkers--;
+        }
+
+        t_jobSystem = nullptr;
+        t_queue = nullptr;
+    }
+};
+
+WorkStealingQueue* JobSystem::getThreadQueue() const
+{
+    return t_jobSystem == this ? t_queue : nullptr;
+}
+
+void JobSystem::submit(Job *job)
+{
+    // Count before publishing, so the counter never goes below zero.
+    m_queuedJobs++;
+
+    auto queue = getThreadQueue();
+    if (!queue || !queue->push(job))
+        pushShared(job, false);
+
+    if (m_sleepingWorkers > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_wakeCondition.notify_one();
+    }
+}
+
+void JobSystem::pushShared(Job *job, bool background)
+{
+    std::lock_guard<std::mutex> lock(m_sharedLock);
+
+    if (background)
+    {
+        m_backgroundJobs.push_back(job);
+        m_backgroundJobsCount++;
+    }
+    else
+    {
+        m_sharedJobs.push_back(job);
+        m_sharedJobsCount++;
+    }
+}
+
+JobSystem::Job* JobSystem::popShared(bool background)
+{
+    auto &jobs = background ? m_backgroundJobs : m_sharedJobs;
+    auto &count = background ? m_backgroundJobsCount : m_sharedJobsCount;
+
+    if (count == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_sharedLock);
+
+    if (jobs.empty())
+        return nullptr;
+
+    auto job = jobs.front();
+    jobs.pop_front();
+    count--;
+
+    return job;
+}
+
+JobSystem::Job* JobSystem::findJob(bool background)
+{
+    auto ownQueue = getThreadQueue();
+
+    Job *job = nullptr;
+    if (ownQueue)
+        job = static_cast<Job*>(ownQueue->pop());
+
+    if (!job)
+        job = popShared(false);
+
+    if (!job)
+    {
+        // Start stealing from the next queue to spread the thieves.
+        size_t start = 0;
+        for (size_t i = 0; i < m_queues.size(); i++)
+        {
+            if (m_queues[i].get() == ownQueue)
+                start = i + 1;
+        }
+
+        for (size_t i = 0; i < m_queues.size() && !job; i++)
+        {
+            auto victim = m_queues[(start + i) % m_queues.size()].get();
+            if (victim != ownQueue)
+                job = static_cast<Job*>(victim->steal());
+        }
+    }
+
+    if (!job && background)
+        job = popShared(true);
+
+    if (!job)
+        return nullptr;
+
+    m_queuedJobs--;
+
+    return job;
+}
+
+bool JobSystem::block(Job *job)
+{
+    std::lock_guard<std::mutex> lock(m_blockedLock);
+
+    // Announce before checking the dependency, so the job which brings it to zero
+    // either sees this one blocked or this check sees zero.
+    m_blockedJobsCount++;
+
+    if (*job->dependency > 0)
+    {
+        m_blockedJobs.push_back(job);
+        return true;
+    }
+
+    m_blockedJobsCount--;
+
+    return false;
+}
+
+void JobSystem::unblockReady()
+{
+    std::lock_guard<std::mutex> lock(m_blockedLock);
+
+    // Blocked jobs keep their dependencies alive, so reading them is safe.
+    for (size_t i = 0; i < m_blockedJobs.size(); )
+    {
+        auto job = m_blockedJobs[i];
+        if (*job->dependency > 0)
+        {
+            i++;
+            continue;
+        }
+
+        m_blockedJobs[i] = m_blockedJobs.back();
+        m_blockedJobs.pop_back();
+        m_blockedJobsCount--;
+
+        submit(job);
+    }
+}
+
+void JobSystem::execute(Job *job)
+{
+    job->fn();
+
+    bool counterDone = false;
+    if (job->counter)
+    {
+        DF3D_ASSERT(*job->counter > 0);
+        counterDone = --(*job->counter) == 0;
+    }
+
+    delete job;
+
+    // The counter may be gone already, blocked jobs check their own dependencies.
+    if (counterDone && m_blockedJobsCount > 0)
+        unblockReady();
+}
+
+void JobSystem::startWorkers()
+{
+    m_stop = false;
+
+    for (size_t i = 0; i < m_numWorkers; i++)
+        m_workers.push_back(std::thread(JobSystemWorker(*this, m_queues[i + 1].get())));
+}
+
+void JobSystem::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_stop = true;
+    }
+
+    m_wakeCondition.notify_all();
+
+    for (auto &w : m_workers)
+        w.join();
+
+    m_workers.clear();
+}
+
+JobSystem::JobSystem(size_t numWorkers)
+    : m_numWorkers(numWorkers),
+    m_sharedJobsCount(0),
+    m_backgroundJobsCount(0),
+    m_blockedJobsCount(0),
+    m_queuedJobs(0),
+    m_sleepingWorkers(0),
+    m_stop(false)
+{
+    DF3D_ASSERT(numWorkers <= MAX_JOB_WORKERS);
+
+    // The first queue belongs to the creating thread.
+    for (size_t i = 0; i < m_numWorkers + 1; i++)
+        m_queues.push_back(make_unique<WorkStealingQueue>());
+
+    t_jobSystem = this;
+    t_queue = m_queues[0].get();
+
+    startWorkers();
+}
+
+JobSystem::~JobSystem()
+{
+    stopWorkers();
+
+    DF3D_ASSERT_MESS(m_queuedJobs == 0 && m_blockedJobsCount == 0, "job system is destroyed with pending jobs");
+
+    if (t_jobSystem == this)
+    {
+        t_jobSystem = nullptr;
+        t_queue = nullptr;
+    }
+}
+
+void JobSystem::run(const std::function<void ()> &fn, JobCounter *counter, JobCounter *dependency)
+{
+    if (counter)
+        ++(*counter);
+
+    auto job = new Job{ fn, counter, dependency };
+    if (dependency && block(job))
+        return;
+
+    submit(job);
+}
+
+void JobSystem::runBackground(const std::function<void ()> &fn, JobCounter *counter)
+{
+    if (counter)
+        ++(*counter);
+
+    auto job = new Job{ fn, counter, nullptr };
+
+    if (m_numWorkers == 0)
+    {
+        execute(job);
+        return;
+    }
+
+    m_queuedJobs++;
+    pushShared(job, true);
+
+    if (m_sleepingWorkers > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_wakeCondition.notify_one();
+    }
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+    while (counter > 0)
+    {
+        // Help instead of sleeping. This also makes nested waits from the jobs safe.
+        if (auto job = findJob(false))
+            execute(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void (size_t, size_t)> &fn)
+{
+    if (begin >= end)
+        return;
+
+    const size_t count = end - begin;
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    // A few chunks per thread, so stealing can balance uneven work.
+    size_t chunksCount = std::min((count + grainSize - 1) / grainSize, (m_numWorkers + 1) * 4);
+    if (chunksCount <= 1)
+    {
+        fn(begin, end);
+        return;
+    }
+
+    const size_t chunkSize = (count + chunksCount - 1) / chunksCount;
+
+    JobCounter counter(0);
+    for (size_t from = begin + chunkSize; from < end; from += chunkSize)
+    {
+        auto to = std::min(from + chunkSize, end);
+        run([&fn, from, to]() { fn(from, to); }, &counter);
+    }
+
+    // The calling thread takes the first chunk.
+    fn(begin, std::min(begin + chunkSize, end));
+
+    wait(counter);
+}
+
+void JobSystem::suspend()
+{
+    stopWorkers();
+}
+
+void JobSystem::resume()
+{
+    DF3D_ASSERT(m_workers.empty());
+
+    startWorkers();
+}
+
+size_t JobSystem::GetDefaultWorkersCount()
+{
+    // At least one worker, so background jobs don't run on the main thread.
+    size_t cores = std::thread::hardware_concurrency();
+    if (cores <= 1)
+        return 1;
+
+    return std::min<size_t>(cores - 1, MAX_JOB_WORKERS);
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <deque>
+#include <condition_variable>
+
+namespace df3d {
+
+//! Number of unfinished jobs. Should outlive all the jobs it tracks.
+using JobCounter = std::atomic<uint32_t>;
+
+class WorkStealingQueue;
+
+//! Work stealing pool of worker threads. Each worker and the thread which has created
+//! the job system own a job queue, idle threads steal jobs from the others.
+class JobSystem : NonCopyable
+{
+    friend struct JobSystemWorker;
+
+    struct Job
+    {
+        std::function<void ()> fn;
+        JobCounter *counter;
+        JobCounter *dependency;
+    };
+
+    std::vector<unique_ptr<WorkStealingQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+    size_t m_numWorkers;
+
+    // Jobs from the threads which don't have own queue.
+    std::mutex m_sharedLock;
+    std::deque<Job*> m_sharedJobs;
+    std::deque<Job*> m_backgroundJobs;
+    std::atomic<size_t> m_sharedJobsCount;
+    std::atomic<size_t> m_backgroundJobsCount;
+
+    // Jobs waiting for their dependency counter, queued when it reaches zero.
+    std::mutex m_blockedLock;
+    std::vector<Job*> m_blockedJobs;
+    std::atomic<size_t> m_blockedJobsCount;
+
+    std::mutex m_sleepLock;
+    std::condition_variable m_wakeCondition;
+    std::atomic<size_t> m_queuedJobs;
+    std::atomic<size_t> m_sleepingWorkers;
+    std::atomic<bool> m_stop;
+
+    WorkStealingQueue* getThreadQueue() const;
+    void submit(Job *job);
+    void pushShared(Job *job, bool background);
+    Job* popShared(bool background);
+    Job* findJob(bool background);
+    bool block(Job *job);
+    void unblockReady();
+    void execute(Job *job);
+
+    void startWorkers();
+    void stopWorkers();
+
+public:
+    //! 0 workers means that all the jobs are executed by the waiting thread.
+    JobSystem(size_t numWorkers);
+    ~JobSystem();
+
+    //! Queues a job. The counter (if any) is incremented now and decremented when the job is done.
+    //! The job doesn't start until the dependency counter (if any) reaches zero. It's queued by the
+    //! job which brings the counter to zero, so the dependency should only be changed by the jobs.
+    void run(const std::function<void ()> &fn, JobCounter *counter = nullptr, JobCounter *dependency = nullptr);
+    //! Queues a long running job (e.g. resource decoding). Such jobs are picked only by the workers
+    //! when they have nothing else to do, so they never stall a waiting thread.
+    void runBackground(const std::function<void ()> &fn, JobCounter *counter = nullptr);
+    //! Blocks until the counter reaches zero, executing queued jobs meanwhile.
+    void wait(JobCounter &counter);
+    //! Splits [begin, end) into chunks of at least grainSize and runs fn(from, to) for each one. Blocking.
+    void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void (size_t, size_t)> &fn);
+
+    //! Stops the worker threads, queued jobs are kept until resume.
+    void suspend();
+    void resume();
+
+    size_t getWorkersCount() const { return m_numWorkers; }
+
+    //! Worker threads count for this machine, leaves one core for the main thread.
+    static size_t GetDefaultWorkersCount();
+};
+
+}
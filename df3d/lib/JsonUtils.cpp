@@ -9,6 +9,20 @@ namespace df3d {
 
 namespace JsonUtils {
 
+static Json::Value Parse(const char *begin, const char *end)
+{
+    Json::Value root;
+    Json::Reader reader;
+
+    if (!reader.parse(begin, end, root))
+    {
+        DFLOG_WARN("Failed to parse json. Error: %s", reader.getFormattedErrorMessages().c_str());
+        return{};
+    }
+
+    return root;
+}
+
 Json::Value fromFile(const char *path)
 {
     if (auto fileSource = svc().resourceManager().getFS().open(path))
@@ -30,6 +44,11 @@ Json::Value fromFile(const char *path)
 
 Json::Value fromFile(ResourceDataSource &dataSource)
 {
+    // Parse in place when the data is in memory already.
+    if (auto view = reinterpret_cast<const char *>(dataSource.getContiguousView()))
+        return Parse(view, view + dataSource.getSize());
+
+    // Not the frame allocator, resources are decoded by jobs which may outlive a frame.
     std::string buffer;
     buffer.resize(dataSource.getSize());
     dataSource.read(&buffer[0], buffer.size());
@@ -38,16 +57,7 @@ Json::Value fromFile(ResourceDataSource &dataSource)
 
 Json::Value fromString(const std::string &data)
 {
-    Json::Value root;
-    Json::Reader reader;
-
-    if (!reader.parse(data, root))
-    {
-        DFLOG_WARN("Failed to parse json. Error: %s", reader.getFormattedErrorMessages().c_str());
-        return{};
-    }
-
-    return root;
+    return Parse(data.data(), data.data() + data.size());
 }
 
 }
@@ -137,6 +137,15 @@ inline T clamp(const T &val, const T &min, const T &max)
     return std::min(std::max(val, min), max);
 }
 
+//! Reserves for count more elements, keeping the geometric growth so repeated small batches don't reallocate each time.
+template<typename C>
+inline void reserve_more(C &container, size_t count)
+{
+    size_t required = container.size() + count;
+    if (required > container.capacity())
+        container.reserve(std::max(required, container.capacity() * 2));
+}
+
 inline void trim_left(std::string &str)
 {
     str.erase(str.begin(), std::find_if(str.begin(), str.end(), [](char ch) { return !std::isspace(ch); }));
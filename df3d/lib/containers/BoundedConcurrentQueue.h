@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <df3d/lib/NonCopyable.h>
+#include <df3d/lib/assert/Assert.h>
+
+namespace df3d {
+
+//! Lock-free multi producer multi consumer queue with a fixed capacity.
+//! Ring buffer with a sequence number per cell, see Dmitry Vyukov's bounded MPMC queue.
+template<typename T>
+class BoundedConcurrentQueue : public NonCopyable
+{
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* item() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    enum { CACHE_LINE_SIZE = 64 };
+
+    // Producers and consumers positions are kept on different cache lines.
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    char m_pad0[CACHE_LINE_SIZE];
+    std::atomic<size_t> m_enqueuePos;
+    char m_pad1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_dequeuePos;
+    char m_pad2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+    template<typename U>
+    bool emplace(U &&item)
+    {
+        auto pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            auto seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;   // Full. The item is left untouched.
+            else
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+
+        new (cell->item()) T(std::forward<U>(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+public:
+    //! Capacity is rounded up to a power of two.
+    BoundedConcurrentQueue(size_t capacity = 1024)
+    {
+        DF3D_ASSERT(capacity >= 2);
+
+        size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+
+        m_mask = size - 1;
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    ~BoundedConcurrentQueue()
+    {
+        clear();
+    }
+
+    //! Returns false if the queue is full.
+    bool push(const T &item) { return emplace(item); }
+    bool push(T &&item) { return emplace(std::move(item)); }
+
+    bool tryPop(T &dest)
+    {
+        auto pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        while (true)
+        {
+            cell = &m_cells[pos & m_mask];
+            auto seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;   // Empty.
+            else
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+        }
+
+        dest = std::move(*cell->item());
+        cell->item()->~T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //! Approximate while there are concurrent producers or consumers.
+    bool empty() const
+    {
+        return m_enqueuePos.load(std::memory_order_acquire) == m_dequeuePos.load(std::memory_order_acquire);
+    }
+
+    void clear()
+    {
+        T tmp;
+        while (tryPop(tmp))
+            ;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+};
+
+}
@@ -34,7 +34,7 @@ public:
         if (m_queue.empty())
             return false;
 
-        dest = m_queue.front();
+        dest = std::move(m_queue.front());
         m_queue.pop();
 
         return true;
@@ -44,7 +44,7 @@ public:
     {
         std::lock_guard<decltype(m_lock)> lock(m_lock);
 
-        T result = m_queue.front();
+        T result = std::move(m_queue.front());
         m_queue.pop();
 
         return result;
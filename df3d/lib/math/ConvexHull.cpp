@@ -1,30 +1,17 @@
 #include "ConvexHull.h"
 
-#include <df3d/engine/resources/MeshResource.h>
 #include <BulletCollision/CollisionShapes/btConvexHullShape.h>
 #include <BulletCollision/CollisionShapes/btShapeHull.h>
 
 namespace df3d {
 
-void ConvexHull::constructFromGeometry(const MeshResourceData &resource, Allocator &alloc)
+void ConvexHull::constructFromPoints(const glm::vec3 *points, size_t count, Allocator &alloc)
 {
-    auto tempHull = MAKE_NEW(alloc, btConvexHullShape)();
+    m_vertices.clear();
+    if (count == 0)
+        return;
 
-    // Compute the volume.
-    for (auto submesh : resource.parts)
-    {
-        const auto &vertexData = submesh->vertexData;
-
-        for (size_t i = 0; i < vertexData.getVerticesCount(); i++)
-        {
-            auto &vdata = const_cast<VertexData&>(vertexData);
-            auto v = (glm::vec3*)vdata.getVertexAttribute(i, VertexFormat::POSITION);
-
-            tempHull->addPoint({ v->x, v->y, v->z }, false);
-        }
-
-        tempHull->recalcLocalAabb();
-    }
+    auto tempHull = MAKE_NEW(alloc, btConvexHullShape)((const btScalar*)points, (int)count, sizeof(glm::vec3));
 
     auto convexHull = MAKE_NEW(alloc, btShapeHull)(tempHull);
     convexHull->buildHull(tempHull->getMargin());
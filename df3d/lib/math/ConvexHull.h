@@ -4,13 +4,11 @@
 
 namespace df3d {
 
-struct MeshResourceData;
-
 struct ConvexHull
 {
     std::vector<btVector3> m_vertices;
 
-    void constructFromGeometry(const MeshResourceData &resource, Allocator &alloc);
+    void constructFromPoints(const glm::vec3 *points, size_t count, Allocator &alloc);
 };
 
 }
@@ -4,6 +4,19 @@
 #include <df3d/lib/math/MathUtils.h>
 #include <glm/gtc/matrix_access.hpp>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#define DF3D_FRUSTUM_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DF3D_FRUSTUM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DF3D_FRUSTUM_NEON
+#endif
+
 namespace df3d {
 
 Frustum::Frustum()
@@ -47,4 +60,95 @@ bool Frustum::sphereInFrustum(const BoundingSphere &sphere) const
     return true;
 }
 
+void Frustum::cullSpheres(const float *x, const float *y, const float *z, const float *r, size_t count, uint32_t *visibility) const
+{
+    memset(visibility, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+    size_t i = 0;
+
+    // Batches always start at multiple of their width, so a batch mask never crosses a word.
+#ifdef DF3D_FRUSTUM_AVX
+    for (; i + 8 <= count; i += 8)
+    {
+        auto px = _mm256_loadu_ps(x + i);
+        auto py = _mm256_loadu_ps(y + i);
+        auto pz = _mm256_loadu_ps(z + i);
+        auto negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+
+        auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto &plane : m_planes)
+        {
+            auto dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), px),
+                                                    _mm256_mul_ps(_mm256_set1_ps(plane.y), py)),
+                                      _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), pz),
+                                                    _mm256_set1_ps(plane.w)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+        }
+
+        visibility[i / 32] |= (uint32_t)_mm256_movemask_ps(inside) << (i % 32);
+    }
+#endif
+
+#if defined(DF3D_FRUSTUM_SSE)
+    for (; i + 4 <= count; i += 4)
+    {
+        auto px = _mm_loadu_ps(x + i);
+        auto py = _mm_loadu_ps(y + i);
+        auto pz = _mm_loadu_ps(z + i);
+        auto negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+
+        auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto &plane : m_planes)
+        {
+            auto dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), px),
+                                              _mm_mul_ps(_mm_set1_ps(plane.y), py)),
+                                   _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), pz),
+                                              _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+        }
+
+        visibility[i / 32] |= (uint32_t)_mm_movemask_ps(inside) << (i % 32);
+    }
+#elif defined(DF3D_FRUSTUM_NEON)
+    static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+    const auto laneMask = vld1q_u32(laneBits);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        auto px = vld1q_f32(x + i);
+        auto py = vld1q_f32(y + i);
+        auto pz = vld1q_f32(z + i);
+        auto negRadius = vnegq_f32(vld1q_f32(r + i));
+
+        auto inside = vdupq_n_u32(0xFFFFFFFF);
+        for (const auto &plane : m_planes)
+        {
+            auto dist = vaddq_f32(vaddq_f32(vmulq_n_f32(px, plane.x), vmulq_n_f32(py, plane.y)),
+                                  vaddq_f32(vmulq_n_f32(pz, plane.z), vdupq_n_f32(plane.w)));
+            inside = vandq_u32(inside, vcgeq_f32(dist, negRadius));
+        }
+
+        auto bits = vandq_u32(inside, laneMask);
+        auto sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+        visibility[i / 32] |= vget_lane_u32(vpadd_u32(sum, sum), 0) << (i % 32);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        bool inside = true;
+        for (const auto &plane : m_planes)
+        {
+            if (plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w < -r[i])
+            {
+                inside = false;
+                break;
+            }
+        }
+
+        if (inside)
+            visibility[i / 32] |= 1u << (i % 32);
+    }
+}
+
 }
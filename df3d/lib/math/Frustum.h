@@ -24,6 +24,9 @@ public:
     ~Frustum();
 
     bool sphereInFrustum(const BoundingSphere &sphere) const;
+    //! Batch version of sphereInFrustum over spheres in SoA layout. Sets bit (i % 32) of
+    //! visibility[i / 32] if i-th sphere is visible, (count + 31) / 32 words are written.
+    void cullSpheres(const float *x, const float *y, const float *z, const float *r, size_t count, uint32_t *visibility) const;
 };
 
 }
@@ -0,0 +1,359 @@
+#include "CachingAllocator.h"
+
+namespace df3d {
+
+namespace {
+
+const size_t SIZE_CLASSES[CachingAllocator::SIZE_CLASSES_COUNT] = { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+const size_t MAX_SMALL_SIZE = SIZE_CLASSES[CachingAllocator::SIZE_CLASSES_COUNT - 1];
+const size_t SLAB_SIZE = 64 * 1024;
+// Bytes of each size class a thread keeps before giving blocks back to the depot.
+const size_t THREAD_CACHE_BYTES = 32 * 1024;
+const uint16_t LARGE_CLASS = 0xFFFF;
+
+const size_t HEADER_SIZE = 16;
+
+// Precedes every block, keeps the small blocks payload 16 bytes aligned.
+struct BlockHeader
+{
+    uint16_t sizeClass;
+    uint16_t tag;
+    // Distance to the backing allocation for the large blocks.
+    uint32_t offset;
+    size_t size;
+};
+
+static_assert(sizeof(BlockHeader) <= HEADER_SIZE, "block header doesn't fit");
+
+BlockHeader* GetHeader(void *mem)
+{
+    return reinterpret_cast<BlockHeader *>((uint8_t *)mem - HEADER_SIZE);
+}
+
+void*& NextFree(void *mem)
+{
+    return *reinterpret_cast<void **>(mem);
+}
+
+size_t GetSizeClass(size_t size)
+{
+    size_t result = 0;
+    while (SIZE_CLASSES[result] < size)
+        result++;
+    return result;
+}
+
+size_t GetCacheLimit(size_t sizeClass)
+{
+    return std::max<size_t>(8, THREAD_CACHE_BYTES / SIZE_CLASSES[sizeClass]);
+}
+
+std::atomic<uint64_t> g_lastAllocatorId(0);
+
+struct ThreadCacheSlot
+{
+    uint64_t allocatorId = 0;
+    void *cache = nullptr;
+};
+
+// Cache of the last allocator used by this thread.
+thread_local ThreadCacheSlot t_cacheSlot;
+
+}
+
+struct CachingAllocator::ThreadCache
+{
+    struct Bin
+    {
+        void *head = nullptr;
+        size_t count = 0;
+    };
+
+    Bin bins[SIZE_CLASSES_COUNT];
+
+    // Written by the owning thread only. Memory freed by another thread goes negative here.
+    std::atomic<int64_t> bytes[MEMORY_TAG_COUNT];
+    std::atomic<int64_t> allocations[MEMORY_TAG_COUNT];
+
+    ThreadCache()
+    {
+        for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        {
+            bytes[i] = 0;
+            allocations[i] = 0;
+        }
+    }
+
+    void account(uint16_t tag, int64_t size, int64_t allocationsCount)
+    {
+        bytes[tag].store(bytes[tag].load(std::memory_order_relaxed) + size, std::memory_order_relaxed);
+        allocations[tag].store(allocations[tag].load(std::memory_order_relaxed) + allocationsCount, std::memory_order_relaxed);
+    }
+};
+
+struct CachingAllocator::Depot
+{
+    std::mutex lock;
+    void *head = nullptr;
+    size_t count = 0;
+};
+
+class CachingAllocator::TagView : public Allocator
+{
+    CachingAllocator &m_owner;
+    MemoryTag m_tag;
+
+public:
+    TagView(CachingAllocator &owner, MemoryTag tag) : m_owner(owner), m_tag(tag) { }
+
+    void* alloc(size_t size, size_t alignment) override { return m_owner.allocTagged(size, alignment, m_tag); }
+    void dealloc(void *mem) override { m_owner.dealloc(mem); }
+    size_t bytesAllocated() override { return (size_t)std::max<int64_t>(0, m_owner.getStats().bytes[m_tag]); }
+};
+
+const char* MemoryTagName(MemoryTag tag)
+{
+    switch (tag)
+    {
+    case MEMORY_TAG_GENERAL:
+        return "general";
+    case MEMORY_TAG_RENDER:
+        return "render";
+    case MEMORY_TAG_RESOURCES:
+        return "resources";
+    case MEMORY_TAG_PHYSICS:
+        return "physics";
+    case MEMORY_TAG_PARTICLES:
+        return "particles";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+CachingAllocator::CachingAllocator(Allocator &alloc)
+    : m_alloc(alloc),
+    m_id(++g_lastAllocatorId)
+{
+    for (auto &depot : m_depots)
+        depot = make_unique<Depot>();
+
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        m_tagViews[i] = make_unique<TagView>(*this, (MemoryTag)i);
+}
+
+CachingAllocator::~CachingAllocator()
+{
+#ifdef _DEBUG
+    auto stats = getStats();
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        DF3D_ASSERT_MESS(stats.bytes[i] == 0, "memory leak");
+#endif
+
+    // Small blocks are still in the caches and depots, these are not touched anymore.
+    for (auto slab : m_slabs)
+        m_alloc.dealloc(slab);
+}
+
+CachingAllocator::ThreadCache& CachingAllocator::getThreadCache()
+{
+    if (t_cacheSlot.allocatorId == m_id)
+        return *static_cast<ThreadCache *>(t_cacheSlot.cache);
+
+    std::lock_guard<std::mutex> lock(m_cachesLock);
+
+    // A cache of an exited thread is taken over by a new one with the same id.
+    auto &cache = m_threadCaches[std::this_thread::get_id()];
+    if (!cache)
+        cache = make_unique<ThreadCache>();
+
+    t_cacheSlot.allocatorId = m_id;
+    t_cacheSlot.cache = cache.get();
+
+    return *cache;
+}
+
+void CachingAllocator::refill(ThreadCache &cache, size_t sizeClass)
+{
+    auto &bin = cache.bins[sizeClass];
+    auto &depot = *m_depots[sizeClass];
+    auto batchSize = GetCacheLimit(sizeClass) / 2;
+
+    {
+        std::lock_guard<std::mutex> lock(depot.lock);
+
+        while (bin.count < batchSize && depot.head)
+        {
+            auto block = depot.head;
+            depot.head = NextFree(block);
+            depot.count--;
+
+            NextFree(block) = bin.head;
+            bin.head = block;
+            bin.count++;
+        }
+    }
+
+    if (bin.head)
+        return;
+
+    // Carve a new slab, all of it goes to this thread.
+    auto slab = (uint8_t *)m_alloc.alloc(SLAB_SIZE, HEADER_SIZE);
+    {
+        std::lock_guard<std::mutex> lock(m_slabsLock);
+        m_slabs.push_back(slab);
+    }
+
+    const auto stride = HEADER_SIZE + SIZE_CLASSES[sizeClass];
+    for (size_t offset = 0; offset + stride <= SLAB_SIZE; offset += stride)
+    {
+        auto block = slab + offset + HEADER_SIZE;
+
+        auto header = GetHeader(block);
+        header->sizeClass = (uint16_t)sizeClass;
+        header->offset = 0;
+
+        NextFree(block) = bin.head;
+        bin.head = block;
+        bin.count++;
+    }
+}
+
+void CachingAllocator::flush(ThreadCache &cache, size_t sizeClass, size_t count)
+{
+    auto &bin = cache.bins[sizeClass];
+    DF3D_ASSERT(count <= bin.count);
+
+    auto first = bin.head;
+    auto last = first;
+    for (size_t i = 1; i < count; i++)
+        last = NextFree(last);
+
+    bin.head = NextFree(last);
+    bin.count -= count;
+
+    auto &depot = *m_depots[sizeClass];
+
+    std::lock_guard<std::mutex> lock(depot.lock);
+    NextFree(last) = depot.head;
+    depot.head = first;
+    depot.count += count;
+}
+
+void* CachingAllocator::alloc(size_t size, size_t alignment)
+{
+    return allocTagged(size, alignment, MEMORY_TAG_GENERAL);
+}
+
+void* CachingAllocator::allocTagged(size_t size, size_t alignment, MemoryTag tag)
+{
+    DF3D_ASSERT(alignment != 0);
+    DF3D_ASSERT((alignment & (alignment - 1)) == 0);
+    DF3D_ASSERT(tag < MEMORY_TAG_COUNT);
+
+    auto &cache = getThreadCache();
+    cache.account(tag, size, 1);
+
+    if (size <= MAX_SMALL_SIZE && alignment <= HEADER_SIZE)
+    {
+        auto sizeClass = GetSizeClass(size);
+        auto &bin = cache.bins[sizeClass];
+        if (!bin.head)
+            refill(cache, sizeClass);
+
+        auto block = bin.head;
+        bin.head = NextFree(block);
+        bin.count--;
+
+        auto header = GetHeader(block);
+        header->tag = (uint16_t)tag;
+        header->size = size;
+
+        return block;
+    }
+
+    const auto padding = std::max(alignment, HEADER_SIZE);
+
+    auto base = (uint8_t *)m_alloc.alloc(size + padding, padding);
+    auto block = base + padding;
+
+    auto header = GetHeader(block);
+    header->sizeClass = LARGE_CLASS;
+    header->tag = (uint16_t)tag;
+    header->offset = (uint32_t)padding;
+    header->size = size;
+
+    return block;
+}
+
+void CachingAllocator::dealloc(void *mem)
+{
+    if (!mem)
+        return;
+
+    auto header = GetHeader(mem);
+    DF3D_ASSERT(header->sizeClass < SIZE_CLASSES_COUNT || header->sizeClass == LARGE_CLASS);
+
+    auto &cache = getThreadCache();
+    cache.account(header->tag, -(int64_t)header->size, -1);
+
+    if (header->sizeClass == LARGE_CLASS)
+    {
+        m_alloc.dealloc((uint8_t *)mem - header->offset);
+        return;
+    }
+
+    auto sizeClass = header->sizeClass;
+    auto &bin = cache.bins[sizeClass];
+
+    NextFree(mem) = bin.head;
+    bin.head = mem;
+    bin.count++;
+
+    auto limit = GetCacheLimit(sizeClass);
+    if (bin.count > limit)
+        flush(cache, sizeClass, limit / 2);
+}
+
+size_t CachingAllocator::bytesAllocated()
+{
+    auto stats = getStats();
+
+    int64_t result = 0;
+    for (auto bytes : stats.bytes)
+        result += bytes;
+    return (size_t)std::max<int64_t>(0, result);
+}
+
+Allocator& CachingAllocator::getTagged(MemoryTag tag)
+{
+    DF3D_ASSERT(tag < MEMORY_TAG_COUNT);
+    return *m_tagViews[tag];
+}
+
+MemoryStats CachingAllocator::getStats()
+{
+    MemoryStats result;
+
+    {
+        std::lock_guard<std::mutex> lock(m_cachesLock);
+        for (const auto &kv : m_threadCaches)
+        {
+            for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+            {
+                result.bytes[i] += kv.second->bytes[i].load(std::memory_order_relaxed);
+                result.allocations[i] += kv.second->allocations[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_slabsLock);
+        result.slabBytes = m_slabs.size() * SLAB_SIZE;
+    }
+
+    return result;
+}
+
+}
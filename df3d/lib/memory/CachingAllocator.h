@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Allocator.h"
+
+namespace df3d {
+
+//! Subsystems the memory is accounted to.
+enum MemoryTag
+{
+    MEMORY_TAG_GENERAL,
+    MEMORY_TAG_RENDER,
+    MEMORY_TAG_RESOURCES,
+    MEMORY_TAG_PHYSICS,
+    MEMORY_TAG_PARTICLES,
+
+    MEMORY_TAG_COUNT
+};
+
+const char* MemoryTagName(MemoryTag tag);
+
+struct MemoryStats
+{
+    // Live bytes and allocations per tag, as requested by the users.
+    int64_t bytes[MEMORY_TAG_COUNT] = {};
+    int64_t allocations[MEMORY_TAG_COUNT] = {};
+    //! Memory taken from the backing allocator for the small size classes.
+    size_t slabBytes = 0;
+};
+
+//! Front end for another allocator with thread local caches of small blocks. Small sizes
+//! are served from per thread free lists filled from slabs, blocks go between threads
+//! through per size class depots in batches, so the backing allocator is rarely touched.
+//! Slabs are kept until the allocator is destroyed, big blocks go to the backing allocator.
+//! Statistics are per thread counters summed on demand.
+class CachingAllocator : public Allocator
+{
+public:
+    static const size_t SIZE_CLASSES_COUNT = 8;
+
+private:
+    struct ThreadCache;
+    struct Depot;
+
+    Allocator &m_alloc;
+    const uint64_t m_id;
+
+    unique_ptr<Depot> m_depots[SIZE_CLASSES_COUNT];
+
+    std::mutex m_cachesLock;
+    std::unordered_map<std::thread::id, unique_ptr<ThreadCache>> m_threadCaches;
+
+    std::mutex m_slabsLock;
+    std::vector<void*> m_slabs;
+
+    class TagView;
+    unique_ptr<TagView> m_tagViews[MEMORY_TAG_COUNT];
+
+    ThreadCache& getThreadCache();
+    void refill(ThreadCache &cache, size_t sizeClass);
+    void flush(ThreadCache &cache, size_t sizeClass, size_t count);
+
+public:
+    CachingAllocator(Allocator &alloc);
+    ~CachingAllocator();
+
+    void* alloc(size_t size, size_t alignment) override;
+    void dealloc(void *mem) override;
+    //! Live bytes of all the tags.
+    size_t bytesAllocated() override;
+
+    void* allocTagged(size_t size, size_t alignment, MemoryTag tag);
+    //! Allocator accounting everything to the given tag. Memory can be freed by any view.
+    Allocator& getTagged(MemoryTag tag);
+
+    MemoryStats getStats();
+};
+
+}
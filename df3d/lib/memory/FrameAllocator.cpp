@@ -0,0 +1,115 @@
+#include "FrameAllocator.h"
+
+#include <df3d/lib/Utils.h>
+
+namespace df3d {
+
+static const size_t ARENA_ALIGNMENT = 16;
+
+FrameAllocator::FrameAllocator(Allocator &alloc, size_t capacity)
+    : m_alloc(alloc)
+{
+    for (auto &arena : m_arenas)
+    {
+        arena.memory = (uint8_t*)m_alloc.alloc(capacity, ARENA_ALIGNMENT);
+        arena.capacity = capacity;
+    }
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    for (auto &arena : m_arenas)
+    {
+        for (auto mem : arena.overflow)
+            m_alloc.dealloc(mem);
+        m_alloc.dealloc(arena.memory);
+    }
+}
+
+size_t FrameAllocator::getUsedBytes(const Arena &arena) const
+{
+    return arena.offset.load() + arena.overflowBytes;
+}
+
+void FrameAllocator::reset(Arena &arena)
+{
+    auto usedBytes = getUsedBytes(arena);
+
+    for (auto mem : arena.overflow)
+        m_alloc.dealloc(mem);
+    arena.overflow.clear();
+    arena.overflowBytes = 0;
+
+    // Grow to fit the whole frame next time.
+    if (usedBytes > arena.capacity)
+    {
+        auto capacity = std::max(arena.capacity * 2, usedBytes);
+
+        m_alloc.dealloc(arena.memory);
+        arena.memory = (uint8_t*)m_alloc.alloc(capacity, ARENA_ALIGNMENT);
+        arena.capacity = capacity;
+
+        DFLOG_DEBUG("Frame allocator grown to %d KB", utils::sizeKB(capacity));
+    }
+
+#ifdef _DEBUG
+    // Makes use of stale frame data noticeable.
+    memset(arena.memory, 0xCD, arena.offset.load());
+#endif
+
+    arena.offset = 0;
+}
+
+void* FrameAllocator::alloc(size_t size, size_t alignment)
+{
+    DF3D_ASSERT(alignment != 0 && alignment <= ARENA_ALIGNMENT);
+    DF3D_ASSERT((alignment & (alignment - 1)) == 0);
+
+    auto &arena = m_arenas[m_current];
+
+    // Bump the offset only when the allocation fits, so an overflowing request doesn't eat
+    // the rest of the arena. Arena memory is aligned to ARENA_ALIGNMENT.
+    auto offset = arena.offset.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        auto aligned = (offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + size > arena.capacity)
+            break;
+
+        if (arena.offset.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed))
+            return arena.memory + aligned;
+    }
+
+    auto mem = m_alloc.alloc(size, alignment);
+
+    std::lock_guard<std::mutex> lock(m_overflowLock);
+    arena.overflow.push_back(mem);
+    arena.overflowBytes += size;
+
+    return mem;
+}
+
+void FrameAllocator::dealloc(void *mem)
+{
+    // Reclaimed all at once by nextFrame.
+}
+
+size_t FrameAllocator::bytesAllocated()
+{
+    size_t result = 0;
+    for (const auto &arena : m_arenas)
+        result += arena.capacity + arena.overflowBytes;
+    return result;
+}
+
+void FrameAllocator::nextFrame()
+{
+    m_lastFrameBytes = getUsedBytes(m_arenas[m_current]);
+    m_highWaterMark = std::max(m_highWaterMark, m_lastFrameBytes);
+
+    // The other arena was used two frames ago, nothing should reference it by now.
+    m_current = 1 - m_current;
+    reset(m_arenas[m_current]);
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Allocator.h"
+
+namespace df3d {
+
+//! Linear allocator for per-frame temporaries. Allocation is a lock free bump of an offset,
+//! so it can be used from the frame jobs, dealloc does nothing. Memory is double buffered:
+//! whatever is allocated during a frame stays valid through the next one and is reclaimed by
+//! the nextFrame call after that. Background jobs outliving a frame should not use it.
+class FrameAllocator : public Allocator
+{
+    struct Arena
+    {
+        uint8_t *memory = nullptr;
+        size_t capacity = 0;
+        std::atomic<size_t> offset;
+        // Allocations which didn't fit into the arena, freed with it.
+        std::vector<void*> overflow;
+        size_t overflowBytes = 0;
+
+        Arena() : offset(0) { }
+    };
+
+    Allocator &m_alloc;
+    Arena m_arenas[2];
+    size_t m_current = 0;
+    std::mutex m_overflowLock;
+
+    size_t m_lastFrameBytes = 0;
+    size_t m_highWaterMark = 0;
+
+    size_t getUsedBytes(const Arena &arena) const;
+    void reset(Arena &arena);
+
+public:
+    FrameAllocator(Allocator &alloc, size_t capacity);
+    ~FrameAllocator();
+
+    void* alloc(size_t size, size_t alignment) override;
+    void dealloc(void *mem) override;
+    size_t bytesAllocated() override;
+
+    //! Called on frame boundaries, when no allocations are in flight.
+    void nextFrame();
+
+    //! Bytes used by the last finished frame and the maximum over all frames.
+    size_t getLastFrameBytes() const { return m_lastFrameBytes; }
+    size_t getHighWaterMark() const { return m_highWaterMark; }
+};
+
+}
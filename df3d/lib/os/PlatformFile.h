@@ -15,9 +15,21 @@ public:
     virtual size_t read(void *buffer, size_t sizeInBytes) = 0;
 };
 
+//! Read only memory mapping of a whole file.
+class PlatformMappedFile : NonCopyable
+{
+public:
+    PlatformMappedFile() = default;
+    virtual ~PlatformMappedFile() = default;
+
+    virtual const uint8_t* getData() = 0;
+    virtual size_t getSize() = 0;
+};
+
 // TODO: read only FS for now.
 // TODO: rename because it's used for reading data from game package (apk, game data, etc).
 unique_ptr<PlatformFile> PlatformOpenFile(const char *path);
 bool PlatformFileExists(const char *path);
+unique_ptr<PlatformMappedFile> PlatformMapFile(const char *path);
 
 }
@@ -53,6 +53,35 @@ public:
     }
 };
 
+class PlatformMappedFileAndroid : public PlatformMappedFile
+{
+    AAsset *m_file;
+    const uint8_t *m_data;
+
+public:
+    PlatformMappedFileAndroid(AAsset *file, const uint8_t *data)
+        : m_file(file),
+        m_data(data)
+    {
+
+    }
+
+    ~PlatformMappedFileAndroid()
+    {
+        AAsset_close(m_file);
+    }
+
+    const uint8_t* getData() override
+    {
+        return m_data;
+    }
+
+    size_t getSize() override
+    {
+        return AAsset_getLength(m_file);
+    }
+};
+
 unique_ptr<PlatformFile> PlatformOpenFile(const char *path)
 {
     auto mgr = AndroidServices::getAAssetManager();
@@ -71,4 +100,26 @@ bool PlatformFileExists(const char *path)
     return PlatformOpenFile(path) != nullptr;
 }
 
+unique_ptr<PlatformMappedFile> PlatformMapFile(const char *path)
+{
+    auto mgr = AndroidServices::getAAssetManager();
+    if (!mgr)
+        return nullptr;
+
+    // Uncompressed assets are mapped directly from the apk, so the archive should be
+    // stored without compression.
+    AAsset *file = AAssetManager_open(mgr, path, AASSET_MODE_BUFFER);
+    if (!file)
+        return nullptr;
+
+    auto data = (const uint8_t *)AAsset_getBuffer(file);
+    if (!data)
+    {
+        AAsset_close(file);
+        return nullptr;
+    }
+
+    return make_unique<PlatformMappedFileAndroid>(file, data);
+}
+
 }
@@ -5,6 +5,9 @@
 #include <Windows.h>
 #elif defined(DF3D_LINUX) || defined(DF3D_MACOSX)
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #else
 #error "Please implement"
 #endif
@@ -64,6 +67,57 @@ public:
     }
 };
 
+class PlatformMappedFileDesktop : public PlatformMappedFile
+{
+    const uint8_t *m_data;
+    size_t m_size;
+#if defined(DF3D_WINDOWS)
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+
+public:
+#if defined(DF3D_WINDOWS)
+    PlatformMappedFileDesktop(HANDLE file, HANDLE mapping, const uint8_t *data, size_t size)
+        : m_data(data),
+        m_size(size),
+        m_file(file),
+        m_mapping(mapping)
+    {
+
+    }
+
+    ~PlatformMappedFileDesktop()
+    {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+    }
+#else
+    PlatformMappedFileDesktop(const uint8_t *data, size_t size)
+        : m_data(data),
+        m_size(size)
+    {
+
+    }
+
+    ~PlatformMappedFileDesktop()
+    {
+        munmap((void*)m_data, m_size);
+    }
+#endif
+
+    const uint8_t* getData() override
+    {
+        return m_data;
+    }
+
+    size_t getSize() override
+    {
+        return m_size;
+    }
+};
+
 unique_ptr<PlatformFile> PlatformOpenFile(const char *path)
 {
     auto fh = fopen(path, "rb");
@@ -85,4 +139,59 @@ bool PlatformFileExists(const char *path)
 #endif
 }
 
+unique_ptr<PlatformMappedFile> PlatformMapFile(const char *path)
+{
+#if defined(DF3D_WINDOWS)
+    HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    auto data = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    return make_unique<PlatformMappedFileDesktop>(file, mapping, data, (size_t)size.QuadPart);
+#elif defined(DF3D_LINUX) || defined(DF3D_MACOSX)
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced.
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    return make_unique<PlatformMappedFileDesktop>((const uint8_t *)data, (size_t)st.st_size);
+#else
+#error "Please implement"
+#endif
+}
+
 }
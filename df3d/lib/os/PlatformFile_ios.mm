@@ -1,6 +1,10 @@
 #include <df3d/df3d.h>
 #include "PlatformFile.h"
 #import <Foundation/Foundation.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace df3d {
 
@@ -57,6 +61,34 @@ public:
     }
 };
 
+class PlatformMappedFileIOS : public PlatformMappedFile
+{
+    const uint8_t *m_data;
+    size_t m_size;
+
+public:
+    PlatformMappedFileIOS(const uint8_t *data, size_t size)
+        : m_data(data),
+        m_size(size)
+    {
+
+    }
+
+    ~PlatformMappedFileIOS()
+    {
+        munmap((void*)m_data, m_size);
+    }
+
+    const uint8_t* getData() override
+    {
+        return m_data;
+    }
+
+    size_t getSize() override
+    {
+        return m_size;
+    }
+};
 
 static NSString* GetBundlePath(const char *path)
 {
@@ -81,4 +113,28 @@ bool PlatformFileExists(const char *path)
     return [[NSFileManager defaultManager] fileExistsAtPath:GetBundlePath(path)];
 }
 
+unique_ptr<PlatformMappedFile> PlatformMapFile(const char *path)
+{
+    NSString *bundlePath = GetBundlePath(path);
+
+    int fd = ::open([bundlePath UTF8String], O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    return make_unique<PlatformMappedFileIOS>((const uint8_t *)data, (size_t)st.st_size);
+}
+
 }
@@ -0,0 +1,127 @@
+// Multi-threaded alloc/free throughput of MallocAllocator and CachingAllocator over it.
+// Every thread churns its own working set of blocks, then frees blocks allocated by
+// another thread, like decoded resources handed from the workers to the main thread.
+// Usage: bench_allocator [threads count]
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <random>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/memory/MallocAllocator.h>
+#include <df3d/lib/memory/CachingAllocator.h>
+
+using namespace df3d;
+
+static const size_t WORKING_SET = 1024;
+static const size_t ITERATIONS = 2000000;
+static const size_t HANDOFF_BLOCKS = 100000;
+
+static size_t RandomSize(std::mt19937 &rng)
+{
+    // Mostly small blocks, few big ones.
+    auto r = rng() % 100;
+    if (r < 60)
+        return 8 + rng() % 120;
+    if (r < 95)
+        return 128 + rng() % 1920;
+    return 2048 + rng() % 30000;
+}
+
+template<typename F>
+static float RunThreads(size_t threadsCount, F &&fn)
+{
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < threadsCount; i++)
+        threads.emplace_back(fn, i);
+    for (auto &thread : threads)
+        thread.join();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+static void Churn(Allocator &alloc, size_t threadIdx)
+{
+    std::mt19937 rng((unsigned)threadIdx);
+    std::vector<void*> blocks(WORKING_SET, nullptr);
+
+    for (size_t i = 0; i < ITERATIONS; i++)
+    {
+        auto &block = blocks[rng() % WORKING_SET];
+        alloc.dealloc(block);
+        block = alloc.alloc(RandomSize(rng), Allocator::DEFAULT_ALIGN);
+        *(uint8_t *)block = 1;
+    }
+
+    for (auto block : blocks)
+        alloc.dealloc(block);
+}
+
+static void Measure(const char *name, size_t threadsCount, Allocator &(*getAlloc)(size_t))
+{
+    auto churnMs = RunThreads(threadsCount, [getAlloc](size_t threadIdx) {
+        Churn(getAlloc(threadIdx), threadIdx);
+    });
+
+    std::vector<std::vector<void*>> handoff(threadsCount);
+    auto allocMs = RunThreads(threadsCount, [&handoff, getAlloc](size_t threadIdx) {
+        std::mt19937 rng((unsigned)threadIdx);
+        auto &alloc = getAlloc(threadIdx);
+        for (size_t i = 0; i < HANDOFF_BLOCKS; i++)
+            handoff[threadIdx].push_back(alloc.alloc(RandomSize(rng), Allocator::DEFAULT_ALIGN));
+    });
+    auto freeMs = RunThreads(threadsCount, [&handoff, threadsCount, getAlloc](size_t threadIdx) {
+        auto &alloc = getAlloc(threadIdx);
+        for (auto block : handoff[(threadIdx + 1) % threadsCount])
+            alloc.dealloc(block);
+    });
+
+    auto churnOps = 2.0 * ITERATIONS * threadsCount;
+    std::cout << name << ": churn " << churnMs << " ms (" << churnOps / churnMs / 1000.0 << " Mops/s), "
+        << "handoff alloc " << allocMs << " ms, free " << freeMs << " ms\n";
+}
+
+static MallocAllocator *g_malloc = nullptr;
+static CachingAllocator *g_caching = nullptr;
+
+int main(int argc, const char **argv)
+{
+    size_t threadsCount = argc > 1 ? (size_t)std::max(1, atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Threads: " << threadsCount << "\n";
+
+    MallocAllocator malloc;
+    g_malloc = &malloc;
+    Measure("MallocAllocator", threadsCount, [](size_t) -> Allocator& { return *g_malloc; });
+
+    {
+        CachingAllocator caching(malloc);
+        g_caching = &caching;
+
+        // Each thread accounts to its own tag to show the per tag statistics.
+        Measure("CachingAllocator", threadsCount, [](size_t threadIdx) -> Allocator& {
+            return g_caching->getTagged(MemoryTag(threadIdx % MEMORY_TAG_COUNT));
+        });
+
+        std::vector<void*> live;
+        for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+            live.push_back(caching.getTagged(MemoryTag(i)).alloc(1024 * (i + 1), Allocator::DEFAULT_ALIGN));
+
+        auto stats = caching.getStats();
+        for (size_t i = 0; i < MEMORY_TAG_COUNT; i++)
+        {
+            std::cout << "    " << MemoryTagName(MemoryTag(i)) << ": " << stats.bytes[i] << " bytes in "
+                << stats.allocations[i] << " allocations\n";
+        }
+        std::cout << "    slabs: " << stats.slabBytes / 1024 << " KB\n";
+
+        for (auto block : live)
+            caching.dealloc(block);
+    }
+
+    return 0;
+}
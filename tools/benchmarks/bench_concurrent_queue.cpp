@@ -0,0 +1,115 @@
+// Contention benchmark of the mutex based ConcurrentQueue and the lock-free BoundedConcurrentQueue.
+// 1-16 producer threads push std::function items, which are drained by a single consumer like
+// TimeManager does, and by as many consumers as producers.
+
+#include <iostream>
+#include <chrono>
+
+#include <df3d/lib/containers/ConcurrentQueue.h>
+#include <df3d/lib/containers/BoundedConcurrentQueue.h>
+
+using namespace df3d;
+
+static const size_t ITEMS_COUNT = 400000;
+static const size_t QUEUE_CAPACITY = 4096;
+
+using Item = std::function<void ()>;
+
+static bool Push(ConcurrentQueue<Item> &queue, Item &&item)
+{
+    queue.push(std::move(item));
+    return true;
+}
+
+static bool Push(BoundedConcurrentQueue<Item> &queue, Item &&item)
+{
+    return queue.push(std::move(item));
+}
+
+template<typename Queue>
+static float Run(Queue &queue, size_t producersCount, size_t consumersCount)
+{
+    std::atomic<size_t> consumed(0);
+    std::atomic<size_t> sum(0);
+    std::atomic<bool> start(false);
+
+    std::vector<std::thread> threads;
+    const size_t itemsPerProducer = ITEMS_COUNT / producersCount;
+    const size_t total = itemsPerProducer * producersCount;
+
+    for (size_t p = 0; p < producersCount; p++)
+    {
+        threads.push_back(std::thread([&, p]()
+        {
+            while (!start)
+                std::this_thread::yield();
+
+            for (size_t i = 0; i < itemsPerProducer; i++)
+            {
+                Item item = [&sum]() { sum++; };
+                while (!Push(queue, std::move(item)))
+                    std::this_thread::yield();
+            }
+        }));
+    }
+
+    for (size_t c = 0; c < consumersCount; c++)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            while (!start)
+                std::this_thread::yield();
+
+            Item item;
+            while (consumed < total)
+            {
+                if (queue.tryPop(item))
+                {
+                    item();
+                    consumed++;
+                }
+                else
+                    std::this_thread::yield();
+            }
+        }));
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    start = true;
+
+    for (auto &t : threads)
+        t.join();
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+
+    if (sum != total)
+        std::cout << "Error: consumed " << sum << " of " << total << "\n";
+
+    return std::chrono::duration<float, std::milli>(endTime - startTime).count();
+}
+
+int main(int argc, const char **argv)
+{
+    std::cout << "Items: " << ITEMS_COUNT << ", bounded queue capacity: " << QUEUE_CAPACITY << "\n";
+    std::cout << "producers x consumers: ConcurrentQueue ms / BoundedConcurrentQueue ms\n";
+
+    for (size_t producers = 1; producers <= 16; producers *= 2)
+    {
+        for (size_t consumers : { (size_t)1, producers })
+        {
+            ConcurrentQueue<Item> locked;
+            BoundedConcurrentQueue<Item> lockFree(QUEUE_CAPACITY);
+
+            auto lockedMs = Run(locked, producers, consumers);
+            auto lockFreeMs = Run(lockFree, producers, consumers);
+
+            std::cout << producers << " x " << consumers << ": " << lockedMs << " / " << lockFreeMs
+                << " (" << lockedMs / lockFreeMs << "x)\n";
+
+            if (producers == 1)
+                break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Compares loading and spawning of a large entity from json and from the compiled format.
+// The entity is a hierarchy of 10k entities with scene graph and tags components.
+// Usage: bench_entity_loading [working directory for the generated files]
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/3d/SceneGraphComponentProcessor.h>
+#include <df3d/engine/resources/ResourceManager.h>
+#include <df3d/game/World.h>
+#include <df3d/game/impl/EntityLoader.h>
+#include <df3d/lib/JsonUtils.h>
+
+namespace df3d {
+
+extern bool EngineInit(EngineInitParams params);
+extern void EngineShutdown();
+
+}
+
+using namespace df3d;
+
+static const int GROUPS_COUNT = 1000;
+static const int CHILDREN_PER_GROUP = 9;
+static const int PASSES = 5;
+
+static Json::Value MakeComponent(const char *type, const Json::Value &data)
+{
+    Json::Value result;
+    result["type"] = type;
+    result["data"] = data;
+    return result;
+}
+
+static Json::Value MakeEntity(int idx)
+{
+    Json::Value sceneGraph;
+    sceneGraph["name"] = "entity_" + std::to_string(idx);
+    for (int i = 0; i < 3; i++)
+    {
+        sceneGraph["position"].append((float)(idx * 3 + i));
+        sceneGraph["rotation"].append((float)((idx * 7 + i) % 360));
+    }
+
+    Json::Value tags;
+    tags["tags"].append("tag_" + std::to_string(idx % 16));
+    tags["tags"].append("group_" + std::to_string(idx % 4));
+
+    Json::Value result;
+    result["components"].append(MakeComponent("scenegraph", sceneGraph));
+    result["components"].append(MakeComponent("tags", tags));
+    return result;
+}
+
+static size_t WriteFile(const std::string &path, const void *data, size_t size)
+{
+    std::ofstream output(path, std::ios::out | std::ios::binary);
+    output.write((const char *)data, size);
+    return output ? size : 0;
+}
+
+struct Timings
+{
+    float loadMs = 0.0f;
+    float spawnMs = 0.0f;
+};
+
+static Timings LoadAndSpawn(const std::string &path)
+{
+    Timings result;
+    auto &rmgr = svc().resourceManager();
+    auto &world = svc().world();
+
+    for (int i = 0; i < PASSES; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        rmgr.loadPackageAsync({ path });
+        rmgr.flush();
+        auto loaded = std::chrono::high_resolution_clock::now();
+        auto root = world.spawnFromFile(path.c_str());
+        auto spawned = std::chrono::high_resolution_clock::now();
+
+        result.loadMs += std::chrono::duration<float, std::milli>(loaded - start).count() / PASSES;
+        result.spawnMs += std::chrono::duration<float, std::milli>(spawned - loaded).count() / PASSES;
+
+        if (i == 0)
+            std::cout << "    spawned " << world.getEntitiesCount() << " entities\n";
+
+        world.destroyWithChildren(root);
+        rmgr.unloadPackage({ path });
+        rmgr.purgeUnused();
+    }
+
+    return result;
+}
+
+int main(int argc, const char **argv)
+{
+    std::string directory = argc > 1 ? std::string(argv[1]) + "/" : "";
+
+    MemoryManager::init();
+
+    EngineInitParams params;
+    params.headlessRender = true;
+
+    if (!EngineInit(params))
+        return 1;
+
+    {
+        Json::Value root = MakeEntity(0);
+        int idx = 1;
+        for (int group = 0; group < GROUPS_COUNT; group++)
+        {
+            auto groupJson = MakeEntity(idx++);
+            for (int child = 0; child < CHILDREN_PER_GROUP; child++)
+                groupJson["children"].append(MakeEntity(idx++));
+            root["children"].append(groupJson);
+        }
+
+        auto jsonPath = directory + "bench_entity.entity";
+        auto compiledPath = directory + "bench_entity_compiled.entity";
+
+        Json::StreamWriterBuilder builder;
+        auto jsonStr = Json::writeString(builder, root);
+        auto jsonSize = WriteFile(jsonPath, jsonStr.data(), jsonStr.size());
+
+        std::vector<uint8_t> compiled;
+        game_impl::EntityLoader().compileEntity(root, false, compiled);
+        auto compiledSize = WriteFile(compiledPath, compiled.data(), compiled.size());
+
+        if (jsonSize == 0 || compiledSize == 0)
+        {
+            std::cout << "Failed to write the entities to " << directory << "\n";
+            return 1;
+        }
+
+        svc().replaceWorld();
+
+        std::cout << "Json, " << jsonSize / 1024 << " KB:\n";
+        auto jsonTimings = LoadAndSpawn(jsonPath);
+        std::cout << "Compiled, " << compiledSize / 1024 << " KB:\n";
+        auto compiledTimings = LoadAndSpawn(compiledPath);
+
+        std::cout << "Json load: " << jsonTimings.loadMs << " ms, spawn: " << jsonTimings.spawnMs << " ms\n";
+        std::cout << "Compiled load: " << compiledTimings.loadMs << " ms, spawn: " << compiledTimings.spawnMs << " ms\n";
+
+        svc().deleteWorld();
+    }
+
+    EngineShutdown();
+    MemoryManager::shutdown();
+
+    return 0;
+}
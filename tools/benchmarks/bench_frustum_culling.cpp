@@ -0,0 +1,84 @@
+// Compares Frustum::sphereInFrustum called per sphere against the batch
+// Frustum::cullSpheres over the same spheres in SoA layout.
+
+#include <iostream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/Utils.h>
+#include <df3d/lib/math/Frustum.h>
+#include <df3d/lib/math/BoundingSphere.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace df3d;
+
+static const size_t SPHERES_COUNT = 100000;
+static const int ITERATIONS = 100;
+
+int main(int argc, const char **argv)
+{
+    MemoryManager::init();
+    RandomUtils::srand(42);
+
+    {
+        auto proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+        auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum(proj * view);
+
+        std::vector<BoundingSphere> spheres(SPHERES_COUNT);
+        std::vector<float> x(SPHERES_COUNT), y(SPHERES_COUNT), z(SPHERES_COUNT), r(SPHERES_COUNT);
+
+        for (size_t i = 0; i < SPHERES_COUNT; i++)
+        {
+            x[i] = RandomUtils::randRange(-500.0f, 500.0f);
+            y[i] = RandomUtils::randRange(-100.0f, 100.0f);
+            z[i] = RandomUtils::randRange(-600.0f, 100.0f);
+            r[i] = RandomUtils::randRange(0.5f, 5.0f);
+
+            spheres[i].setPosition({ x[i], y[i], z[i] });
+            spheres[i].setRadius(r[i]);
+        }
+
+        std::vector<uint32_t> visibility((SPHERES_COUNT + 31) / 32);
+
+        size_t scalarVisible = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < ITERATIONS; it++)
+        {
+            scalarVisible = 0;
+            for (const auto &sphere : spheres)
+            {
+                if (frustum.sphereInFrustum(sphere))
+                    scalarVisible++;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto scalarUs = std::chrono::duration<float, std::micro>(end - start).count() / ITERATIONS;
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < ITERATIONS; it++)
+            frustum.cullSpheres(x.data(), y.data(), z.data(), r.data(), SPHERES_COUNT, visibility.data());
+        end = std::chrono::high_resolution_clock::now();
+        auto batchUs = std::chrono::duration<float, std::micro>(end - start).count() / ITERATIONS;
+
+        size_t batchVisible = 0;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < SPHERES_COUNT; i++)
+        {
+            bool visible = (visibility[i / 32] & (1u << (i % 32))) != 0;
+            if (visible)
+                batchVisible++;
+            if (visible != frustum.sphereInFrustum(spheres[i]))
+                mismatches++;
+        }
+
+        std::cout << "Spheres: " << SPHERES_COUNT << ", visible: " << scalarVisible << "\n";
+        std::cout << "sphereInFrustum: " << scalarUs << " us\n";
+        std::cout << "cullSpheres: " << batchUs << " us (" << scalarUs / batchUs << "x), visible: " << batchVisible << "\n";
+        std::cout << "Mismatches: " << mismatches << "\n";
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Compares throughput of ThreadPool::enqueue and JobSystem under many small jobs:
+// flat submission from the main thread, nested submission from the jobs, jobs waiting for
+// dependencies and parallelFor.
+
+#include <iostream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/ThreadPool.h>
+#include <df3d/lib/JobSystem.h>
+
+using namespace df3d;
+
+static const size_t JOBS_COUNT = 200000;
+static const size_t NESTED_PARENTS = 1000;
+static const size_t WORK_ITERATIONS = 200;
+
+static float SmallJob(size_t seed)
+{
+    volatile float acc = (float)seed;
+    for (size_t i = 0; i < WORK_ITERATIONS; i++)
+        acc = acc * 0.999f + 1.0f;
+    return acc;
+}
+
+template<typename F>
+static float MeasureMs(F &&fn)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+static void Report(const char *name, float ms, size_t jobs)
+{
+    std::cout << name << ": " << ms << " ms, " << (size_t)(jobs / (ms / 1000.0f)) << " jobs/s\n";
+}
+
+int main(int argc, const char **argv)
+{
+    MemoryManager::init();
+
+    {
+        // ThreadPool is capped at 4 workers.
+        const size_t workers = std::min<size_t>(JobSystem::GetDefaultWorkersCount(), 4);
+        std::cout << "Workers: " << workers << ", jobs: " << JOBS_COUNT << "\n";
+
+        {
+            ThreadPool pool(workers);
+
+            auto ms = MeasureMs([&pool]()
+            {
+                for (size_t i = 0; i < JOBS_COUNT; i++)
+                    pool.enqueue([i]() { SmallJob(i); });
+
+                while (pool.getCurrentJobsCount() > 0)
+                    std::this_thread::yield();
+            });
+            Report("ThreadPool::enqueue", ms, JOBS_COUNT);
+
+            ms = MeasureMs([&pool]()
+            {
+                for (size_t i = 0; i < NESTED_PARENTS; i++)
+                {
+                    pool.enqueue([&pool, i]()
+                    {
+                        for (size_t j = 0; j < JOBS_COUNT / NESTED_PARENTS; j++)
+                            pool.enqueue([i, j]() { SmallJob(i + j); });
+                    });
+                }
+
+                while (pool.getCurrentJobsCount() > 0)
+                    std::this_thread::yield();
+            });
+            Report("ThreadPool::enqueue (nested)", ms, JOBS_COUNT + NESTED_PARENTS);
+        }
+
+        {
+            JobSystem jobs(workers);
+
+            auto ms = MeasureMs([&jobs]()
+            {
+                JobCounter counter(0);
+                for (size_t i = 0; i < JOBS_COUNT; i++)
+                    jobs.run([i]() { SmallJob(i); }, &counter);
+
+                jobs.wait(counter);
+            });
+            Report("JobSystem::run", ms, JOBS_COUNT);
+
+            ms = MeasureMs([&jobs]()
+            {
+                JobCounter counter(0);
+                for (size_t i = 0; i < NESTED_PARENTS; i++)
+                {
+                    jobs.run([&jobs, &counter, i]()
+                    {
+                        for (size_t j = 0; j < JOBS_COUNT / NESTED_PARENTS; j++)
+                            jobs.run([i, j]() { SmallJob(i + j); }, &counter);
+                    }, &counter);
+                }
+
+                jobs.wait(counter);
+            });
+            Report("JobSystem::run (nested)", ms, JOBS_COUNT + NESTED_PARENTS);
+
+            ms = MeasureMs([&jobs]()
+            {
+                // The second half waits for the first one while it's being processed.
+                JobCounter first(0), second(0);
+                for (size_t i = 0; i < JOBS_COUNT / 2; i++)
+                    jobs.run([i]() { SmallJob(i); }, &first);
+                for (size_t i = 0; i < JOBS_COUNT / 2; i++)
+                    jobs.run([i]() { SmallJob(i); }, &second, &first);
+
+                jobs.wait(second);
+            });
+            Report("JobSystem::run (dependencies)", ms, JOBS_COUNT);
+
+            ms = MeasureMs([&jobs]()
+            {
+                jobs.parallelFor(0, JOBS_COUNT, 64, [](size_t from, size_t to)
+                {
+                    for (size_t i = from; i < to; i++)
+                        SmallJob(i);
+                });
+            });
+            Report("JobSystem::parallelFor", ms, JOBS_COUNT);
+        }
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,317 @@
+// Measures dfmesh decoding of a large mesh pack from a memory mapped file, as the packed archive
+// serves it, using the data in place and copying it the way file data sources do.
+// The upload mode creates a mesh resource from the in memory data on the null render backend
+// and checks the buffers got the source vertices and indices.
+// Usage: bench_mesh_loading view|copy|upload [pack path]
+// Peak RSS is per process, so run each mode separately.
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/render/RenderManager.h>
+#include <df3d/engine/render/null/RenderBackendNull.h>
+#include <df3d/engine/resources/ResourceManager.h>
+#include <df3d/engine/resources/ResourceFileSystem.h>
+#include <df3d/engine/resources/ResourceDataSource.h>
+#include <df3d/engine/resources/MeshResource.h>
+#include <df3d/engine/resources/loaders/MeshLoader_dfmesh.h>
+#include <df3d/lib/os/PlatformFile.h>
+
+#if defined(DF3D_LINUX) || defined(DF3D_MACOSX)
+#include <sys/resource.h>
+#endif
+
+namespace df3d {
+
+extern bool EngineInit(EngineInitParams params);
+extern void EngineShutdown();
+
+}
+
+using namespace df3d;
+
+static const size_t MESHES_COUNT = 128;
+static const size_t VERTICES_PER_MESH = 16000;
+static const size_t INDICES_PER_MESH = VERTICES_PER_MESH * 3;
+static const size_t MESH_ALIGNMENT = 16;
+
+// Hides the view so the loader reads everything into own buffers.
+class CopyingDataSource : public ResourceDataSource
+{
+    MemoryDataSource m_source;
+
+public:
+    CopyingDataSource(const uint8_t *buffer, int32_t size) : m_source(buffer, size) { }
+
+    size_t read(void *buffer, size_t sizeInBytes) override { return m_source.read(buffer, sizeInBytes); }
+    size_t getSize() override { return m_source.getSize(); }
+    int32_t tell() override { return m_source.tell(); }
+    bool seek(int32_t offset, SeekDir origin) override { return m_source.seek(offset, origin); }
+};
+
+// Serves every path from the same memory, like the packed archive serves uncompressed entries.
+class MemoryFileSystem : public ResourceFileSystem
+{
+    const uint8_t *m_data;
+    size_t m_size;
+
+public:
+    MemoryFileSystem(const uint8_t *data, size_t size) : m_data(data), m_size(size) { }
+
+    ResourceDataSource* open(const char *path) override
+    {
+        return MAKE_NEW(MemoryManager::allocDefault(), MemoryDataSource)(m_data, (int32_t)m_size);
+    }
+
+    void close(ResourceDataSource *dataSource) override
+    {
+        MAKE_DELETE(MemoryManager::allocDefault(), dataSource);
+    }
+};
+
+static size_t GetPeakRSSKb()
+{
+#if defined(DF3D_LINUX)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#elif defined(DF3D_MACOSX)
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+#else
+    return 0;
+#endif
+}
+
+static size_t GetSubmeshesOffset()
+{
+    return (sizeof(DFMeshHeader) + DFMESH_CHUNK_ALIGNMENT - 1) / DFMESH_CHUNK_ALIGNMENT * DFMESH_CHUNK_ALIGNMENT;
+}
+
+static size_t GetMeshDataSize()
+{
+    auto vertexSize = VertexFormat_dfmesh(0).getVertexSize();
+    return GetSubmeshesOffset() + sizeof(DFMeshSubmeshHeader) + vertexSize * VERTICES_PER_MESH + INDICES_PER_MESH * sizeof(uint16_t);
+}
+
+// Meshes are aligned in the pack, the padding isn't part of the mesh data.
+static size_t GetMeshSize()
+{
+    return (GetMeshDataSize() + MESH_ALIGNMENT - 1) / MESH_ALIGNMENT * MESH_ALIGNMENT;
+}
+
+// Writes meshes one by one so the generator doesn't add to the peak RSS.
+static bool WritePack(const char *path)
+{
+    std::ofstream output(path, std::ios::out | std::ios::binary);
+    if (!output)
+        return false;
+
+    const auto vf = VertexFormat_dfmesh(0);
+    const size_t vertexDataSize = vf.getVertexSize() * VERTICES_PER_MESH;
+
+    DFMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header.magic, DFMESH_MAGIC, sizeof(DFMESH_MAGIC));
+    header.version = DFMESH_VERSION;
+    header.indexSize = sizeof(uint16_t);
+    header.submeshesCount = 1;
+    header.submeshesOffset = GetSubmeshesOffset();
+
+    DFMeshSubmeshHeader smHeader;
+    memset(&smHeader, 0, sizeof(smHeader));
+    smHeader.vertexDataSizeInBytes = vertexDataSize;
+    smHeader.indexSize = sizeof(uint16_t);
+    smHeader.indexDataSizeInBytes = INDICES_PER_MESH * sizeof(uint16_t);
+    smHeader.chunkSize = sizeof(smHeader) + smHeader.vertexDataSizeInBytes + smHeader.indexDataSizeInBytes;
+    strcpy(smHeader.materialId, "material");
+
+    std::vector<float> vertices(vertexDataSize / sizeof(float));
+    std::vector<uint16_t> indices(INDICES_PER_MESH);
+    std::vector<char> padding(MESH_ALIGNMENT + DFMESH_CHUNK_ALIGNMENT, 0);
+
+    for (size_t mesh = 0; mesh < MESHES_COUNT; mesh++)
+    {
+        for (size_t i = 0; i < vertices.size(); i++)
+            vertices[i] = (float)((i * 7 + mesh) % 1000) * 0.01f;
+        for (size_t i = 0; i < indices.size(); i++)
+            indices[i] = (uint16_t)((i * 13 + mesh) % VERTICES_PER_MESH);
+
+        output.write((const char *)&header, sizeof(header));
+        output.write(padding.data(), header.submeshesOffset - sizeof(header));
+        output.write((const char *)&smHeader, sizeof(smHeader));
+        output.write((const char *)vertices.data(), vertexDataSize);
+        output.write((const char *)indices.data(), indices.size() * sizeof(uint16_t));
+        output.write(padding.data(), GetMeshSize() - header.submeshesOffset - smHeader.chunkSize);
+    }
+
+    return !output.fail();
+}
+
+// Goes through MeshHolder like the resource manager does, the first mesh of the pack is used in place.
+static bool CheckUpload(const uint8_t *meshData)
+{
+    EngineInitParams params;
+    params.headlessRender = true;
+
+    if (!EngineInit(params))
+        return false;
+
+    bool ok = false;
+    {
+        auto &backend = static_cast<RenderBackendNull&>(svc().renderManager().getBackend());
+        backend.keepBuffersData(true);
+        svc().resourceManager().setFileSystem(make_unique<MemoryFileSystem>(meshData, GetMeshDataSize()));
+
+        auto &alloc = MemoryManager::allocDefault();
+        const char json[] = "{ \"path\": \"bench.dfmesh\" }";
+        MemoryDataSource jsonSource((const uint8_t *)json, sizeof(json) - 1);
+
+        MeshHolder holder;
+        if (holder.decodeStartup(jsonSource, alloc))
+        {
+            if (holder.createResource(alloc))
+            {
+                auto resource = static_cast<MeshResource*>(holder.getResource());
+                const auto &hwPart = resource->meshParts[0];
+
+                const size_t vertexDataSize = VertexFormat_dfmesh(0).getVertexSize() * VERTICES_PER_MESH;
+                const size_t indexDataSize = INDICES_PER_MESH * sizeof(uint16_t);
+                auto vertices = meshData + GetSubmeshesOffset() + sizeof(DFMeshSubmeshHeader);
+                auto indices = vertices + vertexDataSize;
+
+                const auto &uploadedVertices = backend.getVertexBufferData(hwPart.vertexBuffer);
+                const auto &uploadedIndices = backend.getIndexBufferData(hwPart.indexBuffer);
+
+                bool verticesOk = uploadedVertices.size() == vertexDataSize && memcmp(uploadedVertices.data(), vertices, vertexDataSize) == 0;
+                bool indicesOk = uploadedIndices.size() == indexDataSize && memcmp(uploadedIndices.data(), indices, indexDataSize) == 0;
+
+                std::cout << "Uploaded vertices: " << uploadedVertices.size() << " bytes, " << (verticesOk ? "match" : "DIFFER") << "\n";
+                std::cout << "Uploaded indices: " << uploadedIndices.size() << " bytes, " << (indicesOk ? "match" : "DIFFER") << "\n";
+                ok = verticesOk && indicesOk;
+
+                holder.destroyResource(alloc);
+            }
+            holder.decodeCleanup(alloc);
+        }
+
+        svc().resourceManager().setDefaultFileSystem();
+    }
+
+    EngineShutdown();
+
+    std::cout << (ok ? "OK" : "FAILED") << "\n";
+    return ok;
+}
+
+int main(int argc, const char **argv)
+{
+    if (argc < 2 || (strcmp(argv[1], "view") != 0 && strcmp(argv[1], "copy") != 0 && strcmp(argv[1], "upload") != 0))
+    {
+        std::cout << "Usage: bench_mesh_loading view|copy|upload [pack path]\n";
+        return 1;
+    }
+
+    const bool useView = strcmp(argv[1], "view") == 0;
+    const char *packPath = argc > 2 ? argv[2] : "bench_mesh_pack.bin";
+
+    MemoryManager::init();
+
+    if (!WritePack(packPath))
+    {
+        std::cout << "Failed to write " << packPath << "\n";
+        return 1;
+    }
+
+    {
+        auto file = PlatformMapFile(packPath);
+        if (!file)
+        {
+            std::cout << "Failed to map " << packPath << "\n";
+            return 1;
+        }
+
+        if (strcmp(argv[1], "upload") == 0)
+        {
+            bool ok = CheckUpload(file->getData());
+            file.reset();
+            MemoryManager::shutdown();
+            return ok ? 0 : 1;
+        }
+
+        auto &alloc = MemoryManager::allocDefault();
+        auto rssBefore = GetPeakRSSKb();
+
+        std::vector<MeshResourceData*> meshes;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t mesh = 0; mesh < MESHES_COUNT; mesh++)
+        {
+            auto data = file->getData() + mesh * GetMeshSize();
+
+            MeshResourceData *result = nullptr;
+            if (useView)
+            {
+                MemoryDataSource source(data, GetMeshDataSize());
+                result = MeshLoader_dfmesh(source, alloc);
+            }
+            else
+            {
+                CopyingDataSource source(data, GetMeshDataSize());
+                result = MeshLoader_dfmesh(source, alloc);
+            }
+
+            if (result)
+                meshes.push_back(result);
+        }
+        auto loaded = std::chrono::high_resolution_clock::now();
+
+        // Touch all vertices and indices like bounds computation and uploading do.
+        float checksum = 0.0f;
+        size_t indicesChecksum = 0;
+        for (auto mesh : meshes)
+        {
+            for (auto part : mesh->parts)
+            {
+                const auto &vdata = part->vertexData;
+                for (size_t i = 0; i < vdata.getVerticesCount(); i++)
+                    checksum += ((const glm::vec3*)vdata.getVertexAttribute(i, VertexFormat::POSITION))->x;
+
+                if (part->indicesType == INDICES_16_BIT)
+                {
+                    auto indices = (const uint16_t *)part->getIndices();
+                    for (size_t i = 0; i < part->getIndicesCount(); i++)
+                        indicesChecksum += indices[i];
+                }
+                else
+                {
+                    auto indices = (const uint32_t *)part->getIndices();
+                    for (size_t i = 0; i < part->getIndicesCount(); i++)
+                        indicesChecksum += indices[i];
+                }
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Mode: " << (useView ? "view" : "copy") << ", meshes: " << meshes.size()
+            << ", pack size: " << (GetMeshSize() * MESHES_COUNT) / (1024 * 1024) << " MB\n";
+        std::cout << "Decode: " << std::chrono::duration<float, std::milli>(loaded - start).count() << " ms, "
+            << "decode + first access: " << std::chrono::duration<float, std::milli>(end - start).count() << " ms\n";
+        std::cout << "Peak RSS: " << GetPeakRSSKb() / 1024 << " MB (" << rssBefore / 1024 << " MB before loading)"
+            << ", checksum: " << checksum << " " << indicesChecksum << "\n";
+
+        for (auto mesh : meshes)
+        {
+            for (auto part : mesh->parts)
+                MAKE_DELETE(alloc, part);
+            MAKE_DELETE(alloc, mesh);
+        }
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Vertex welding and cache reordering of obj meshes. Loads a generated obj through MeshLoader_obj
+// with and without obj_indexize, then compares MeshUtils::indexize with the former std::map based
+// welding and reports the vertex cache miss ratio before and after MeshUtils::optimizeVertexCache.
+// The faces are shuffled like in meshes exported without any optimization.
+// Usage: bench_obj_indexize [triangles count]
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <map>
+#include <array>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/EngineCVars.h>
+#include <df3d/engine/render/MeshUtils.h>
+#include <df3d/engine/render/Vertex.h>
+#include <df3d/engine/resources/ResourceDataSource.h>
+#include <df3d/engine/resources/MeshResource.h>
+#include <df3d/engine/resources/loaders/MeshLoader_obj.h>
+
+using namespace df3d;
+
+// Each material is a separate part, sized to fit 16-bit indices.
+static const size_t MATERIALS_COUNT = 16;
+static const size_t GRID_WIDTH = 125;
+
+static std::string GenerateObj(size_t trianglesCount)
+{
+    const size_t quadsPerPart = trianglesCount / MATERIALS_COUNT / 2;
+    const size_t gridHeight = std::max<size_t>(1, quadsPerPart / GRID_WIDTH);
+
+    std::mt19937 rng(1);
+    std::ostringstream os;
+
+    for (size_t part = 0; part < MATERIALS_COUNT; part++)
+    {
+        const size_t firstVertex = part * (GRID_WIDTH + 1) * (gridHeight + 1) + 1;
+
+        for (size_t y = 0; y <= gridHeight; y++)
+        {
+            for (size_t x = 0; x <= GRID_WIDTH; x++)
+            {
+                float h = std::sin(x * 0.1f) * std::cos(y * 0.1f);
+                os << "v " << x + part * GRID_WIDTH << " " << h << " " << y << "\n";
+                os << "vt " << x / (float)GRID_WIDTH << " " << y / (float)gridHeight << "\n";
+                os << "vn 0 1 0\n";
+            }
+        }
+
+        std::vector<std::array<size_t, 3>> triangles;
+        for (size_t y = 0; y < gridHeight; y++)
+        {
+            for (size_t x = 0; x < GRID_WIDTH; x++)
+            {
+                size_t a = firstVertex + y * (GRID_WIDTH + 1) + x;
+                size_t b = a + 1, c = a + GRID_WIDTH + 1, d = c + 1;
+                triangles.push_back({ a, c, b });
+                triangles.push_back({ b, c, d });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), rng);
+
+        os << "usemtl material" << part << "\n";
+        for (const auto &tri : triangles)
+            os << "f " << tri[0] << "/" << tri[0] << "/" << tri[0] << " " << tri[1] << "/" << tri[1] << "/" << tri[1]
+                << " " << tri[2] << "/" << tri[2] << "/" << tri[2] << "\n";
+    }
+
+    return os.str();
+}
+
+struct CompareVertices
+{
+    bool operator()(const Vertex_p_n_tx_tan_bitan &a, const Vertex_p_n_tx_tan_bitan &b) const
+    {
+        return memcmp(&a, &b, sizeof(Vertex_p_n_tx_tan_bitan)) > 0;
+    }
+};
+
+// The welding MeshUtils::indexize used to do.
+static size_t IndexizeWithMap(const Vertex_p_n_tx_tan_bitan *vdata, size_t count, std::vector<uint32_t> &outIndices)
+{
+    std::map<Vertex_p_n_tx_tan_bitan, uint32_t, CompareVertices> lookup;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto found = lookup.find(vdata[i]);
+        if (found != lookup.end())
+        {
+            outIndices.push_back(found->second);
+        }
+        else
+        {
+            auto newIdx = (uint32_t)lookup.size();
+            lookup[vdata[i]] = newIdx;
+            outIndices.push_back(newIdx);
+        }
+    }
+
+    return lookup.size();
+}
+
+// Average cache miss ratio, vertices transformed per triangle with a FIFO cache.
+static float GetACMR(const uint32_t *indices, size_t indicesCount, size_t verticesCount, size_t cacheSize)
+{
+    std::vector<size_t> cachedAt(verticesCount, 0);
+    size_t misses = 0;
+
+    for (size_t i = 0; i < indicesCount; i++)
+    {
+        auto v = indices[i];
+        if (cachedAt[v] == 0 || misses - cachedAt[v] >= cacheSize)
+            cachedAt[v] = ++misses;
+    }
+
+    return (float)misses / (indicesCount / 3);
+}
+
+static MeshResourceData* LoadObj(const std::string &obj, bool indexize, float &outMs)
+{
+    EngineCVars::objIndexize = indexize;
+
+    MemoryDataSource source((const uint8_t *)obj.data(), (int32_t)obj.size());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto result = MeshLoader_obj(source, MemoryManager::allocDefault());
+    auto end = std::chrono::high_resolution_clock::now();
+
+    outMs = std::chrono::duration<float, std::milli>(end - start).count();
+
+    return result;
+}
+
+static void DestroyMesh(MeshResourceData *mesh)
+{
+    auto &alloc = MemoryManager::allocDefault();
+    for (auto part : mesh->parts)
+        MAKE_DELETE(alloc, part);
+    MAKE_DELETE(alloc, mesh);
+}
+
+int main(int argc, const char **argv)
+{
+    const size_t trianglesCount = argc > 1 ? (size_t)std::max(1, atoi(argv[1])) : 1000000;
+
+    MemoryManager::init();
+
+    auto obj = GenerateObj(trianglesCount);
+    std::cout << "Obj: " << obj.size() / (1024 * 1024) << " MB\n";
+
+    {
+        float plainMs, indexizedMs;
+        auto plain = LoadObj(obj, false, plainMs);
+        auto indexized = LoadObj(obj, true, indexizedMs);
+
+        size_t triangles = 0, vertices = 0, indexedVertices = 0;
+        for (auto part : plain->parts)
+        {
+            triangles += part->vertexData.getVerticesCount() / 3;
+            vertices += part->vertexData.getVerticesCount();
+        }
+        for (auto part : indexized->parts)
+            indexedVertices += part->vertexData.getVerticesCount();
+
+        std::cout << "Triangles: " << triangles << ", parts: " << plain->parts.size() << "\n";
+        std::cout << "MeshLoader_obj: " << plainMs << " ms, with obj_indexize " << indexizedMs << " ms, vertices "
+            << vertices << " -> " << indexedVertices << "\n";
+
+        auto &alloc = MemoryManager::allocDefault();
+        float hashMs = 0.0f, mapMs = 0.0f, optimizeMs = 0.0f;
+        float acmrBefore = 0.0f, acmrAfter = 0.0f;
+
+        for (auto part : plain->parts)
+        {
+            auto vdata = (const Vertex_p_n_tx_tan_bitan *)part->vertexData.getRawData();
+            auto count = part->vertexData.getVerticesCount();
+
+            PodArray<Vertex_p_n_tx_tan_bitan> outVertices(alloc);
+            PodArray<uint32_t> outIndices(alloc);
+            std::vector<uint32_t> mapIndices;
+
+            auto t0 = std::chrono::high_resolution_clock::now();
+            MeshUtils::indexize(vdata, count, outVertices, outIndices);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            auto mapVertices = IndexizeWithMap(vdata, count, mapIndices);
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            if (mapVertices != outVertices.size())
+                std::cout << "Mismatch: " << mapVertices << " vs " << outVertices.size() << " vertices\n";
+
+            acmrBefore += GetACMR(outIndices.data(), outIndices.size(), outVertices.size(), 32) / plain->parts.size();
+
+            auto t3 = std::chrono::high_resolution_clock::now();
+            MeshUtils::optimizeVertexCache(outIndices.data(), outIndices.size(), outVertices.size());
+            auto t4 = std::chrono::high_resolution_clock::now();
+
+            acmrAfter += GetACMR(outIndices.data(), outIndices.size(), outVertices.size(), 32) / plain->parts.size();
+
+            hashMs += std::chrono::duration<float, std::milli>(t1 - t0).count();
+            mapMs += std::chrono::duration<float, std::milli>(t2 - t1).count();
+            optimizeMs += std::chrono::duration<float, std::milli>(t4 - t3).count();
+        }
+
+        std::cout << "Welding: hash " << hashMs << " ms, std::map " << mapMs << " ms\n";
+        std::cout << "Vertex cache reordering: " << optimizeMs << " ms, ACMR (32 entries FIFO) "
+            << acmrBefore << " -> " << acmrAfter << "\n";
+
+        DestroyMesh(plain);
+        DestroyMesh(indexized);
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
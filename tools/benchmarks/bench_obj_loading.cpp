@@ -0,0 +1,348 @@
+// OBJ parsing throughput. Loads a generated obj of the given size through MeshLoader_obj on the
+// calling thread and on the job system, and through the std::istream based parsing the loader
+// used before. Indexing is off, all of them compute the tangents which take most of the time,
+// so the parsing throughput is reported without them as well.
+// The check mode compares the parsed floats to strtof and the relative face indices to the
+// absolute ones instead.
+// Usage: bench_obj_loading [size in MB] [workers count]
+//        bench_obj_loading check [workers count]
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/EngineCVars.h>
+#include <df3d/engine/render/MeshUtils.h>
+#include <df3d/engine/render/Vertex.h>
+#include <df3d/engine/resources/ResourceDataSource.h>
+#include <df3d/engine/resources/MeshResource.h>
+#include <df3d/engine/resources/loaders/MeshLoader_obj.h>
+#include <df3d/lib/JobSystem.h>
+#include <df3d/lib/Utils.h>
+
+using namespace df3d;
+
+static const size_t MATERIALS_COUNT = 16;
+static const size_t GRID_WIDTH = 250;
+static const size_t GRID_HEIGHT = 50;
+
+static std::string GenerateObj(size_t sizeInBytes)
+{
+    std::string result;
+    result.reserve(sizeInBytes + 1024 * 1024);
+    result += "# generated by bench_obj_loading\nmtllib bench.mtl\n";
+
+    char line[256];
+    size_t firstVertex = 1;
+
+    for (size_t part = 0; result.size() < sizeInBytes; part++)
+    {
+        snprintf(line, sizeof(line), "o part%d\n", (int)part);
+        result += line;
+
+        for (size_t y = 0; y <= GRID_HEIGHT; y++)
+        {
+            for (size_t x = 0; x <= GRID_WIDTH; x++)
+            {
+                float h = std::sin(x * 0.1f + part) * std::cos(y * 0.1f);
+                snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+                         x * 0.01f + part, h, y * -0.01f, x / (float)GRID_WIDTH, y / (float)GRID_HEIGHT,
+                         -h * 0.1f, 1.0f, 0.25f);
+                result += line;
+            }
+        }
+
+        snprintf(line, sizeof(line), "usemtl material%d\ns 1\n", (int)(part % MATERIALS_COUNT));
+        result += line;
+
+        for (size_t y = 0; y < GRID_HEIGHT; y++)
+        {
+            for (size_t x = 0; x < GRID_WIDTH; x++)
+            {
+                size_t a = firstVertex + y * (GRID_WIDTH + 1) + x;
+                size_t b = a + 1, c = a + GRID_WIDTH + 1, d = c + 1;
+                snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n",
+                         (int)a, (int)a, (int)a, (int)c, (int)c, (int)c, (int)b, (int)b, (int)b,
+                         (int)b, (int)b, (int)b, (int)c, (int)c, (int)c, (int)d, (int)d, (int)d);
+                result += line;
+            }
+        }
+
+        firstVertex += (GRID_WIDTH + 1) * (GRID_HEIGHT + 1);
+    }
+
+    return result;
+}
+
+// The parsing MeshLoader_obj used to do.
+static size_t LoadObjWithStreams(const std::string &obj, double &outChecksum, float &outTangentsMs)
+{
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> txCoords;
+    std::unordered_map<std::string, std::vector<Vertex_p_n_tx_tan_bitan>> parts;
+    std::vector<Vertex_p_n_tx_tan_bitan> *currentPart = nullptr;
+
+    std::istringstream input(obj);
+    std::string tok;
+    while (input >> tok)
+    {
+        if (tok == "v")
+        {
+            glm::vec3 v;
+            input >> v.x >> v.y >> v.z;
+            vertices.push_back(v);
+        }
+        else if (tok == "vt")
+        {
+            glm::vec2 uv;
+            input >> uv.x >> uv.y;
+            uv.y = 1.0f - uv.y;
+            txCoords.push_back(uv);
+        }
+        else if (tok == "vn")
+        {
+            glm::vec3 n;
+            input >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (tok == "f")
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                char temp;
+                int vertexidx, uvidx, normalidx;
+                input >> vertexidx >> temp >> uvidx >> temp >> normalidx;
+
+                Vertex_p_n_tx_tan_bitan v = {};
+                v.pos = vertices[vertexidx - 1];
+                v.uv = txCoords[uvidx - 1];
+                v.normal = normals[normalidx - 1];
+                currentPart->push_back(v);
+            }
+        }
+        else if (tok == "usemtl")
+        {
+            input >> tok;
+            currentPart = &parts[tok];
+        }
+        else
+        {
+            utils::skip_line(input);
+        }
+    }
+
+    size_t result = 0;
+    outChecksum = 0.0;
+    outTangentsMs = 0.0f;
+    for (auto &kv : parts)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        MeshUtils::computeTangentBasis(kv.second.data(), kv.second.size());
+        auto end = std::chrono::high_resolution_clock::now();
+        outTangentsMs += std::chrono::duration<float, std::milli>(end - start).count();
+
+        result += kv.second.size();
+        for (const auto &v : kv.second)
+            outChecksum += v.pos.x + v.uv.y;
+    }
+
+    return result;
+}
+
+static size_t GetVerticesCount(const MeshResourceData &mesh, double &outChecksum)
+{
+    size_t result = 0;
+    outChecksum = 0.0;
+    for (auto part : mesh.parts)
+    {
+        auto vdata = (const Vertex_p_n_tx_tan_bitan *)part->vertexData.getRawData();
+        for (size_t i = 0; i < part->vertexData.getVerticesCount(); i++)
+            outChecksum += vdata[i].pos.x + vdata[i].uv.y;
+        result += part->vertexData.getVerticesCount();
+    }
+    return result;
+}
+
+// Time MeshLoader_obj spent on the tangents, the loader doesn't report it.
+static float MeasureTangents(const MeshResourceData &mesh)
+{
+    float result = 0.0f;
+    for (auto part : mesh.parts)
+    {
+        auto vdata = (const Vertex_p_n_tx_tan_bitan *)part->vertexData.getRawData();
+        std::vector<Vertex_p_n_tx_tan_bitan> vertices(vdata, vdata + part->vertexData.getVerticesCount());
+
+        auto start = std::chrono::high_resolution_clock::now();
+        MeshUtils::computeTangentBasis(vertices.data(), vertices.size());
+        auto end = std::chrono::high_resolution_clock::now();
+        result += std::chrono::duration<float, std::milli>(end - start).count();
+    }
+    return result;
+}
+
+static void DestroyMesh(MeshResourceData *mesh)
+{
+    auto &alloc = MemoryManager::allocDefault();
+    for (auto part : mesh->parts)
+        MAKE_DELETE(alloc, part);
+    MAKE_DELETE(alloc, mesh);
+}
+
+static void Report(const char *name, float ms, float tangentsMs, size_t sizeInBytes, size_t verticesCount, double checksum)
+{
+    const double sizeInMb = sizeInBytes / (1024.0 * 1024.0);
+    std::cout << name << ": " << ms << " ms, " << sizeInMb / (ms / 1000.0) << " MB/s, ";
+    if (tangentsMs > 0.0f)
+        std::cout << "without tangents " << sizeInMb / ((ms - tangentsMs) / 1000.0) << " MB/s, ";
+    std::cout << verticesCount << " vertices, checksum " << checksum << "\n";
+}
+
+// Every position is referenced once, in order, by relative or absolute indices. The faces follow
+// their vertices, so the relative ones cross the chunk boundaries.
+static std::string GenerateCheckObj(size_t floatsCount, bool relative, std::vector<float> &outExpected)
+{
+    static const char *FORMATS[] = { "%.6f", "%.9g", "%e", "%.3f", "%g", "%.17g" };
+
+    std::mt19937 rng(3);
+    std::string result = "vn 0 1 0\nusemtl material\n";
+    char line[256];
+
+    outExpected.clear();
+    for (size_t i = 0; i + 9 <= floatsCount; i += 9)
+    {
+        for (size_t v = 0; v < 3; v++)
+        {
+            result += "v";
+            for (size_t c = 0; c < 3; c++)
+            {
+                auto value = std::ldexp((double)(rng() % 1000000) / 1000000.0 - 0.5, (int)(rng() % 60) - 30);
+                snprintf(line, sizeof(line), FORMATS[outExpected.size() % 6], value);
+                outExpected.push_back(strtof(line, nullptr));
+                result += " ";
+                result += line;
+            }
+            result += "\n";
+        }
+
+        if (relative)
+        {
+            result += "f -3//-1 -2//-1 -1//-1\n";
+        }
+        else
+        {
+            auto first = (int)(outExpected.size() / 3 - 2);
+            snprintf(line, sizeof(line), "f %d//1 %d//1 %d//1\n", first, first + 1, first + 2);
+            result += line;
+        }
+    }
+
+    return result;
+}
+
+static int Check(JobSystem &jobs)
+{
+    const size_t FLOATS_COUNT = 2000000;
+
+    bool ok = true;
+    for (auto relative : { false, true })
+    {
+        std::vector<float> expected;
+        auto obj = GenerateCheckObj(FLOATS_COUNT, relative, expected);
+
+        MemoryDataSource source((const uint8_t *)obj.data(), (int32_t)obj.size());
+        auto mesh = MeshLoader_obj(source, MemoryManager::allocDefault(), &jobs);
+
+        size_t mismatches = 0, parsed = 0;
+        if (mesh && mesh->parts.size() == 1)
+        {
+            const auto &vertexData = mesh->parts[0]->vertexData;
+            auto vdata = (const Vertex_p_n_tx_tan_bitan *)vertexData.getRawData();
+
+            parsed = vertexData.getVerticesCount() * 3;
+            for (size_t i = 0; i < std::min(parsed, expected.size()); i++)
+            {
+                if (memcmp(&vdata[i / 3].pos[i % 3], &expected[i], sizeof(float)) != 0)
+                    mismatches++;
+            }
+        }
+
+        std::cout << (relative ? "Relative indices: " : "Absolute indices: ") << parsed << " of " << expected.size()
+            << " floats, " << mismatches << " differ from strtof\n";
+
+        ok = ok && parsed == expected.size() && mismatches == 0;
+
+        if (mesh)
+            DestroyMesh(mesh);
+    }
+
+    std::cout << (ok ? "OK" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
+
+template<typename F>
+static float Measure(F &&fn)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+int main(int argc, const char **argv)
+{
+    const bool check = argc > 1 && strcmp(argv[1], "check") == 0;
+    const size_t sizeInMb = argc > 1 && !check ? (size_t)std::max(1, atoi(argv[1])) : 256;
+    const size_t workersCount = argc > 2 ? (size_t)std::max(0, atoi(argv[2])) : JobSystem::GetDefaultWorkersCount();
+
+    MemoryManager::init();
+    EngineCVars::objIndexize = false;
+
+    if (check)
+    {
+        int result;
+        {
+            JobSystem jobs(workersCount);
+            result = Check(jobs);
+        }
+        MemoryManager::shutdown();
+        return result;
+    }
+
+    {
+        auto obj = GenerateObj(sizeInMb * 1024 * 1024);
+        std::cout << "Obj: " << obj.size() / (1024 * 1024) << " MB, workers: " << workersCount << "\n";
+
+        JobSystem jobs(workersCount);
+
+        for (auto useJobs : { false, true })
+        {
+            MemoryDataSource source((const uint8_t *)obj.data(), (int32_t)obj.size());
+
+            MeshResourceData *mesh = nullptr;
+            auto ms = Measure([&]() { mesh = MeshLoader_obj(source, MemoryManager::allocDefault(), useJobs ? &jobs : nullptr); });
+
+            double checksum;
+            auto verticesCount = GetVerticesCount(*mesh, checksum);
+            // The parts are processed in parallel too, not separated then.
+            auto tangentsMs = useJobs ? 0.0f : MeasureTangents(*mesh);
+
+            Report(useJobs ? "MeshLoader_obj, job system" : "MeshLoader_obj", ms, tangentsMs, obj.size(), verticesCount, checksum);
+
+            DestroyMesh(mesh);
+        }
+
+        double checksum = 0.0;
+        float tangentsMs = 0.0f;
+        size_t verticesCount = 0;
+        auto ms = Measure([&]() { verticesCount = LoadObjWithStreams(obj, checksum, tangentsMs); });
+        Report("std::istream", ms, tangentsMs, obj.size(), verticesCount, checksum);
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Compares loading of loose files through the default file system with the packed archive.
+// Usage: bench_packed_archive archive.pak list.txt
+// where the archive is made by `res_packer archive.pak @list.txt` from the same directory.
+// The first pass over each file system is cold: on Linux files are evicted from the page
+// cache beforehand, on other platforms it's the first access in the process only.
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/resources/ResourceFileSystem.h>
+#include <df3d/engine/resources/ResourceDataSource.h>
+#include <df3d/engine/resources/PackedArchiveFileSystem.h>
+
+#if defined(DF3D_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace df3d;
+
+static const int WARM_PASSES = 5;
+
+static void EvictFromPageCache(const std::string &path)
+{
+#if defined(DF3D_LINUX)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd != -1)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+#endif
+}
+
+// Opens, reads and closes every file, like a resource decoder does.
+static float LoadAll(ResourceFileSystem &fs, const std::vector<std::string> &paths, std::vector<uint8_t> &buffer, size_t &totalBytes)
+{
+    totalBytes = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto &path : paths)
+    {
+        auto dataSource = fs.open(path.c_str());
+        if (!dataSource)
+        {
+            std::cout << "Failed to open " << path << "\n";
+            continue;
+        }
+
+        auto size = dataSource->getSize();
+        if (buffer.size() < size)
+            buffer.resize(size);
+
+        totalBytes += dataSource->read(buffer.data(), size);
+
+        fs.close(dataSource);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+int main(int argc, const char **argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "Usage: bench_packed_archive archive.pak list.txt\n";
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    {
+        std::ifstream list(argv[2]);
+        std::string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty())
+                paths.push_back(line);
+        }
+    }
+
+    MemoryManager::init();
+
+    {
+        std::vector<uint8_t> buffer;
+        size_t totalBytes = 0;
+
+        for (const auto &path : paths)
+            EvictFromPageCache(path);
+        EvictFromPageCache(argv[1]);
+
+        auto looseFs = CreateDefaultResourceFileSystem();
+        auto looseCold = LoadAll(*looseFs, paths, buffer, totalBytes);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        auto archiveFs = CreatePackedArchiveFileSystem(argv[1]);
+        auto end = std::chrono::high_resolution_clock::now();
+        if (!archiveFs)
+            return 1;
+
+        auto mapTime = std::chrono::duration<float, std::milli>(end - start).count();
+        auto archiveCold = LoadAll(*archiveFs, paths, buffer, totalBytes);
+
+        float looseWarm = 0.0f, archiveWarm = 0.0f;
+        for (int i = 0; i < WARM_PASSES; i++)
+        {
+            looseWarm += LoadAll(*looseFs, paths, buffer, totalBytes);
+            archiveWarm += LoadAll(*archiveFs, paths, buffer, totalBytes);
+        }
+        looseWarm /= WARM_PASSES;
+        archiveWarm /= WARM_PASSES;
+
+        std::cout << "Files: " << paths.size() << ", bytes: " << totalBytes << "\n";
+        std::cout << "Loose files cold: " << looseCold << " ms, warm: " << looseWarm << " ms\n";
+        std::cout << "Archive map: " << mapTime << " ms, cold: " << archiveCold << " ms, warm: " << archiveWarm << " ms\n";
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
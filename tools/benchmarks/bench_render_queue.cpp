@@ -0,0 +1,126 @@
+// Measures how the render queue ordering affects the number of program binds
+// and state changes on a synthetic scene of static meshes.
+
+#include <iostream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/Utils.h>
+#include <df3d/engine/render/RenderQueue.h>
+#include <df3d/engine/render/Material.h>
+#include <df3d/engine/resources/GpuProgramResource.h>
+
+using namespace df3d;
+
+static const size_t MESHES_COUNT = 10000;
+static const size_t PROGRAMS_COUNT = 8;
+static const size_t MATERIALS_COUNT = 64;
+
+struct BindCounters
+{
+    size_t programBinds = 0;
+    size_t stateChanges = 0;
+    size_t textureSetChanges = 0;
+};
+
+// Mimics the redundancy checks done by RenderManager::bindPass and the backend.
+static BindCounters CountBinds(const std::vector<RenderOperation> &ops)
+{
+    BindCounters result;
+
+    const GpuProgramResource *currProgram = nullptr;
+    uint64_t currState = 0;
+    uint32_t currTextures = 0;
+    bool first = true;
+
+    for (const auto &op : ops)
+    {
+        const auto pass = op.passProps;
+
+        if (first || pass->program != currProgram)
+            result.programBinds++;
+        if (first || pass->state != currState)
+            result.stateChanges++;
+        if (first || pass->getTexturesKey() != currTextures)
+            result.textureSetChanges++;
+
+        currProgram = pass->program;
+        currState = pass->state;
+        currTextures = pass->getTexturesKey();
+        first = false;
+    }
+
+    return result;
+}
+
+static void PrintCounters(const char *title, const BindCounters &counters)
+{
+    std::cout << title << ": program binds " << counters.programBinds
+        << ", state changes " << counters.stateChanges
+        << ", texture set changes " << counters.textureSetChanges << "\n";
+}
+
+int main(int argc, const char **argv)
+{
+    MemoryManager::init();
+    RandomUtils::srand(42);
+
+    {
+        auto &alloc = MemoryManager::allocDefault();
+
+        std::vector<unique_ptr<GpuProgramResource>> programs;
+        for (size_t i = 0; i < PROGRAMS_COUNT; i++)
+        {
+            programs.push_back(make_unique<GpuProgramResource>(alloc));
+            programs.back()->handle = GPUProgramHandle(i + 1, 1);
+        }
+
+        std::vector<RenderPass> materials(MATERIALS_COUNT);
+        for (size_t i = 0; i < MATERIALS_COUNT; i++)
+        {
+            auto &pass = materials[i];
+            pass.program = programs[i % PROGRAMS_COUNT].get();
+            pass.setBackFaceCullingEnabled((i / PROGRAMS_COUNT) % 2 == 0);
+            pass.setParam(Id("diffuseMap"), TextureHandle(i / 2 + 1, 1));
+        }
+
+        RenderQueue queue;
+        auto &ops = queue.rops[RQ_BUCKET_NOT_LIT];
+
+        for (size_t i = 0; i < MESHES_COUNT; i++)
+        {
+            RenderOperation op;
+            op.passProps = &materials[RandomUtils::randRange(0, (int)MATERIALS_COUNT - 1)];
+            op.vertexBuffer = VertexBufferHandle(1, 1);
+            op.numberOfElements = 36;
+            op.worldTransform[3] = glm::vec4(RandomUtils::randRange(-500.0f, 500.0f),
+                                             RandomUtils::randRange(-10.0f, 10.0f),
+                                             RandomUtils::randRange(-500.0f, 500.0f), 1.0f);
+            ops.push_back(op);
+        }
+
+        std::cout << "Meshes: " << MESHES_COUNT << ", programs: " << PROGRAMS_COUNT << ", materials: " << MATERIALS_COUNT << "\n";
+
+        PrintCounters("Submission order", CountBinds(ops));
+
+        const auto original = ops;
+        const int iterations = 100;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++)
+        {
+            ops = original;
+            queue.sort(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        PrintCounters("Sorted order", CountBinds(ops));
+
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        std::cout << "Sort time: " << (us / (float)iterations) << " us per frame\n";
+    }
+
+    MemoryManager::shutdown();
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Runs the full RenderManager frame on the headless recording backend for a synthetic
+// world and reports CPU timings of the frame stages and submitted command counts.
+
+#include <iostream>
+#include <chrono>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/3d/Camera.h>
+#include <df3d/engine/3d/SceneGraphComponentProcessor.h>
+#include <df3d/engine/render/RenderManager.h>
+#include <df3d/engine/render/RenderOperation.h>
+#include <df3d/engine/render/RenderQueue.h>
+#include <df3d/engine/render/Material.h>
+#include <df3d/engine/render/null/RenderBackendNull.h>
+#include <df3d/engine/resources/GpuProgramResource.h>
+#include <df3d/game/World.h>
+#include <df3d/game/EntityComponentProcessor.h>
+#include <df3d/lib/math/BoundingSphere.h>
+#include <df3d/lib/math/Frustum.h>
+#include <df3d/lib/Utils.h>
+
+namespace df3d {
+
+extern bool EngineInit(EngineInitParams params);
+extern void EngineShutdown();
+
+}
+
+using namespace df3d;
+
+static const size_t ENTITIES_COUNT = 20000;
+static const size_t MATERIALS_COUNT = 32;
+static const int FRAMES_COUNT = 200;
+
+static const char *INSTANCED_VERT =
+    "attribute vec3 a_vertex3;\n"
+    "attribute mat4 a_instanceWorld;\n"
+    "uniform mat4 u_worldViewProjectionMatrix;\n"
+    "void main() { gl_Position = u_worldViewProjectionMatrix * a_instanceWorld * vec4(a_vertex3, 1.0); }\n";
+
+static const char *INSTANCED_FRAG =
+    "uniform LOWP vec4 material_diffuse;\n"
+    "void main() { gl_FragColor = material_diffuse; }\n";
+
+// Static boxes scattered around the camera, roughly what StaticMeshComponentProcessor does.
+class SyntheticMeshesProcessor : public EntityComponentProcessor
+{
+    World &m_world;
+    std::vector<Entity> m_entities;
+    std::vector<size_t> m_materialIdx;
+    std::vector<RenderPass> m_passes;
+
+    GpuProgramResource *m_instancedProgram = nullptr;
+    VertexBufferHandle m_vb;
+    IndexBufferHandle m_ib;
+
+    void update() override { }
+
+    void draw(RenderQueue *ops) override
+    {
+        const auto &frustum = m_world.getCamera()->getFrustum();
+        auto &sceneGraph = m_world.sceneGraph();
+
+        for (size_t i = 0; i < m_entities.size(); i++)
+        {
+            auto transform = sceneGraph.getWorldTransformMatrix(m_entities[i]);
+
+            BoundingSphere sphere;
+            sphere.setPosition(glm::vec3(transform[3]));
+            sphere.setRadius(1.0f);
+            if (!frustum.sphereInFrustum(sphere))
+                continue;
+
+            RenderOperation op;
+            op.vertexBuffer = m_vb;
+            op.indexBuffer = m_ib;
+            op.numberOfElements = 36;
+            op.worldTransform = transform;
+            op.passProps = &m_passes[m_materialIdx[i]];
+
+            ops->rops[RQ_BUCKET_NOT_LIT].push_back(op);
+        }
+    }
+
+public:
+    SyntheticMeshesProcessor(World &world)
+        : m_world(world)
+    {
+        auto &backend = svc().renderManager().getBackend();
+        const auto &embedResources = svc().renderManager().getEmbedResources();
+
+        VertexFormat format({ VertexFormat::POSITION, VertexFormat::TX, VertexFormat::COLOR });
+        m_vb = backend.createStaticVertexBuffer(format, 24, nullptr);
+        m_ib = backend.createIndexBuffer(36, nullptr, INDICES_16_BIT);
+
+        m_instancedProgram = CreateGPUProgramFromData(INSTANCED_VERT, INSTANCED_FRAG,
+        {
+            "u_worldViewProjectionMatrix",
+            "material_diffuse"
+        }, MemoryManager::allocDefault(), {}, {});
+
+        m_passes.resize(MATERIALS_COUNT);
+        for (size_t i = 0; i < MATERIALS_COUNT; i++)
+        {
+            auto &pass = m_passes[i];
+            if (i % 2 == 0)
+            {
+                pass.program = embedResources.coloredProgram;
+                pass.setParam(Id("diffuseMap"), embedResources.whiteTexture);
+            }
+            else
+            {
+                pass.program = m_instancedProgram;
+            }
+            pass.setBackFaceCullingEnabled((i / 2) % 2 == 0);
+            pass.setParam(Id("material_diffuse"), glm::vec4(i / (float)MATERIALS_COUNT, 1.0f, 1.0f, 1.0f));
+        }
+    }
+
+    ~SyntheticMeshesProcessor()
+    {
+        auto &backend = svc().renderManager().getBackend();
+        backend.destroyVertexBuffer(m_vb);
+        backend.destroyIndexBuffer(m_ib);
+        backend.destroyGPUProgram(m_instancedProgram->handle);
+        MAKE_DELETE(MemoryManager::allocDefault(), m_instancedProgram);
+    }
+
+    void add(Entity e, size_t materialIdx)
+    {
+        m_entities.push_back(e);
+        m_materialIdx.push_back(materialIdx);
+    }
+
+    void remove(Entity e) override { }
+    bool has(Entity e) override { return false; }
+};
+
+int main(int argc, const char **argv)
+{
+    MemoryManager::init();
+    RandomUtils::srand(42);
+
+    EngineInitParams params;
+    params.headlessRender = true;
+
+    if (!EngineInit(params))
+        return 1;
+
+    {
+        svc().replaceWorld();
+
+        auto &world = svc().world();
+        world.getCamera()->setPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+
+        world.addUserComponentProcessor(make_unique<SyntheticMeshesProcessor>(world));
+        auto &meshes = world.getProcessor<SyntheticMeshesProcessor>();
+
+        for (size_t i = 0; i < ENTITIES_COUNT; i++)
+        {
+            auto e = world.spawn();
+            world.sceneGraph().setPosition(e, glm::vec3(RandomUtils::randRange(-200.0f, 200.0f),
+                                                        RandomUtils::randRange(-50.0f, 50.0f),
+                                                        RandomUtils::randRange(-400.0f, -1.0f)));
+            meshes.add(e, RandomUtils::randRange(0, (int)MATERIALS_COUNT - 1));
+        }
+
+        auto &backend = static_cast<RenderBackendNull&>(svc().renderManager().getBackend());
+
+        float collectTime = 0.0f, sortTime = 0.0f;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < FRAMES_COUNT; i++)
+        {
+            svc().step();
+
+            auto stats = svc().renderManager().getFrameStats();
+            collectTime += stats.collectTimeMs;
+            sortTime += stats.sortTimeMs;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+
+        auto frameTime = std::chrono::duration<float, std::milli>(end - start).count() / FRAMES_COUNT;
+        auto stats = svc().renderManager().getFrameStats();
+
+        std::cout << "Entities: " << ENTITIES_COUNT << ", materials: " << MATERIALS_COUNT << ", frames: " << FRAMES_COUNT << "\n";
+        std::cout << "Frame time: " << frameTime << " ms\n";
+        std::cout << "Collect time: " << collectTime / FRAMES_COUNT << " ms\n";
+        std::cout << "Sort time: " << sortTime / FRAMES_COUNT << " ms\n";
+        std::cout << "Draw calls: " << stats.drawCalls << ", triangles: " << stats.totalTriangles << "\n";
+
+        std::cout << "Commands per frame (" << backend.getCommands().size() << " total):\n";
+        for (size_t i = 0; i < (size_t)RecordedCommandType::COUNT; i++)
+        {
+            auto type = (RecordedCommandType)i;
+            if (auto count = backend.getCommandsCount(type))
+                std::cout << "    " << RenderBackendNull::GetCommandName(type) << ": " << count << "\n";
+        }
+
+        svc().deleteWorld();
+    }
+
+    EngineShutdown();
+    MemoryManager::shutdown();
+
+    return 0;
+}
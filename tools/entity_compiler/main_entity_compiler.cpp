@@ -0,0 +1,63 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/engine/io/FileSystemHelpers.h>
+#include <df3d/game/impl/EntityLoader.h>
+#include <df3d/lib/JsonUtils.h>
+
+// Compiles .entity and .world json into the binary format EntityHolder loads, see DFEntityHeader.
+// Keep the extension of the output, it's used to pick the resource type.
+
+int main(int argc, const char **argv) try
+{
+    if (argc != 3)
+        throw std::runtime_error("Invalid input. Usage: entity_compiler.exe input.entity|input.world output");
+
+    df3d::MemoryManager::init();
+
+    std::string inputFilename = argv[1];
+    std::string outputFilename = argv[2];
+
+    bool isWorld = df3d::FileSystemHelpers::compareExtension(inputFilename.c_str(), ".world");
+    if (!isWorld && !df3d::FileSystemHelpers::compareExtension(inputFilename.c_str(), ".entity"))
+        throw std::runtime_error("input should be an .entity or a .world file");
+
+    std::ifstream input(inputFilename);
+    if (!input)
+        throw std::runtime_error("failed to open " + inputFilename);
+
+    auto root = df3d::JsonUtils::fromString(std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()));
+    if (root.isNull())
+        throw std::runtime_error("failed to parse " + inputFilename);
+
+    std::vector<uint8_t> compiled;
+    {
+        df3d::game_impl::EntityLoader loader;
+        if (!loader.compileEntity(root, isWorld, compiled))
+            throw std::runtime_error("failed to compile " + inputFilename);
+    }
+
+    std::ofstream output(outputFilename, std::ios::out | std::ios::binary);
+    if (!output)
+        throw std::runtime_error("failed to open output file");
+
+    output.write(reinterpret_cast<const char *>(compiled.data()), compiled.size());
+    if (!output)
+        throw std::runtime_error("failed to write to an output");
+
+    std::cout << "Compiled " << inputFilename << " to " << outputFilename << ", " << compiled.size() << " bytes\n";
+
+    df3d::MemoryManager::shutdown();
+
+    return 0;
+}
+catch (std::exception &e)
+{
+    std::cerr << "An error occurred:\n" << e.what() << "\n";
+
+    return 1;
+}
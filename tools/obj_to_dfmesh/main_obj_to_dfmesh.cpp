@@ -7,10 +7,12 @@
 #include <df3d/df3d.h>
 #include <df3d/engine/resources/loaders/MeshLoader_obj.h>
 #include <df3d/engine/resources/loaders/MeshLoader_dfmesh.h>
+#include <df3d/engine/resources/MeshResource.h>
+#include <df3d/lib/JobSystem.h>
 
-static_assert(sizeof(typename std::string::value_type) == 1, "Invalid string size");
+#include <btBulletCollisionCommon.h>
 
-static const int INDICES_SIZE = sizeof(uint16_t);
+static_assert(sizeof(typename std::string::value_type) == 1, "Invalid string size");
 
 template<typename T>
 void Serialize(const T &data, std::ofstream &fs)
@@ -31,6 +33,18 @@ void Serialize(const void *data, size_t size, std::ofstream &fs)
         throw std::runtime_error("failed to write to an output");
 }
 
+uint32_t AlignSize(uint32_t size)
+{
+    return (size + df3d::DFMESH_CHUNK_ALIGNMENT - 1) / df3d::DFMESH_CHUNK_ALIGNMENT * df3d::DFMESH_CHUNK_ALIGNMENT;
+}
+
+void Pad(size_t count, std::ofstream &fs)
+{
+    static const char zeros[df3d::DFMESH_CHUNK_ALIGNMENT] = { 0 };
+
+    Serialize(zeros, count, fs);
+}
+
 df3d::DFMeshSubmeshHeader CreateMeshPartHeader(const df3d::MeshResourceData::Part &sm)
 {
     if (sm.materialName.size() >= df3d::DFMESH_MAX_MATERIAL_ID)
@@ -41,31 +55,109 @@ df3d::DFMeshSubmeshHeader CreateMeshPartHeader(const df3d::MeshResourceData::Par
 
     memcpy(submeshChunk.materialId, sm.materialName.c_str(), sm.materialName.size());
 
+    submeshChunk.indexSize = sm.getIndexSize();
     submeshChunk.vertexDataSizeInBytes = sm.vertexData.getSizeInBytes();
-    submeshChunk.indexDataSizeInBytes = sm.indexData.size() * INDICES_SIZE;
+    submeshChunk.indexDataSizeInBytes = sm.getIndicesCount() * submeshChunk.indexSize;
 
     submeshChunk.chunkSize =
         sizeof(df3d::DFMeshSubmeshHeader) +
         submeshChunk.vertexDataSizeInBytes +
         submeshChunk.indexDataSizeInBytes;
+    submeshChunk.chunkSize = AlignSize(submeshChunk.chunkSize);
 
     return submeshChunk;
 }
 
+void WriteDataChunk(df3d::DFMeshDataChunkType type, const void *prefix, size_t prefixSize, const void *data, size_t size, std::ofstream &fs)
+{
+    df3d::DFMeshDataChunk chunk;
+    memset(&chunk, 0, sizeof(chunk));
+
+    chunk.type = type;
+    chunk.dataSizeInBytes = prefixSize + size;
+    chunk.chunkSize = AlignSize(sizeof(chunk) + chunk.dataSizeInBytes);
+
+    Serialize(chunk, fs);
+    Serialize(prefix, prefixSize, fs);
+    Serialize(data, size, fs);
+    Pad(chunk.chunkSize - sizeof(chunk) - chunk.dataSizeInBytes, fs);
+}
+
+void WriteDataChunk(df3d::DFMeshDataChunkType type, const void *data, size_t size, std::ofstream &fs)
+{
+    WriteDataChunk(type, nullptr, 0, data, size, fs);
+}
+
+// Bounds, convex hull and collision BVH, so these are not computed on load.
+void WritePrecomputedData(const df3d::MeshResourceData &meshInput, std::ofstream &fs)
+{
+    auto &alloc = df3d::MemoryManager::allocDefault();
+
+    df3d::MeshCollisionData collision;
+    df3d::AABB aabb;
+    df3d::BoundingSphere sphere;
+    df3d::ProcessMeshGeometry(meshInput, collision, aabb, sphere);
+
+    if (aabb.isValid())
+    {
+        glm::vec3 bounds[2] = { aabb.minPoint(), aabb.maxPoint() };
+        WriteDataChunk(df3d::DFMESH_CHUNK_AABB, bounds, sizeof(bounds), fs);
+    }
+
+    if (sphere.isValid())
+    {
+        glm::vec4 data(sphere.getCenter(), sphere.getRadius());
+        WriteDataChunk(df3d::DFMESH_CHUNK_BOUNDING_SPHERE, &data, sizeof(data), fs);
+    }
+
+    df3d::ConvexHull hull;
+    hull.constructFromPoints(collision.positions.data(), collision.positions.size(), alloc);
+    if (!hull.m_vertices.empty())
+    {
+        std::vector<glm::vec3> points;
+        for (const auto &v : hull.m_vertices)
+            points.push_back({ v.x(), v.y(), v.z() });
+
+        WriteDataChunk(df3d::DFMESH_CHUNK_CONVEX_HULL, points.data(), points.size() * sizeof(glm::vec3), fs);
+    }
+
+    if (!collision.indices.empty())
+    {
+        // Same triangles and quantization as STATIC_MESH physics shapes use.
+        auto meshInterface = collision.createMeshInterface(alloc);
+        auto shape = MAKE_NEW(alloc, btBvhTriangleMeshShape)(meshInterface, true);
+        auto bvh = shape->getOptimizedBvh();
+
+        auto size = bvh->calculateSerializeBufferSize();
+        auto buffer = alloc.alloc(size, df3d::MeshResourceData::BVH_DATA_ALIGNMENT);
+        if (!bvh->serializeInPlace(buffer, size, false))
+            throw std::runtime_error("failed to serialize BVH");
+
+        uint32_t bvhSize = sizeof(btQuantizedBvh);
+        WriteDataChunk(df3d::DFMESH_CHUNK_BVH, &bvhSize, sizeof(bvhSize), buffer, size, fs);
+
+        alloc.dealloc(buffer);
+        MAKE_DELETE(alloc, shape);
+        MAKE_DELETE(alloc, meshInterface);
+    }
+}
+
 void ProcessMesh(const df3d::MeshResourceData &meshInput, const std::string &outputFilename)
 {
     if (meshInput.parts.size() > 0xFFFF)
         throw std::runtime_error("too many mesh parts");
 
-    // Prepare submeshes headers.
+    // Prepare submeshes headers. Each keeps its own index size.
     std::vector<df3d::DFMeshSubmeshHeader> submeshHeaders(meshInput.parts.size());
 
     size_t submeshChunksSize = 0;
+    uint32_t maxIndexSize = sizeof(uint16_t);
     for (size_t i = 0; i < meshInput.parts.size(); i++)
     {
         submeshHeaders[i] = CreateMeshPartHeader(*meshInput.parts[i]);
 
         submeshChunksSize += submeshHeaders[i].chunkSize;
+        maxIndexSize = std::max(maxIndexSize, submeshHeaders[i].indexSize);
     }
 
     std::ofstream output(outputFilename, std::ios::out | std::ios::binary);
@@ -78,21 +170,27 @@ void ProcessMesh(const df3d::MeshResourceData &meshInput, const std::string &out
     header.magic = *((uint32_t*)df3d::DFMESH_MAGIC);
     header.version = df3d::DFMESH_VERSION;
     header.vertexFormat = 0;    // TODO
-    header.indexSize = INDICES_SIZE;
+    header.indexSize = maxIndexSize;
     header.submeshesCount = (uint16_t)meshInput.parts.size();
-    header.submeshesOffset = sizeof(header);
+    header.submeshesOffset = AlignSize(sizeof(header));
 
     // Write the header.
     Serialize(header, output);
+    Pad(header.submeshesOffset - sizeof(header), output);
 
     // Write submeshes.
     for (size_t i = 0; i < meshInput.parts.size(); i++)
     {
-        Serialize(submeshHeaders[i], output);
-        Serialize(meshInput.parts[i]->vertexData.getRawData(), submeshHeaders[i].vertexDataSizeInBytes, output);
-        Serialize(meshInput.parts[i]->indexData.data(), submeshHeaders[i].indexDataSizeInBytes, output);
+        const auto &smHeader = submeshHeaders[i];
+
+        Serialize(smHeader, output);
+        Serialize(meshInput.parts[i]->vertexData.getRawData(), smHeader.vertexDataSizeInBytes, output);
+        Serialize(meshInput.parts[i]->getIndices(), smHeader.indexDataSizeInBytes, output);
+        Pad(smHeader.chunkSize - sizeof(smHeader) - smHeader.vertexDataSizeInBytes - smHeader.indexDataSizeInBytes, output);
     }
 
+    WritePrecomputedData(meshInput, output);
+
     if (output.fail() || output.bad())
         throw std::runtime_error("failed to write to an output");
 
@@ -118,23 +216,20 @@ int main(int argc, const char **argv) try
     if (!file)
         throw std::runtime_error("Failed to open input file");
 
-    auto meshInput = MeshLoader_obj(*file, alloc);
+    df3d::JobSystem jobs(df3d::JobSystem::GetDefaultWorkersCount());
+    auto meshInput = MeshLoader_obj(*file, alloc, &jobs);
     if (!meshInput)
         throw std::runtime_error("Failed to load input obj mesh");
 
     fs->close(file);
 
-    // Support only 16-bit vertices for now. Some hardware doesn't work with 32 bit (Mali 400)
-
+    // Some hardware doesn't work with 32-bit indices (Mali 400).
     for (auto part : meshInput->parts)
     {
-        if (part->vertexData.getVerticesCount() >= 0xFFFF)
+        if (part->indicesType == df3d::INDICES_32_BIT)
         {
-            std::ostringstream errMsg;
-            errMsg << "To much vertices: " << part->vertexData.getVerticesCount()
-                << ". File: " << inputFileName;
-
-            throw std::runtime_error(errMsg.str());
+            std::cout << "Warning: part '" << part->materialName << "' has " << part->vertexData.getVerticesCount()
+                << " vertices, it is written with 32-bit indices\n";
         }
     }
 
@@ -0,0 +1,226 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+
+#include <df3d/engine/EngineController.h>
+#include <df3d/lib/Utils.h>
+#include <df3d/engine/resources/PackedArchiveFileSystem.h>
+
+// Packs resources into an archive for CreatePackedArchiveFileSystem.
+// Paths are stored as given, so run it from the directory the game opens resources from.
+
+//! Compressed entries should save at least this much, otherwise they are stored as is.
+static const float MIN_COMPRESSION_GAIN = 0.1f;
+
+struct InputEntry
+{
+    std::string path;
+    df3d::PackedArchiveEntry entry;
+    std::vector<uint8_t> data;
+};
+
+template<typename T>
+void Serialize(const T &data, std::ofstream &fs)
+{
+    fs.write(reinterpret_cast<const char *>(&data), sizeof(data));
+
+    if (!fs)
+        throw std::runtime_error("failed to write to an output");
+}
+
+void Serialize(const void *data, size_t size, std::ofstream &fs)
+{
+    if (size == 0)
+        return;
+    fs.write(reinterpret_cast<const char *>(data), size);
+
+    if (!fs)
+        throw std::runtime_error("failed to write to an output");
+}
+
+void Pad(std::ofstream &fs, uint64_t &offset, uint32_t alignment)
+{
+    static const char zeros[16] = { 0 };
+
+    while (offset % alignment)
+    {
+        auto count = std::min<uint64_t>(alignment - offset % alignment, sizeof(zeros));
+        Serialize(zeros, (size_t)count, fs);
+        offset += count;
+    }
+}
+
+std::vector<uint8_t> ReadFile(const std::string &path)
+{
+    std::ifstream input(path, std::ios::in | std::ios::binary);
+    if (!input)
+        throw std::runtime_error("failed to open " + path);
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+void ReadList(const std::string &listPath, std::vector<std::string> &paths)
+{
+    std::ifstream input(listPath);
+    if (!input)
+        throw std::runtime_error("failed to open " + listPath);
+
+    std::string line;
+    while (std::getline(input, line))
+    {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+            line.pop_back();
+        if (!line.empty())
+            paths.push_back(line);
+    }
+}
+
+void ProcessArchive(const std::vector<std::string> &paths, const std::string &outputFilename, bool compress)
+{
+    std::vector<InputEntry> inputs(paths.size());
+
+    size_t pathsSize = 0;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        auto &input = inputs[i];
+
+        input.path = paths[i];
+        std::replace(input.path.begin(), input.path.end(), '\\', '/');
+
+        input.data = ReadFile(paths[i]);
+        if (input.data.size() > 0xFFFFFFFF)
+            throw std::runtime_error("file is too big: " + paths[i]);
+
+        memset(&input.entry, 0, sizeof(input.entry));
+        input.entry.pathHash = df3d::Id(input.path.c_str()).m_id;
+        input.entry.pathOffset = (uint32_t)pathsSize;
+        input.entry.size = (uint32_t)input.data.size();
+        input.entry.compression = df3d::PACKED_ARCHIVE_COMPRESSION_NONE;
+
+        if (compress && !input.data.empty())
+        {
+            auto compressed = df3d::utils::zlibCompress(input.data);
+            if (!compressed.empty() && compressed.size() < input.data.size() * (1.0f - MIN_COMPRESSION_GAIN))
+            {
+                input.data = std::move(compressed);
+                input.entry.compression = df3d::PACKED_ARCHIVE_COMPRESSION_ZLIB;
+            }
+        }
+
+        input.entry.packedSize = (uint32_t)input.data.size();
+
+        pathsSize += input.path.size() + 1;
+    }
+
+    std::sort(inputs.begin(), inputs.end(), [](const InputEntry &a, const InputEntry &b) {
+        if (a.entry.pathHash != b.entry.pathHash)
+            return a.entry.pathHash < b.entry.pathHash;
+        return a.path < b.path;
+    });
+
+    for (size_t i = 1; i < inputs.size(); i++)
+    {
+        if (inputs[i].path == inputs[i - 1].path)
+            throw std::runtime_error("duplicate path " + inputs[i].path);
+    }
+
+    std::ofstream output(outputFilename, std::ios::out | std::ios::binary);
+    if (!output)
+        throw std::runtime_error("failed to open output file");
+
+    df3d::PackedArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+
+    header.magic = *((uint32_t*)df3d::PACKED_ARCHIVE_MAGIC);
+    header.version = df3d::PACKED_ARCHIVE_VERSION;
+    header.entriesCount = (uint32_t)inputs.size();
+
+    // Write the header, it's rewritten when the offsets are known.
+    uint64_t offset = 0;
+    Serialize(header, output);
+    offset += sizeof(header);
+
+    // Write entries data.
+    for (auto &input : inputs)
+    {
+        Pad(output, offset, df3d::PACKED_ARCHIVE_DATA_ALIGNMENT);
+
+        input.entry.dataOffset = offset;
+        Serialize(input.data.data(), input.data.size(), output);
+        offset += input.data.size();
+    }
+
+    // Write entries table.
+    Pad(output, offset, df3d::PACKED_ARCHIVE_DATA_ALIGNMENT);
+    header.entriesOffset = offset;
+    for (const auto &input : inputs)
+        Serialize(input.entry, output);
+    offset += inputs.size() * sizeof(df3d::PackedArchiveEntry);
+
+    // Write paths table in the original order.
+    header.pathsOffset = offset;
+    std::vector<const InputEntry*> byPathOffset;
+    for (const auto &input : inputs)
+        byPathOffset.push_back(&input);
+    std::sort(byPathOffset.begin(), byPathOffset.end(), [](const InputEntry *a, const InputEntry *b) {
+        return a->entry.pathOffset < b->entry.pathOffset;
+    });
+    for (auto input : byPathOffset)
+        Serialize(input->path.c_str(), input->path.size() + 1, output);
+
+    output.seekp(0);
+    Serialize(header, output);
+
+    if (output.fail() || output.bad())
+        throw std::runtime_error("failed to write to an output");
+
+    output.close();
+}
+
+int main(int argc, const char **argv) try
+{
+    if (argc < 3)
+        throw std::runtime_error("Invalid input. Usage: res_packer.exe [-z] output.pak file1 [file2 ...] [@list.txt]");
+
+    df3d::MemoryManager::init();
+
+    bool compress = false;
+    int argIdx = 1;
+    if (std::string(argv[argIdx]) == "-z")
+    {
+        compress = true;
+        argIdx++;
+    }
+
+    if (argIdx >= argc)
+        throw std::runtime_error("output file is not specified");
+
+    std::string outputFilename = argv[argIdx++];
+
+    std::vector<std::string> paths;
+    for (; argIdx < argc; argIdx++)
+    {
+        std::string arg = argv[argIdx];
+        if (!arg.empty() && arg[0] == '@')
+            ReadList(arg.substr(1), paths);
+        else
+            paths.push_back(arg);
+    }
+
+    ProcessArchive(paths, outputFilename, compress);
+
+    std::cout << "Packed " << paths.size() << " files to " << outputFilename << "\n";
+
+    df3d::MemoryManager::shutdown();
+
+    return 0;
+}
+catch (std::exception &e)
+{
+    std::cerr << "An error occurred:\n" << e.what() << "\n";
+
+    return 1;
+}